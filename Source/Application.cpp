@@ -9,10 +9,16 @@
 #include "Render.h"
 #include "Defs.h"
 #include "Log.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "Counters.h"
 
 #include "SDL/include/SDL.h"
 #include "optick-1.3.0.0/include/optick.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #ifdef DEBUG
 #ifdef PLATFORMx86
 #pragma comment( lib, "optick-1.3.0.0/x86/DebugData/OptickCore.lib" )
@@ -62,10 +68,32 @@ bool Application::Init()
 
 		if (!config_loaded) files.SaveConfig();
 
+		// Match recording and headless replay, before any SDL subsystem starts
+		for (int i = 1; i + 1 < argc && ret; ++i)
+		{
+			if (strcmp(args[i], "--record") == 0)
+				ret = commands.StartRecording(args[++i]);
+			else if (strcmp(args[i], "--replay") == 0)
+				ret = commands.StartReplay(args[++i]);
+			else if (strcmp(args[i], "--benchmark") == 0)
+				ret = commands.StartBenchmark(float(atof(args[++i])));
+			else if (strcmp(args[i], "--scenario") == 0)
+				ret = commands.SetScenario(args[++i]);
+			else if (strcmp(args[i], "--memory") == 0)
+				ret = MemoryTracker::SetMode(args[++i]);
+			else if (strcmp(args[i], "--unit-pool") == 0)
+				ret = unitPool.SetMode(args[++i]);
+			else if (strcmp(args[i], "--profile") == 0)
+				profiler.SetExportOnExit(args[++i]);
+			else if (strcmp(args[i], "--counters") == 0)
+				Counters::SetDumpFile(args[++i]);
+		}
+
 		// Pre-Initialize Independent Manager Systems
 		if (ret) ret = time.Init();
 		if (ret) ret = tex.Init();
 		if (ret) ret = fonts.Init();
+		if (ret) ret = jobs.Init();
 		
 		// Initialize Modules
 		for (std::list<Module*>::iterator it = modules.begin(); it != modules.end() && ret; ++it)
@@ -92,9 +120,10 @@ bool Application::Init()
 		if (ret)
 		{
 			state = STOPED;
-			time.SetMaxFPS(60);
+			time.SetMaxFPS(commands.IsHeadless() ? 0.f : 60.f);
 
-			Event::Push(SCENE_CHANGE, scene, INTRO, 0.f);
+			// Replays and benchmarks start straight into the match
+			Event::Push(SCENE_CHANGE, scene, commands.IsHeadless() ? MAIN : INTRO, 0.f);
 			Event::PumpAll();
 			Event::Push(SCENE_PLAY, this);
 		}
@@ -110,7 +139,7 @@ int Application::Update()
 {
 	OPTICK_FRAME("MainThread");
 
-	if (want_to_quit)
+	if (want_to_quit || commands.ReplayFinished())
 	{
 		SaveConfig();
 		return 0; // closing app
@@ -121,34 +150,119 @@ int Application::Update()
 	static std::list<Module*>::iterator it;
 	static bool no_error = true;
 
-	fogWar.Update();//Pre update
+	// Replayed orders for this frame, before anything reads them
+	commands.Update();
+
+	// Replays time every system, summed over its phases
+	unsigned long long timing = SDL_GetPerformanceCounter();
+
+	{
+		PROFILE_SCOPE("Managers");
+		spatial.Update();
+		timing = commands.AddTiming("Spatial", timing);
+		avoidance.Update();
+		timing = commands.AddTiming("Avoidance", timing);
+		groupMove.Update();
+		timing = commands.AddTiming("Group Movement", timing);
+		fogWar.Update();//Pre update
+		timing = commands.AddTiming("Fog of War", timing);
+	}
 
 	OPTICK_CATEGORY("PreUpdate Application", Optick::Category::GameLogic);
-	for (it = modules.begin(); it != modules.end() && no_error; ++it)
-		if (!(no_error = (*it)->PreUpdate()))
-			LOG("Module %s encuntered an error during PreUpdate!", (*it)->GetName());
+	{
+		PROFILE_SCOPE("PreUpdate");
+		for (it = modules.begin(); it != modules.end() && no_error; ++it)
+		{
+			if (!(no_error = (*it)->PreUpdate()))
+				LOG("Module %s encuntered an error during PreUpdate!", (*it)->GetName());
+
+			timing = commands.AddTiming((*it)->GetName(), timing);
+		}
+	}
 
 	OPTICK_CATEGORY("Update Application", Optick::Category::GameLogic);
-	for (it = modules.begin(); it != modules.end() && no_error; ++it)
-		if (!(no_error = (*it)->Update()))
-			LOG("Module %s encuntered an error during Update!", (*it)->GetName());
+	{
+		PROFILE_SCOPE("Update");
+		for (it = modules.begin(); it != modules.end() && no_error; ++it)
+		{
+			if (!(no_error = (*it)->Update()))
+				LOG("Module %s encuntered an error during Update!", (*it)->GetName());
 
-	particleSys.Update();
-	collSystem.Update();
+			timing = commands.AddTiming((*it)->GetName(), timing);
+		}
+	}
+
+	if (time.IsFixedTimestep())
+	{
+		// Simulation advances in fixed ticks, rendering interpolates between the last two
+		OPTICK_CATEGORY("FixedUpdate Application", Optick::Category::GameLogic);
+		unsigned int ticks = time.BeginSimulation();
+		for (unsigned int tick = 0u; tick < ticks && no_error; ++tick)
+		{
+			// Re-bucket units moved by the previous tick
+			if (tick > 0u)
+			{
+				spatial.Update();
+				avoidance.Update();
+			}
+
+			for (it = modules.begin(); it != modules.end() && no_error; ++it)
+				if (!(no_error = (*it)->FixedUpdate()))
+					LOG("Module %s encuntered an error during FixedUpdate!", (*it)->GetName());
+
+			UpdateSimulation();
+		}
+		time.EndSimulation();
+		commands.EndSimulation(ticks);
+	}
+	else
+		UpdateSimulation();
+
+	timing = commands.AddTiming("Simulation", timing);
+
+	collSystem.DebugDraw();
+	profiler.DrawOverlay();
 
 	OPTICK_CATEGORY("PostUpdate Application", Optick::Category::GameLogic);
-	for (it = modules.begin(); it != modules.end() && no_error; ++it)
-		if (!(no_error = (*it)->PostUpdate()))
-			LOG("Module %s encuntered an error during PostUpdate!", (*it)->GetName());
+	{
+		PROFILE_SCOPE("PostUpdate");
+		for (it = modules.begin(); it != modules.end() && no_error; ++it)
+		{
+			if (!(no_error = (*it)->PostUpdate()))
+				LOG("Module %s encuntered an error during PostUpdate!", (*it)->GetName());
+
+			timing = commands.AddTiming((*it)->GetName(), timing);
+		}
+	}
 
 	if (!no_error)
 		return -1; // error
 
-	FinishUpdate();
+	{
+		PROFILE_SCOPE("FinishUpdate");
+		FinishUpdate();
+	}
+
+	// Every frame temporary dies here
+	frameArena.Reset();
+	MemoryTracker::EndFrame();
+	profiler.EndFrame();
+	Counters::EndFrame();
 
 	return 1; // continue
 }
 
+void Application::UpdateSimulation()
+{
+	PROFILE_SCOPE("Simulation");
+
+	// Staggered re-queries of the spatial index, results read next tick
+	targeting.Update();
+
+	collSystem.Update();
+	particleSys.Update();
+}
+
 void Application::PrepareUpdate()
 {
 	time.UpdateDeltaTime();
@@ -178,12 +292,24 @@ void Application::FinishUpdate()
 
 	int extra_ms = time.ManageFrameTimers();
 
-	if (extra_ms < 0) // uncapped fps
+	if (time.IsLockstep())
 	{
-		pathfinding.IteratePaths(1);
+		Timer timer;
 
-		while (Event::RemainingEvents() > 0)
-			Event::Pump();
+		// Every search and event of the frame resolves this frame, whatever the frame rate
+		unsigned long long timing = SDL_GetPerformanceCounter();
+		pathfinding.CompletePaths();
+		timing = commands.AddTiming("Pathfinding", timing);
+		Event::PumpAll();
+		commands.AddTiming("Events", timing);
+
+		if (extra_ms - timer.ReadI() > 0)
+			time.Delay(extra_ms - timer.Read());
+	}
+	else if (extra_ms < 0) // uncapped fps
+	{
+		pathfinding.IteratePaths(1);
+		Event::PumpAll();
 	}
 	else
 	{
@@ -192,9 +318,9 @@ void Application::FinishUpdate()
 		// Update pathfindnig
 		pathfinding.IteratePaths(extra_ms);
 
-		// Pump events in extra_ms timespan
-		while (extra_ms > timer.ReadI() && Event::RemainingEvents() > 0)
-			Event::Pump();
+		// Drain critical events, then pump the rest in extra_ms timespan
+		int remaining_ms = extra_ms - timer.ReadI();
+		Event::PumpFor(remaining_ms > 0 ? (unsigned int)remaining_ms : 0u);
 
 		// Delay capped FPS
 		if (extra_ms - timer.ReadI() > 0)
@@ -206,17 +332,37 @@ bool Application::CleanUp()
 {
 	bool ret = true;
 
+	// Writes the recording or prints the replay report
+	commands.End();
+
+	// Exports if asked to, overlay text goes before the textures
+	profiler.CleanUp();
+	Counters::CleanUp();
+
 	for (std::list<Module*>::reverse_iterator it = modules.rbegin(); it != modules.rend() && ret; ++it)
 		ret = (*it)->CleanUp();
 
 	if (ret)
 	{
+		Event::LogLatencyStats();
+
 		fogWar.CleanUp();
 		collSystem.Clear();
+		groupMove.CleanUp();
+		spatial.Clear();
+		avoidance.Clear();
 		particleSys.CleanUp();
 		tex.CleanUp();
+		jobs.CleanUp();
+		frameArena.CleanUp();
 
-		ret = (fonts.CleanUp() && files.CleanUp());
+		// Fonts close their RWops, PhysFS goes after the cache
+		ret = fonts.CleanUp();
+		if (ret)
+		{
+			assets.CleanUp();
+			ret = files.CleanUp();
+		}
 	}
 
 	return ret;
@@ -328,6 +474,7 @@ void Application::LoadAllConfig(bool empty_config)
 
 	// Call Managers
 	tex.LoadConfig(empty_config);
+	time.LoadConfig(empty_config);
 
 	// Call Modules
 	for (std::list<Module*>::iterator it = modules.begin(); it != modules.end(); ++it)
@@ -344,6 +491,7 @@ void Application::SaveConfig() const
 
 	// Call Managers
 	tex.SaveConfig();
+	time.SaveConfig();
 
 	// Call Modules
 	for (std::list<Module*>::const_iterator it = modules.begin(); it != modules.end(); ++it)
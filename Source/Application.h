@@ -5,6 +5,7 @@
 #include "Module.h"
 
 #include "FileManager.h"
+#include "AssetCache.h"
 #include "TextureManager.h"
 #include "TimeManager.h"
 #include "FontManager.h"
@@ -13,8 +14,17 @@
 #include "CollisionSystem.h"
 #include "DialogSystem.h"
 #include "ParticleSystem.h"
-
-#include "PugiXml\src\pugixml.hpp"
+#include "JobSystem.h"
+#include "SpatialIndex.h"
+#include "TargetingService.h"
+#include "GroupMovement.h"
+#include "LocalAvoidance.h"
+#include "CommandStream.h"
+#include "UnitPool.h"
+#include "FrameArena.h"
+#include "Profiler.h"
+
+#include "PugiXml/src/pugixml.hpp"
 #include <list>
 #include <string>
 
@@ -29,6 +39,7 @@ class Render;
 
 // Independent Managers
 class FileManager;
+class AssetCache;
 class TimeManager;
 class TextureManager;
 class FontManager;
@@ -37,6 +48,15 @@ class FogOfWarManager;
 class CollisionSystem;
 class DialogSystem;
 class ParticleSystem;
+class JobSystem;
+class SpatialIndex;
+class TargetingService;
+class GroupMovement;
+class LocalAvoidance;
+class CommandStream;
+class UnitPool;
+class FrameArena;
+class Profiler;
 
 enum GameState : int
 {
@@ -72,6 +92,7 @@ public:
 private:
 
 	void PrepareUpdate();
+	void UpdateSimulation();
 	void FinishUpdate();
 
 	void LoadAllConfig(bool empty_config);
@@ -89,6 +110,7 @@ public:
 
 	// Independent Managers
 	FileManager		files;
+	AssetCache		assets;
 	TimeManager		time;
 	TextureManager	tex;
 	FontManager		fonts;
@@ -97,6 +119,15 @@ public:
 	CollisionSystem collSystem;
 	DialogSystem   dialogSys;
 	ParticleSystem particleSys;
+	JobSystem		jobs;
+	SpatialIndex	spatial;
+	TargetingService targeting;
+	GroupMovement	groupMove;
+	LocalAvoidance	avoidance;
+	CommandStream	commands;
+	UnitPool		unitPool;
+	FrameArena		frameArena;
+	Profiler		profiler;
 
 private:
 
@@ -0,0 +1,427 @@
+#include "AssetCache.h"
+#include "Application.h"
+#include "Counters.h"
+#include "MemoryTracker.h"
+#include "Defs.h"
+#include "Log.h"
+
+#include "SDL/include/SDL_rwops.h"
+#include "SDL/include/SDL_timer.h"
+#include "SDL/include/SDL_error.h"
+#include "physfs-3.0.2/include/physfs.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static Counter* cold_count = Counters::Find("assets/cold loads");
+static Counter* warm_count = Counters::Find("assets/warm loads");
+static Counter* cached_count = Counters::Find("assets/cached KB", COUNTER_GAUGE);
+static Counter* mapped_count = Counters::Find("assets/mapped KB", COUNTER_GAUGE);
+
+static int close_asset_rwops(SDL_RWops* rw)
+{
+	App->assets.Release(rw->hidden.mem.base);
+	SDL_FreeRW(rw);
+	return 0;
+}
+
+AssetCache::AssetCache()
+{}
+
+AssetCache::~AssetCache()
+{
+	if (prefetcher.joinable() || !assets.empty())
+		CleanUp();
+}
+
+void AssetCache::CleanUp()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		prefetching = false;
+		prefetch_queue.clear();
+	}
+	prefetch_wake.notify_all();
+
+	if (prefetcher.joinable())
+		prefetcher.join();
+
+	unsigned int open = 0u;
+	for (std::map<std::string, Asset*>::iterator it = assets.begin(); it != assets.end(); ++it)
+	{
+		// Someone still reads from it: leak rather than pull the bytes away
+		if (it->second->pins > 0u)
+			open++;
+		else
+		{
+			Free(*it->second);
+			DEL(it->second);
+		}
+	}
+
+	if (open > 0u)
+		LOG("Asset cache: %u assets still open on clean up", open);
+
+	assets.clear();
+	by_data.clear();
+	lru.clear();
+	prefetch_lists.clear();
+	cached_bytes = mapped_bytes = 0u;
+}
+
+SDL_RWops* AssetCache::Open(const char* file)
+{
+	unsigned long long start = SDL_GetPerformanceCounter();
+
+	bool cold = false;
+	SDL_RWops* ret = nullptr;
+	Asset* asset = Acquire(file, cold);
+
+	if (asset != nullptr)
+	{
+		if ((ret = SDL_RWFromConstMem(asset->data, asset->size)) != nullptr)
+			ret->close = close_asset_rwops;
+		else
+		{
+			LOG("Unable to open %s from the asset cache! SDL Error: %s", file, SDL_GetError());
+			Release(asset->data);
+		}
+	}
+
+	double ms = double(SDL_GetPerformanceCounter() - start) * 1000.0 / double(SDL_GetPerformanceFrequency());
+	if (cold)
+	{
+		cold_loads++;
+		cold_ms += ms;
+		cold_count->Add();
+	}
+	else if (asset != nullptr)
+	{
+		warm_loads++;
+		warm_ms += ms;
+		warm_count->Add();
+	}
+
+	return ret;
+}
+
+void AssetCache::Release(const void* data)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::map<const void*, Asset*>::iterator it = by_data.find(data);
+	if (it != by_data.end() && it->second->pins > 0u && --it->second->pins == 0u)
+	{
+		lru.push_front(it->second);
+		it->second->lru = lru.begin();
+		Evict();
+	}
+}
+
+void AssetCache::RegisterPrefetch(int group, const char* file)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	prefetch_lists[group].push_back(file);
+}
+
+void AssetCache::Prefetch(int group)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::map<int, std::vector<std::string>>::const_iterator list = prefetch_lists.find(group);
+		if (list == prefetch_lists.cend())
+			return;
+
+		for (std::vector<std::string>::const_iterator it = list->second.cbegin(); it != list->second.cend(); ++it)
+			if (assets.find(*it) == assets.end())
+				prefetch_queue.push_back(*it);
+
+		if (!prefetching && !prefetcher.joinable())
+		{
+			prefetching = true;
+			prefetcher = std::thread(&AssetCache::PrefetchLoop, this);
+		}
+	}
+
+	prefetch_wake.notify_one();
+}
+
+void AssetCache::BeginScene(const char* name)
+{
+	scene = name;
+	cold_loads = warm_loads = 0u;
+	cold_ms = warm_ms = 0.0;
+}
+
+void AssetCache::EndScene()
+{
+	if (scene.empty())
+		return;
+
+	LOG("Scene %s assets: %u cold in %.2f ms, %u warm in %.2f ms. %u KB cached, %u KB mapped",
+		scene.c_str(), cold_loads, cold_ms, warm_loads, warm_ms, cached_bytes / 1024u, mapped_bytes / 1024u);
+
+	scene.clear();
+}
+
+void AssetCache::SetBudget(unsigned int inflated, unsigned int mapped)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	budget = inflated;
+	map_budget = mapped;
+	Evict();
+}
+
+AssetCache::Asset* AssetCache::Acquire(const char* file, bool& cold)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::map<std::string, Asset*>::iterator it = assets.find(file);
+		if (it != assets.end())
+		{
+			if (it->second->pins++ == 0u)
+				lru.erase(it->second->lru);
+
+			cold = false;
+			return it->second;
+		}
+	}
+
+	// Read outside the lock: another thread may read the same file meanwhile
+	cold = true;
+	Asset* asset = new Asset();
+	asset->file = file;
+
+	if (!Read(file, *asset))
+	{
+		DEL(asset);
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::map<std::string, Asset*>::iterator it = assets.find(file);
+	if (it != assets.end())
+	{
+		Free(*asset);
+		DEL(asset);
+
+		if (it->second->pins++ == 0u)
+			lru.erase(it->second->lru);
+
+		return it->second;
+	}
+
+	asset->pins = 1u;
+	assets[asset->file] = asset;
+	by_data[asset->data] = asset;
+
+	if (asset->mapped)
+		mapped_bytes += asset->size;
+	else
+		cached_bytes += asset->size;
+
+	Evict();
+
+	return asset;
+}
+
+bool AssetCache::Read(const char* file, Asset& asset) const
+{
+	const char* dir = PHYSFS_getRealDir(file);
+	if (dir == nullptr)
+	{
+		LOG("File System error while opening file %s: %s", file, PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+		return false;
+	}
+
+	// Loose files are mapped, a mount that is no directory (Assets.zip) fails to open
+	std::string path = dir;
+	if (!path.empty() && path.back() != '/' && path.back() != '\\')
+		path += '/';
+	path += file;
+
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(handle, &size) && size.QuadPart > 0 && size.QuadPart < 0xffffffffll)
+		{
+			HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping != NULL)
+			{
+				// The view keeps the mapping alive
+				asset.data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				asset.size = static_cast<unsigned int>(size.QuadPart);
+				CloseHandle(mapping);
+			}
+		}
+
+		CloseHandle(handle);
+	}
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat info;
+		if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 && info.st_size < 0xffffffffll)
+		{
+			void* view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view != MAP_FAILED)
+			{
+				asset.data = static_cast<const char*>(view);
+				asset.size = static_cast<unsigned int>(info.st_size);
+			}
+		}
+
+		close(fd);
+	}
+#endif
+
+	asset.mapped = (asset.data != nullptr);
+	if (asset.mapped)
+	{
+		Touch(asset);
+		return true;
+	}
+
+	// Archive entry: inflate it once through PhysFS
+	MemoryScope mem(MEM_ASSETS);
+	bool ret = false;
+
+	PHYSFS_file* fs_file = PHYSFS_openRead(file);
+	if (fs_file != NULL)
+	{
+		PHYSFS_sint64 size = PHYSFS_fileLength(fs_file);
+		if (size > 0)
+		{
+			char* buffer = new char[static_cast<unsigned int>(size)];
+			ret = (PHYSFS_readBytes(fs_file, buffer, PHYSFS_uint64(size)) == size);
+			if (ret)
+			{
+				asset.data = buffer;
+				asset.size = static_cast<unsigned int>(size);
+			}
+			else
+			{
+				LOG("File System error while reading from file %s: %s", file, PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+				DEL_ARRAY(buffer);
+			}
+		}
+
+		PHYSFS_close(fs_file);
+	}
+	else
+		LOG("File System error while opening file %s: %s", file, PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+
+	return ret;
+}
+
+void AssetCache::Touch(const Asset& asset) const
+{
+	unsigned int page;
+
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	page = info.dwPageSize;
+
+#if _WIN32_WINNT >= 0x0602
+	WIN32_MEMORY_RANGE_ENTRY range = { const_cast<char*>(asset.data), asset.size };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+	page = static_cast<unsigned int>(sysconf(_SC_PAGESIZE));
+	madvise(const_cast<char*>(asset.data), asset.size, MADV_WILLNEED);
+#endif
+
+	// Mapping only reserves the range: fault every page in now, not on the first blit
+	volatile char sum = 0;
+	for (unsigned int i = 0u; i < asset.size; i += page)
+		sum += asset.data[i];
+
+	sum += asset.data[asset.size - 1u];
+}
+
+void AssetCache::Free(Asset& asset) const
+{
+	if (asset.data == nullptr)
+		return;
+
+	if (asset.mapped)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(asset.data);
+#else
+		munmap(const_cast<char*>(asset.data), asset.size);
+#endif
+	}
+	else
+		delete[] asset.data;
+
+	asset.data = nullptr;
+}
+
+void AssetCache::Evict()
+{
+	// Pinned assets never enter the LRU list. Oldest first, skipping the kind within budget
+	std::list<Asset*>::iterator it = lru.end();
+	while (it != lru.begin() && (cached_bytes > budget || mapped_bytes > map_budget))
+	{
+		Asset* asset = *--it;
+		if (asset->mapped ? mapped_bytes <= map_budget : cached_bytes <= budget)
+			continue;
+
+		it = lru.erase(it);
+		assets.erase(asset->file);
+		by_data.erase(asset->data);
+
+		if (asset->mapped)
+			mapped_bytes -= asset->size;
+		else
+			cached_bytes -= asset->size;
+
+		Free(*asset);
+		DEL(asset);
+	}
+
+	cached_count->Set(cached_bytes / 1024u);
+	mapped_count->Set(mapped_bytes / 1024u);
+}
+
+void AssetCache::PrefetchLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true)
+	{
+		prefetch_wake.wait(lock, [this]() { return !prefetching || !prefetch_queue.empty(); });
+
+		if (!prefetching)
+			break;
+
+		std::string file = prefetch_queue.front();
+		prefetch_queue.pop_front();
+
+		if (assets.find(file) != assets.end())
+			continue;
+
+		lock.unlock();
+
+		bool cold;
+		Asset* asset = Acquire(file.c_str(), cold);
+		if (asset != nullptr)
+			Release(asset->data);
+
+		lock.lock();
+	}
+}
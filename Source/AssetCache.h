@@ -0,0 +1,94 @@
+#ifndef __ASSET_CACHE_H__
+#define __ASSET_CACHE_H__
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define ASSET_CACHE_BUDGET 67108864u	// bytes of decompressed archive entries kept unpinned
+#define ASSET_MAP_BUDGET 134217728u		// bytes of loose files kept mapped unpinned
+
+struct SDL_RWops;
+
+// Read only asset bytes shared by every loader. Files found loose in a
+// mounted directory are memory mapped and Assets.zip entries are inflated
+// once. Unpinned assets are kept while they fit ASSET_MAP_BUDGET and
+// ASSET_CACHE_BUDGET respectively, least recently used first out: a mapped
+// file is resident, unmapping it is what gives its pages back. An asset
+// stays pinned while a RWops opened on it is alive
+// (streamed music and fonts keep theirs). Scenes register prefetch lists
+// that a background thread loads ahead, and every scene load reports how
+// many of its assets were cold (read from disk, mapped pages included)
+// or warm (cached).
+class AssetCache
+{
+public:
+
+	AssetCache();
+	~AssetCache();
+
+	void CleanUp();
+
+	SDL_RWops* Open(const char* file);
+	void Release(const void* data); // RWops close
+
+	void RegisterPrefetch(int group, const char* file);
+	void Prefetch(int group);
+
+	void BeginScene(const char* name);
+	void EndScene();
+
+	void SetBudget(unsigned int inflated, unsigned int mapped);
+
+private:
+
+	struct Asset
+	{
+		std::string file;
+		const char* data = nullptr;
+		unsigned int size = 0u;
+		bool mapped = false;
+		unsigned int pins = 0u;
+		std::list<Asset*>::iterator lru;
+	};
+
+	// Returns the asset pinned or nullptr, cold tells if it had to be read
+	Asset* Acquire(const char* file, bool& cold);
+	bool Read(const char* file, Asset& asset) const;
+	void Touch(const Asset& asset) const; // pages a mapped asset in
+	void Free(Asset& asset) const;
+	void Evict();
+
+	void PrefetchLoop();
+
+private:
+
+	std::mutex mutex;
+	std::map<std::string, Asset*> assets;
+	std::map<const void*, Asset*> by_data;
+	std::list<Asset*> lru; // unpinned assets, most recent first
+	unsigned int cached_bytes = 0u;
+	unsigned int mapped_bytes = 0u;
+	unsigned int budget = ASSET_CACHE_BUDGET;
+	unsigned int map_budget = ASSET_MAP_BUDGET;
+
+	std::map<int, std::vector<std::string>> prefetch_lists;
+	std::deque<std::string> prefetch_queue;
+	std::condition_variable prefetch_wake;
+	std::thread prefetcher;
+	bool prefetching = false;
+
+	// Current scene load, main thread
+	std::string scene;
+	unsigned int cold_loads = 0u;
+	unsigned int warm_loads = 0u;
+	double cold_ms = 0.0;
+	double warm_ms = 0.0;
+};
+
+#endif // __ASSET_CACHE_H__
@@ -3,6 +3,7 @@
 #include "Defs.h"
 #include "Point.h"
 #include "Log.h"
+#include "MemoryTracker.h"
 #include "Application.h"
 #include "JuicyMath.h"
 
@@ -16,12 +17,48 @@
 #pragma comment( lib, "SDL2_mixer-2.0.4/lib/x64/SDL2_mixer.lib" )
 #endif
 
+#include <math.h>
+
+// { priority, max_instances }: deaths and buildings beat attacks, attacks beat footsteps
+const Audio::FxRules Audio::rules[MAX_FX] =
+{
+	{ 3, 1 },	// LOGO
+	{ 3, 2 },	// SELECT
+	{ 3, 1 },	// TITLE
+
+	{ 1, 2 },	// EDGE_FX
+	{ 2, 3 },	// B_DESTROYED
+	{ 2, 3 },	// B_BUILDED
+	{ 2, 3 },	// UNIT_DIES
+	{ 0, 3 },	// UNIT_MOVES
+
+	{ 1, 3 },	// GATHERER_ATK_FX
+	{ 1, 4 },	// MELEE_ATK_FX
+	{ 1, 4 },	// RANGED_ATK_FX
+	{ 1, 3 },	// SUPER_ATK_FX
+
+	{ 2, 3 },	// GATHERER_DIE_FX
+	{ 2, 3 },	// MELEE_DIE_FX
+	{ 2, 3 },	// RANGED_DIE_FX
+	{ 2, 3 },	// SUPER_DIE_FX
+
+	{ 1, 4 },	// IA_MELEE_ATK_FX
+	{ 1, 4 },	// IA_RANGED_ATK_FX
+	{ 1, 3 },	// IA_SUPER_ATK_FX
+	{ 2, 3 },	// IA_MELEE_DIE_FX
+	{ 2, 3 },	// IA_RANGED_DIE_FX
+	{ 2, 3 },	// IA_SUPER_DIE_FX
+
+	{ 1, 3 }	// TOWER_ATK
+};
+
 Audio::Audio() : Module("audio")
 {
 	fx_volume = music_volume = 1.0f;
 	fade_duration = 1.0f;
 
 	for (int i = 0; i < MAX_FX; ++i) fx[i] = nullptr;
+	for (int i = 0; i < MAX_VOICES; ++i) voices[i].channel = i + 1;
 }
 
 Audio::~Audio()
@@ -68,6 +105,7 @@ void Audio::SaveConfig() const
 bool Audio::Init()
 {
 	OPTICK_EVENT();
+	MemoryScope mem(MEM_AUDIO);
 
 	bool ret = (SDL_InitSubSystem(SDL_INIT_AUDIO) == 0);
 
@@ -91,7 +129,7 @@ bool Audio::Init()
 			// Initialize SDL_mixer with default frequecy & format
 			if (Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, 2, 2048) == 0)
 			{
-				total_channels = Mix_AllocateChannels(total_channels);
+				total_channels = Mix_AllocateChannels(MAX_VOICES + 1);
 				LOG("SDL_Mixer opened correctly. Allocated %d channels.", total_channels);
 			}
 			else
@@ -108,6 +146,8 @@ bool Audio::Init()
 
 bool Audio::Update()
 {
+	MemoryScope mem(MEM_AUDIO);
+
 	if (state == PAUSING)
 	{
 		if ((fade_timer -= App->time.GetDeltaTime()) <= 0.0f)
@@ -115,8 +155,8 @@ bool Audio::Update()
 			fade_timer = 0.0f;
 			state = PAUSED;
 
-			for (std::map<double, SpatialData>::iterator it = sources.begin(); it != sources.end(); ++it)
-				it->second.Pause();
+			for (int i = 0; i < MAX_VOICES; ++i)
+				voices[i].Pause();
 		}
 
 		SetFadeVolume(fade_timer / fade_duration);
@@ -128,8 +168,8 @@ bool Audio::Update()
 			fade_timer = fade_duration;
 			state = NO_FADE;
 
-			for (std::map<double, SpatialData>::iterator it = sources.begin(); it != sources.end(); ++it)
-				it->second.RePlay();
+			for (int i = 0; i < MAX_VOICES; ++i)
+				voices[i].RePlay();
 		}
 
 		SetFadeVolume(fade_timer / fade_duration);
@@ -165,9 +205,9 @@ void Audio::RecieveEvent(const Event& e)
 	}
 	case HALT_FX:
 	{
-		std::map<double, SpatialData>::iterator it = sources.find(e.data1.AsDouble());
-		if (it != sources.end())
-			it->second.Halt();
+		int voice = GetVoice(e.data1.AsDouble());
+		if (voice >= 0)
+			voices[voice].Halt();
 
 		break;
 	}
@@ -184,19 +224,23 @@ void Audio::RecieveEvent(const Event& e)
 	}
 	case TRANSFORM_MODIFIED:
 	{
-		std::map<double, SpatialData>::iterator it = sources.find(e.data1.AsDouble());
-		if (it != sources.end())
+		int voice = GetVoice(e.data1.AsDouble());
+		if (voice >= 0)
 		{
 			const vec global_pos = e.data2.AsVec();
-			it->second.Update(App->render->GetCameraCenter(), { global_pos.x, global_pos.y }, fx_volume);
+			voices[voice].pos = { global_pos.x, global_pos.y };
+			voices[voice].Update(App->render->GetCameraCenter(), GetCullRadius(), fx_volume);
 		}
 		break;
 	}
 	case CAMERA_MOVED:
 	{
+		// Every playing voice in one pass
 		std::pair<float, float> cam = App->render->GetCameraCenter();
-		for (std::map<double, SpatialData>::iterator it = sources.begin(); it != sources.end(); ++it)
-			it->second.Update(cam, it->second.pos, fx_volume);
+		float cull_radius = GetCullRadius();
+		for (int i = 0; i < MAX_VOICES; ++i)
+			if (voices[i].Playing())
+				voices[i].Update(cam, cull_radius, fx_volume);
 
 		break;
 	}
@@ -219,8 +263,8 @@ void Audio::RecieveEvent(const Event& e)
 	}
 	case SCENE_STOP:
 	{
-		for (std::map<double, SpatialData>::iterator it = sources.begin(); it != sources.end(); ++it)
-			it->second.Halt();
+		for (int i = 0; i < MAX_VOICES; ++i)
+			voices[i].Halt();
 
 		break;
 	}
@@ -233,6 +277,7 @@ void Audio::RecieveEvent(const Event& e)
 bool Audio::PlayMusic(const char* path, float fade_time)
 {
 	OPTICK_EVENT();
+	MemoryScope mem(MEM_AUDIO);
 
 	music_is_playing = false;
 
@@ -281,6 +326,7 @@ bool Audio::MusicIsPlaying()
 bool Audio::LoadFx(Audio_FX audio_fx)
 {
 	OPTICK_EVENT();
+	MemoryScope mem(MEM_AUDIO);
 
 	bool ret;
 	std::string audio_path = "audio/Effects/";
@@ -339,8 +385,9 @@ void Audio::UnloadFx()
 		}
 	}
 
-	Mix_AllocateChannels(0);
-	total_channels = Mix_AllocateChannels(1);
+	Mix_HaltChannel(-1);
+	for (int i = 0; i < MAX_VOICES; ++i)
+		voices[i].source = -1.0;
 }
 
 bool Audio::PlayFx(Audio_FX audio_fx, int repeat)
@@ -356,43 +403,35 @@ bool Audio::PlayFx(Audio_FX audio_fx, int repeat)
 bool Audio::PlaySpatialFx(Audio_FX audio_fx, double id, const std::pair<float, float> position, int repeat, int ticks, int fade_ms)
 {
 	OPTICK_EVENT();
+	MemoryScope mem(MEM_AUDIO);
 
 	bool ret = false;
 
 	if (fx[audio_fx] || LoadFx(audio_fx))
 	{
-		// Get channel to play. New sources will return -1 by default.
-		int target_channel = sources[id].channel;
-		sources[id].pos = position;
-		if (target_channel < 0)
+		std::pair<float, float> cam = App->render->GetCameraCenter();
+		int v = PickVoice(audio_fx, id, JMath::Distance(cam, position));
+		if (v >= 0)
 		{
-			// Increase channel count on needing more channels
-			if (total_channels - 1 < int(sources.size()))
-				total_channels += Mix_AllocateChannels(total_channels + 1);
-
-			// Search for empty channel
-			for (target_channel = 1; target_channel < total_channels; ++target_channel)
-			{
-				if (!Mix_Playing(target_channel))
-				{
-					sources[id].channel = target_channel;
-					break;
-				}
-			}
+			// Stolen voices are cut off
+			Voice& voice = voices[v];
+			if (voice.Playing())
+				Mix_HaltChannel(voice.channel);
+
+			voice.source = id;
+			voice.chunk = int(audio_fx);
+			voice.priority = rules[audio_fx].priority;
+			voice.paused = false;
+			voice.pos = position;
+			voice.Update(cam, GetCullRadius(), fx_volume);
+
+			ret = (fade_ms > 0) ?
+				(Mix_FadeInChannelTimed(voice.channel, fx[audio_fx], repeat, fade_ms, ticks) != -1) :
+				(Mix_PlayChannelTimed(voice.channel, fx[audio_fx], repeat, ticks) != -1);
+
+			if (!ret)
+				voice.source = -1.0;
 		}
-
-		sources[id].chunk = int(audio_fx);
-
-		// Setup channel spatial properties and play
-		std::pair<float, float> cam = App->render->GetCameraCenter();
-		Mix_SetPosition(target_channel,
-			sources[id].angle = JMath::HorizontalAxisAngle_F(cam, position, -90.0f),
-			sources[id].distance = JMath::DistanceSquared(cam, position));
-
-		// Play fx
-		ret = (fade_ms > 0) ?
-			(Mix_FadeInChannelTimed(target_channel, fx[audio_fx], repeat, fade_ms, ticks) != -1) :
-			(Mix_PlayChannelTimed(target_channel, fx[audio_fx], repeat, ticks) != -1);
 	}
 
 	return ret;
@@ -401,20 +440,94 @@ bool Audio::PlaySpatialFx(Audio_FX audio_fx, double id, const std::pair<float, f
 bool Audio::StopFXChannel(double id, int ms, bool fade)
 {
 	bool ret = false;
-	std::map<double, SpatialData>::iterator it = sources.find(id);
-	if (it != sources.end())
+	int voice = GetVoice(id);
+	if (voice >= 0)
 	{
+		int channel = voices[voice].channel;
 		if (fade)
-			ret = (Mix_FadeOutChannel(it->second.channel, ms) != -1);
+			ret = (Mix_FadeOutChannel(channel, ms) != -1);
 		else if (ms > 0)
-			ret = (Mix_ExpireChannel(it->second.channel, ms) != -1);
+			ret = (Mix_ExpireChannel(channel, ms) != -1);
 		else
-			ret = (Mix_HaltChannel(it->second.channel) != -1);
+			ret = (Mix_HaltChannel(channel) != -1);
 	}
 
 	return ret;
 }
 
+unsigned int Audio::GetActiveVoices() const
+{
+	unsigned int ret = 0u;
+
+	for (int i = 0; i < MAX_VOICES; ++i)
+		if (voices[i].Playing())
+			ret++;
+
+	return ret;
+}
+
+int Audio::GetVoice(double source) const
+{
+	for (int i = 0; i < MAX_VOICES; ++i)
+		if (voices[i].source == source && voices[i].Playing())
+			return i;
+
+	return -1;
+}
+
+int Audio::PickVoice(Audio_FX audio_fx, double source, float distance) const
+{
+	if (distance > GetCullRadius())
+		return -1;
+
+	// A source replays on its own voice
+	int ret = GetVoice(source);
+	if (ret >= 0)
+		return ret;
+
+	const FxRules& rule = rules[audio_fx];
+	int instances = 0, farthest_instance = -1, free_voice = -1, steal = -1;
+
+	for (int i = 0; i < MAX_VOICES; ++i)
+	{
+		const Voice& voice = voices[i];
+		if (!voice.Playing())
+		{
+			if (free_voice < 0)
+				free_voice = i;
+		}
+		else
+		{
+			if (voice.chunk == int(audio_fx))
+			{
+				instances++;
+				if (farthest_instance < 0 || voice.distance > voices[farthest_instance].distance)
+					farthest_instance = i;
+			}
+
+			if (voice.priority <= rule.priority && (steal < 0 || voice.priority < voices[steal].priority ||
+				(voice.priority == voices[steal].priority && voice.distance > voices[steal].distance)))
+				steal = i;
+		}
+	}
+
+	if (instances >= rule.max_instances)
+		ret = (voices[farthest_instance].distance > distance) ? farthest_instance : -1;
+	else if (free_voice >= 0)
+		ret = free_voice;
+	else if (steal >= 0 && (voices[steal].priority < rule.priority || voices[steal].distance > distance))
+		ret = steal;
+
+	return ret;
+}
+
+// Half the camera's diagonal: sounds past its corners are never heard
+float Audio::GetCullRadius() const
+{
+	RectF cam = App->render->GetCameraRectF();
+	return 0.5f * sqrtf(cam.w * cam.w + cam.h * cam.h);
+}
+
 void Audio::SetMusicVolume(float vol)
 {
 	SDL_assert(vol >= 0.0f && vol <= 1.0f);
@@ -435,8 +548,8 @@ void Audio::SetFXVolume(float vol)
 		fx_volume = vol;
 		int target_vol = int(fx_volume * 128.0f);
 		Mix_Volume(0, target_vol);
-		for (std::map<double, SpatialData>::iterator it = sources.begin(); it != sources.end(); ++it)
-			Mix_Volume(it->second.channel, target_vol);
+		for (int i = 0; i < MAX_VOICES; ++i)
+			Mix_Volume(voices[i].channel, target_vol);
 	}
 }
 
@@ -455,56 +568,63 @@ inline void Audio::SetFadeVolume(float fade_percent)
 	Mix_VolumeMusic(int(music_volume * ((fade_percent * 112.0f) + 16.0f)));
 
 	int target_vol = int(fade_percent * fx_volume * 128.0f);
-	for (std::map<double, SpatialData>::iterator it = sources.begin(); it != sources.end(); ++it)
-		Mix_Volume(it->second.channel, target_vol);
+	for (int i = 0; i < MAX_VOICES; ++i)
+		Mix_Volume(voices[i].channel, target_vol);
 }
 
-Audio::SpatialData::SpatialData() :
+Audio::Voice::Voice() :
+	source(-1.0),
 	channel(-1),
-	angle(-1.f),
-	distance(-1.f),
+	chunk(-1),
+	priority(0),
+	paused(false),
+	distance(0.f),
 	pos({ 0.f, 0.f })
 {}
 
-Audio::SpatialData::SpatialData(const SpatialData& copy) :
-	channel(copy.channel),
-	angle(copy.angle),
-	distance(copy.distance),
-	pos(copy.pos)
-{}
+inline bool Audio::Voice::Playing() const
+{
+	return source >= 0.0 && Mix_Playing(channel) != 0;
+}
 
-inline void Audio::SpatialData::Update(const std::pair<float, float> cam, const std::pair<float, float> position, float fx_volume)
+inline void Audio::Voice::Update(const std::pair<float, float> cam, float cull_radius, float fx_volume)
 {
+	distance = JMath::Distance(cam, pos);
+
+	// Mixer distance is 0 (close) to 255 (far)
+	float attenuation = cull_radius > 0.f ? distance / cull_radius : 1.f;
+	if (attenuation > 1.f) attenuation = 1.f;
+
 	Mix_SetPosition(channel,
-		angle = JMath::HorizontalAxisAngle_F(cam, pos = position, -90.0f),
-		distance = JMath::Distance(cam, position));
-	
-	Mix_Volume(channel, (inside_cam = App->render->InsideCam(position.first, position.second)) ? int(fx_volume * 128.0f) : 0);
+		Sint16(JMath::HorizontalAxisAngle_F(cam, pos, -90.0f)),
+		Uint8(attenuation * VOICE_MAX_ATTENUATION));
+
+	Mix_Volume(channel, App->render->InsideCam(pos.first, pos.second) ? int(fx_volume * 128.0f) : 0);
 }
 
-inline void Audio::SpatialData::Pause()
+inline void Audio::Voice::Pause()
 {
-	if (!halted && !paused)
+	if (!paused && Playing())
 	{
 		paused = true;
 		Mix_Pause(channel);
 	}
 }
 
-inline void Audio::SpatialData::RePlay()
+inline void Audio::Voice::RePlay()
 {
-	if (!halted && paused)
+	if (paused)
 	{
 		paused = false;
 		Mix_Resume(channel);
 	}
 }
 
-inline void Audio::SpatialData::Halt()
+inline void Audio::Voice::Halt()
 {
-	if (!halted)
+	if (Playing())
 	{
-		halted = true;
+		paused = false;
 		Mix_HaltChannel(channel);
 	}
 }
@@ -2,12 +2,10 @@
 #define __AUDIO_H__
 
 #include "Module.h"
-#include <map>
 
 struct _Mix_Music;
 struct Mix_Chunk;
 class Transform;
-enum Scenes;
 
 enum Audio_FX : int
 {
@@ -43,6 +41,9 @@ enum Audio_FX : int
 	MAX_FX
 };
 
+#define MAX_VOICES 24				// mixer channels for spatial fx, channel 0 stays for ui fx
+#define VOICE_MAX_ATTENUATION 200	// Mix_SetPosition distance at the cull radius
+
 class Audio : public Module
 {
 public:
@@ -71,6 +72,8 @@ public:
 	bool PlaySpatialFx(Audio_FX audio_fx, double id, const std::pair<float, float> position, int repeat = 0, int ticks = -1, int fade_ms = -1);
 	bool StopFXChannel(double id, int ms = 0, bool fade = false);
 
+	unsigned int GetActiveVoices() const;
+
 	// Volume Controls
 	float GetVolumeFx() const;
 	float GetVolumeMusic() const;
@@ -86,24 +89,40 @@ private:
 	_Mix_Music*	music = nullptr;
 	bool music_is_playing = false;
 
-	struct SpatialData
+	// Spatial fx play on a fixed set of voices. A new sound outside the
+	// camera's cull radius is dropped, one past its fx's instance limit
+	// replaces the farthest instance and, with every voice busy, it takes
+	// the farthest voice of the lowest priority below or equal to its own.
+	struct FxRules
+	{
+		int priority;
+		int max_instances;
+	};
+
+	struct Voice
 	{
-		SpatialData();
-		SpatialData(const SpatialData& copy);
+		Voice();
 
-		inline void Update(const std::pair<float, float> cam, const std::pair<float, float> position, float fx_volume);
+		inline bool Playing() const;
+		inline void Update(const std::pair<float, float> cam, float cull_radius, float fx_volume);
 		inline void Pause();
 		inline void RePlay();
 		inline void Halt();
 
-
-		bool inside_cam, paused, halted;
-		int channel, chunk, volume;
-		float angle, distance;
+		double source;	// AudioSource id, -1 if free
+		int channel, chunk, priority;
+		bool paused;
+		float distance;
 		std::pair<float, float> pos;
 	};
 
-	std::map<double, SpatialData> sources;
+	int GetVoice(double source) const;
+	int PickVoice(Audio_FX audio_fx, double source, float distance) const; // -1 if the sound loses
+	float GetCullRadius() const;
+
+	static const FxRules rules[MAX_FX];
+
+	Voice voices[MAX_VOICES];
 	Mix_Chunk* fx[MAX_FX];
 	int	total_channels = 1;
 
@@ -59,7 +59,7 @@ Base_Center::~Base_Center()
 				App->pathfinding.SetWalkabilityTile(int(pos.x) + i + 2, int(pos.y) + a - 1, false);
 	}
 
-	b_map.erase(GetID());
+	RemoveFromList();
 
 	if (baseCenter == game_object)
 		baseCenter = nullptr;
@@ -83,9 +83,6 @@ void Base_Center::Update()
 {
 	pos = game_object->GetTransform()->GetGlobalPosition();
 
-	if (providesVisibility)
-		GetTilesInsideRadius();
-
 	if (!build_queue.empty())
 	{
 		bool able_to_build = true;
@@ -6,6 +6,7 @@
 #include "Transform.h"
 #include "Sprite.h"
 #include "AudioSource.h"
+#include "ByteStream.h"
 #include "Log.h"
 #include "Vector3.h"
 #include "Canvas.h"
@@ -16,10 +17,13 @@
 #include "JuicyMath.h"
 #include "Input.h"
 #include "ParticleSystem.h"
+#include "Counters.h"
 
 #include <vector>
 
-std::map<double, Behaviour*> Behaviour::b_map;
+std::vector<Behaviour*> Behaviour::b_list;
+static Counter* behaviour_count = Counters::Find("scene/behaviours", COUNTER_GAUGE);
+static Counter* repath_count = Counters::Find("units/repaths");
 
 Behaviour::Behaviour(Gameobject* go, UnitType t, UnitState starting_state, ComponentType comp_type) :
 	Component(comp_type, go),
@@ -38,8 +42,6 @@ Behaviour::Behaviour(Gameobject* go, UnitType t, UnitState starting_state, Compo
 	providesVisibility = true;
 	visible = true;
 	baseCollOffset = { 0,0 };
-	visionCollOffset = { 0,0 };
-	attackCollOffset = { 0,0 };
 	selectionRect = {0,0,64,64};
 	game_object->SetStatic(true);
 	active = false;
@@ -54,12 +56,53 @@ Behaviour::Behaviour(Gameobject* go, UnitType t, UnitState starting_state, Compo
 	mini_life_bar.Create(go);
 	mini_life_bar.Hide();
 
-	b_map.insert({ GetID(), this });
+	b_index = int(b_list.size());
+	b_list.push_back(this);
+	behaviour_count->Set(b_list.size());
 }
 
 Behaviour::~Behaviour()
 {
-	b_map.erase(GetID());
+	RemoveFromList();
+}
+
+void Behaviour::RemoveFromList()
+{
+	if (b_index >= 0)
+	{
+		// Swap-remove keeps b_list dense
+		b_list[b_index] = b_list.back();
+		b_list[b_index]->b_index = b_index;
+		b_list.pop_back();
+		behaviour_count->Set(b_list.size());
+		b_index = -1;
+	}
+
+	App->spatial.Remove(this);
+	ReleaseReservedTiles();
+}
+
+void Behaviour::DestroyPanels()
+{
+	// Only reached once the unit is dead, nothing reads the panels past this point
+	if (selectionPanel != nullptr)
+		selectionPanel->Destroy();
+
+	if (unitInfo != nullptr)
+		unitInfo->Destroy();
+
+	selectionPanel = unitInfo = nullptr;
+}
+
+void Behaviour::ReleaseReservedTiles()
+{
+	App->pathfinding.ReleaseTiles(tilesVisited, GetHandle());
+}
+
+bool Behaviour::IsHidden(double id)
+{
+	Component* comp = Component::Find(id);
+	return comp != nullptr && comp->AsBehaviour()->visible;
 }
 
 bool Behaviour::IsDestroyed()
@@ -81,7 +124,6 @@ void Behaviour::SetColliders()
 		case UNIT_SUPER:
 		{
 			bodyColl = new Collider(game_object, { pos.x,pos.y,game_object->GetTransform()->GetLocalScaleX(),game_object->GetTransform()->GetLocalScaleY() }, NON_TRIGGER, PLAYER_TAG, { 0,Map::GetBaseOffset(),0,0 }, BODY_COLL_LAYER);
-			attackColl = new Collider(game_object, { pos.x,pos.y,attack_range,attack_range }, TRIGGER, PLAYER_ATTACK_TAG, { 0,Map::GetBaseOffset(),0,0 }, ATTACK_COLL_LAYER);
 			std::pair<float, float> world = Map::F_MapToWorld(pos.x, pos.y);
 			selectionOffset = { 10,-30 };
 			selectionRect = { world.first + selectionOffset.first,world.second + selectionOffset.second,40,70 };
@@ -92,8 +134,6 @@ void Behaviour::SetColliders()
 		case ENEMY_SUPER:
 		{
 			bodyColl = new Collider(game_object, { pos.x,pos.y,game_object->GetTransform()->GetLocalScaleX(),game_object->GetTransform()->GetLocalScaleY() }, NON_TRIGGER, ENEMY_TAG, { 0,Map::GetBaseOffset(),0,0 }, BODY_COLL_LAYER);
-			visionColl = new Collider(game_object, { pos.x,pos.y,vision_range,vision_range }, TRIGGER, ENEMY_VISION_TAG, { 0,Map::GetBaseOffset(),0,0 }, VISION_COLL_LAYER);
-			attackColl = new Collider(game_object, { pos.x,pos.y,attack_range,attack_range }, TRIGGER, ENEMY_ATTACK_TAG, { 0,Map::GetBaseOffset(),0,0 }, ATTACK_COLL_LAYER);
 			std::pair<float, float> world = Map::F_MapToWorld(pos.x, pos.y);
 			selectionOffset = { 10,-30 };
 			selectionRect = { world.first + selectionOffset.first,world.second + selectionOffset.second,40,70 };
@@ -110,7 +150,6 @@ void Behaviour::SetColliders()
 		case TOWER:
 		{
 			bodyColl = new Collider(game_object, { pos.x,pos.y,game_object->GetTransform()->GetLocalScaleX() * 1.5f,game_object->GetTransform()->GetLocalScaleY() * 1.5f }, TRIGGER, PLAYER_TAG, { 0,Map::GetBaseOffset()+10,0,0 }, BODY_COLL_LAYER);
-			attackColl = new Collider(game_object, { pos.x,pos.y,attack_range,attack_range }, TRIGGER, PLAYER_ATTACK_TAG, { 0,Map::GetBaseOffset(),0,0 }, ATTACK_COLL_LAYER);
 			std::pair<float, float> world = Map::F_MapToWorld(pos.x, pos.y);
 			selectionOffset = { 5,-105 };
 			selectionRect = { world.first + selectionOffset.first,world.second + selectionOffset.second,55,160 };
@@ -214,8 +253,13 @@ void Behaviour::RecieveEvent(const Event& e)
 	case HIDE_SPRITE: DesactivateSprites(); break;
 	case CHECK_FOW: CheckFoWMap(e.data1.AsBool()); break;
 	case ON_COLLISION:
-		OnCollision(*Component::ComponentsList[e.data1.AsDouble()]->AsCollider(), *Component::ComponentsList[e.data2.AsDouble()]->AsCollider());
+	{
+		Component* self = Component::Get(e.data1.AsUInt());
+		Component* other = Component::Get(e.data2.AsUInt());
+		if (self != nullptr && other != nullptr)
+			OnCollision(*self->AsCollider(), *other->AsCollider());
 		break;
+	}
 	case REPATH: Repath(); break;
 	}
 }
@@ -223,8 +267,7 @@ void Behaviour::RecieveEvent(const Event& e)
 void Behaviour::PreUpdate()
 {
 	pos = game_object->GetTransform()->GetGlobalPosition();
-	if(providesVisibility) GetTilesInsideRadius(); 
-	else CheckFoWMap();
+	if (!providesVisibility) CheckFoWMap();
 }
 
 void Behaviour::ActivateSprites()
@@ -249,79 +292,26 @@ void Behaviour::CheckFoWMap(bool debug)
 	else{ ActivateSprites(); }
 }
 
-void Behaviour::GetTilesInsideRadius()
+void Behaviour::GetVisionArea(VisionArea& area) const
 {
+	vec p = game_object->GetTransform()->GetGlobalPosition();
 	vec s = game_object->GetTransform()->GetLocalScale();
-	if (type == BARRACKS)
-	{
-		iPoint startingPos(int(pos.x + 4 + s.x * 0.5 - vision_range), int(pos.y - s.y * 0.5 - vision_range));
-		iPoint finishingPos(int(startingPos.x + (vision_range * 2)), int(startingPos.y + (vision_range * 2)));
-
-		for (int x = startingPos.x; x < finishingPos.x; x++)
-		{
-			for (int y = startingPos.y; y < finishingPos.y; y++)
-			{
-				iPoint tilePos(x, y);
-				if (tilePos.DistanceTo(iPoint(int(pos.x + 5), int(pos.y))) <= vision_range * 0.6)
-				{
-					if (App->fogWar.CheckFoWTileBoundaries(iPoint(tilePos.x, tilePos.y)))FogOfWarManager::fogMap[tilePos.x][tilePos.y] = true;
-				}
-			}
-		}
-	}
-	else if(type == BASE_CENTER)
-	{
-
-		iPoint startingPos(int(pos.x+3 + s.x * 0.5 - vision_range), int(pos.y - s.y * 0.5 - vision_range));
-		iPoint finishingPos(int(startingPos.x + (vision_range * 2)), int(startingPos.y + (vision_range * 2)));
 
-		for (int x = startingPos.x; x < finishingPos.x; x++)
-		{
-			for (int y = startingPos.y; y < finishingPos.y; y++)
-			{
-				iPoint tilePos(x, y);
-				if (tilePos.DistanceTo(iPoint(int(pos.x+3), int(pos.y))) <= vision_range * 0.6)
-				{
-					if (App->fogWar.CheckFoWTileBoundaries(iPoint(tilePos.x, tilePos.y)))FogOfWarManager::fogMap[tilePos.x][tilePos.y] = true;
-				}
-			}
-		}
-	}
-	else if (type == LAB)
+	// Buildings see from their footprint's center
+	int offset = 0;
+	int center_offset = 0;
+	switch (type)
 	{
-
-		iPoint startingPos(int(pos.x + 3 + s.x * 0.5 - vision_range), int(pos.y - s.y * 0.5 - vision_range));
-		iPoint finishingPos(int(startingPos.x + (vision_range * 2)), int(startingPos.y + (vision_range * 2)));
-
-		for (int x = startingPos.x; x < finishingPos.x; x++)
-		{
-			for (int y = startingPos.y; y < finishingPos.y; y++)
-			{
-				iPoint tilePos(x, y);
-				if (tilePos.DistanceTo(iPoint(int(pos.x + 3), int(pos.y))) <= vision_range * 0.6)
-				{
-					if (App->fogWar.CheckFoWTileBoundaries(iPoint(tilePos.x, tilePos.y)))FogOfWarManager::fogMap[tilePos.x][tilePos.y] = true;
-				}
-			}
-		}
+	case BARRACKS: offset = 4; center_offset = 5; break;
+	case BASE_CENTER:
+	case LAB: offset = center_offset = 3; break;
+	default: break;
 	}
-	else
-	{
-		iPoint startingPos(int(pos.x + s.x * 0.5 - vision_range), int(pos.y - s.y * 0.5 - vision_range));
-		iPoint finishingPos(int(startingPos.x + (vision_range * 2)), int(startingPos.y + (vision_range * 2)));
 
-		for (int x = startingPos.x; x < finishingPos.x; x++)
-		{
-			for (int y = startingPos.y; y < finishingPos.y; y++)
-			{
-				iPoint tilePos(x, y);
-				if (tilePos.DistanceTo(iPoint(int(pos.x), int(pos.y))) <= vision_range * 0.6)
-				{
-					if (App->fogWar.CheckFoWTileBoundaries(iPoint(tilePos.x, tilePos.y)))FogOfWarManager::fogMap[tilePos.x][tilePos.y] = true;
-				}
-			}
-		}
-	}
+	area.start = iPoint(int(p.x + offset + s.x * 0.5 - vision_range), int(p.y - s.y * 0.5 - vision_range));
+	area.end = iPoint(int(area.start.x + (vision_range * 2)), int(area.start.y + (vision_range * 2)));
+	area.center = iPoint(int(p.x + center_offset), int(p.y));
+	area.radius = vision_range * 0.6f;
 }
 
 
@@ -337,6 +327,23 @@ void Behaviour::Save(pugi::xml_node& node) const
 	node.append_attribute("type").set_value((int)type);
 }
 
+void Behaviour::Load(ByteReader& in)
+{
+	in.Read(current_life);
+	active = true;
+}
+
+void Behaviour::Save(ByteWriter& out) const
+{
+	out.Write(current_life);
+}
+
+void Behaviour::SkipRecord(ByteReader& in)
+{
+	int life;
+	in.Read(life);
+}
+
 void Behaviour::Selected()
 {
 	if (active)
@@ -508,40 +515,19 @@ void Behaviour::OnKill(const UnitType type)
 		break;
 	}
 	}
-	if (!tilesVisited.empty())
-	{
-		for (std::vector<iPoint>::const_iterator it = tilesVisited.cbegin(); it != tilesVisited.cend(); ++it)
-		{
-			if (PathfindingManager::unitWalkability[it->x][it->y] != 0)
-			{
-				PathfindingManager::unitWalkability[it->x][it->y] = 0;
-			}
-		}
-	}
 	FreeWalkabilityTiles();
-	b_map.erase(GetID());
+	RemoveFromList();
 }
 
 unsigned int Behaviour::GetBehavioursInRange(vec pos, float dist, std::map<float, Behaviour*>& res) const
 {
-	unsigned int ret = 0;
+	static std::vector<Behaviour*> in_range;
+	in_range.clear();
 
-	for (std::map<double, Behaviour*>::iterator it = b_map.begin(); it != b_map.end(); ++it)
-	{
-		if (it->first != GetID())
-		{
-			Transform* t = it->second->game_object->GetTransform();
-			if (t)
-			{
-				float d = t->DistanceTo(pos);
-				if (d < dist)
-				{
-					ret++;
-					res.insert({ d, it->second });
-				}
-			}
-		}
-	}
+	unsigned int ret = App->spatial.QueryRadius(pos, dist, in_range, SpatialFilter(ALL_UNIT_TYPES, ALL_FACTIONS, this));
+
+	for (std::vector<Behaviour*>::iterator it = in_range.begin(); it != in_range.end(); ++it)
+		res.insert({ (*it)->game_object->GetTransform()->DistanceTo(pos), (*it) });
 
 	return ret;
 }
@@ -565,7 +551,15 @@ B_Unit::B_Unit(Gameobject* go, UnitType t, UnitState s, ComponentType comp_type)
 	attackFX = SELECT;
 	vision_range = 5.0f;
 
+	game_object->SetStatic(false);
+	active = true;
+	ResetState();
+}
+
+void B_Unit::ResetState()
+{
 	path = nullptr;
+	segment.clear();
 	next = false;
 	move = false;
 	nextTile.x = 0;
@@ -581,22 +575,64 @@ B_Unit::B_Unit(Gameobject* go, UnitType t, UnitState s, ComponentType comp_type)
 	spriteState = IDLE;
 	drawRanges = false;
 	gotTile = false;
-	game_object->SetStatic(false);
 	calculating_path = false;
 	atkObj = nullptr;
 	chaseObj = nullptr;
 	chasing = false;
 	moveOrder = false;
 	unitLevel = 0;
-	active = true;
 	foundPoint = false;
 	nonMovingCounter = 0.0f;
 }
 
+void B_Unit::Park()
+{
+	// Prewarmed bundles never lived: leave them as a dead unit would
+	if (current_state != DESTROYED)
+	{
+		current_state = spriteState = DESTROYED;
+		OnDestroy();
+	}
+
+	App->groupMove.Cancel(GetHandle());
+	App->collSystem.Remove(bodyColl);
+	RemoveFromList();
+	UnSelected();
+	mini_life_bar.Hide();
+	tilesVisited.clear();
+	lastFog.clear();
+}
+
+void B_Unit::Revive()
+{
+	ResetState();
+	ResetStats();
+
+	current_state = IDLE;
+	current_lvl = 0;
+	rayCastTimer = 0;
+	shoot = false;
+	objective = nullptr;
+	visible = true;
+	velocity = fPoint(0.f, 0.f);
+	retarget_timer = -1.f;
+	avoidance_agent = -1;
+
+	pos = game_object->GetTransform()->GetGlobalPosition();
+	std::pair<float, float> world = Map::F_MapToWorld(pos.x, pos.y);
+	selectionRect.x = world.first + selectionOffset.first;
+	selectionRect.y = world.second + selectionOffset.second;
+	ActivateSprites();
+
+	b_index = int(b_list.size());
+	b_list.push_back(this);
+	behaviour_count->Set(b_list.size());
+	App->collSystem.Add(bodyColl);
+}
+
 void B_Unit::Update()
 {	
-	if (providesVisibility) GetTilesInsideRadius();
-	else CheckFoWMap();
+	if (!providesVisibility) CheckFoWMap();
 
 	if (current_state != DESTROYED)
 	{
@@ -610,7 +646,6 @@ void B_Unit::Update()
 					if (!atkObj->IsDestroyed()) //Attack
 					{
 						DoAttack();
-						Event::Push(DAMAGE, atkObj, damage,GetType());
 					}
 					else atkObj = nullptr;
 					atkTimer = 0;
@@ -622,8 +657,7 @@ void B_Unit::Update()
 				{
 					if (!atkObj->IsDestroyed()) //ATTACK
 					{
-						DoAttack();						
-						Event::Push(DAMAGE, atkObj, damage,GetType());
+						DoAttack();
 					}
 					else atkObj = nullptr;
 					atkTimer = 0;
@@ -665,7 +699,7 @@ void B_Unit::Update()
 			if (path != nullptr && !path->empty())
 				CheckPathTiles();
 
-			if (move && PathfindingManager::unitWalkability[nextTile.x][nextTile.y] == GetID())
+			if (move && App->pathfinding.IsTileReservedBy(nextTile.x, nextTile.y, GetHandle()))
 			{
 				calculating_path = false;
 				nonMovingCounter = 0.0f;
@@ -687,14 +721,7 @@ void B_Unit::Update()
 				else
 					dirY = 0;
 
-				game_object->GetTransform()->MoveX(dirX * speed * App->time.GetGameDeltaTime());//Move x
-				game_object->GetTransform()->MoveY(dirY * speed * App->time.GetGameDeltaTime());//Move y
-
-				if (App->pathfinding.ValidTile(int(pos.x), int(pos.y)) == false)
-				{
-					game_object->GetTransform()->MoveX(-dirX * speed * App->time.GetGameDeltaTime());//Move x back
-					game_object->GetTransform()->MoveY(-dirY * speed * App->time.GetGameDeltaTime());//Move y back
-				}
+				Steer();
 
 				ChangeState();
 				CheckDirection(actualPos);
@@ -820,38 +847,46 @@ void B_Unit::Update()
 	}
 }
 
-void B_Unit::OnCollision(Collider selfCol, Collider col)
+void B_Unit::AcquireTargets()
 {
-	if (current_state != DESTROYED)
-	{
-		if (selfCol.GetColliderTag() == PLAYER_ATTACK_TAG)
-		{
-			if (col.GetColliderTag() == ENEMY_TAG)
-			{
-				if (GetType() != GATHERER)
-				{
-					if(col.parentGo->GetBehaviour()->GetType() != EDGE && col.parentGo->GetBehaviour()->GetType() != CAPSULE)
-						atkObj = col.parentGo->GetBehaviour();
-				}
-				else
-					atkObj = col.parentGo->GetBehaviour();			
-			}
-		}
-
-		if (selfCol.GetColliderTag() == ENEMY_ATTACK_TAG && col.GetColliderTag() == PLAYER_TAG)
-			atkObj = col.parentGo->GetBehaviour();
+	if (current_state == DESTROYED)
+		return;
 
-		if (selfCol.GetColliderTag() == ENEMY_VISION_TAG && col.GetColliderTag() == PLAYER_TAG && chaseObj == nullptr)
-			chaseObj = col.parentGo->GetBehaviour();
+	switch (type)
+	{
+	case ENEMY_MELEE:
+	case ENEMY_RANGED:
+	case ENEMY_SUPER:
+	{
+		SpatialFilter players(ALL_UNIT_TYPES, FACTION_MASK(PLAYER_FACTION));
+		atkObj = App->targeting.FindBest(this, pos, attack_range, players);
+		if (chaseObj == nullptr)
+			chaseObj = App->targeting.FindBest(this, pos, vision_range, players);
+		break;
+	}
+	case GATHERER:
+		atkObj = App->targeting.FindBest(this, pos, attack_range, SpatialFilter(UNIT_TYPE_MASK(ENEMY_MELEE) | UNIT_TYPE_MASK(ENEMY_RANGED) | UNIT_TYPE_MASK(ENEMY_SUPER)
+			| UNIT_TYPE_MASK(SPAWNER) | UNIT_TYPE_MASK(EDGE) | UNIT_TYPE_MASK(CAPSULE)));
+		break;
+	default:
+		atkObj = App->targeting.FindBest(this, pos, attack_range, SpatialFilter(UNIT_TYPE_MASK(ENEMY_MELEE) | UNIT_TYPE_MASK(ENEMY_RANGED) | UNIT_TYPE_MASK(ENEMY_SUPER)
+			| UNIT_TYPE_MASK(SPAWNER)));
+		break;
 	}
 }
 
+bool B_Unit::TargetLost() const
+{
+	return (atkObj != nullptr && atkObj->IsDestroyed()) || (chaseObj != nullptr && chaseObj->IsDestroyed());
+}
+
 int B_Unit::GetUnitLevel() { return unitLevel; }
 
 void B_Unit::UpdatePath(int x, int y)
 {
 	if (x >= 0 && y >= 0)
 	{
+		App->groupMove.Cancel(GetHandle());
 		path = App->pathfinding.CreatePath({ int(pos.x), int(pos.y) }, { x, y }, GetID());
 
 		calculating_path = true;
@@ -859,16 +894,7 @@ void B_Unit::UpdatePath(int x, int y)
 		move = false;
 		movDest = { x, y };
 
-		if (!tilesVisited.empty())
-		{
-			for (std::vector<iPoint>::const_iterator it = tilesVisited.cbegin(); it != tilesVisited.cend(); ++it)
-			{
-				if (PathfindingManager::unitWalkability[it->x][it->y] != 0.0f)
-					PathfindingManager::unitWalkability[it->x][it->y] = 0.0f;
-			}
-
-			tilesVisited.clear();
-		}
+		ReleaseReservedTiles();
 	}
 }
 
@@ -877,21 +903,57 @@ void B_Unit::Repath()
 	if (path != nullptr && !path->empty())
 	{
 		path = App->pathfinding.CreatePath({ int(pos.x), int(pos.y) }, { movDest.x, movDest.y }, GetID());
+		repath_count->Add();
 
 		calculating_path = true;
 		next = false;
 		move = false;
 
-		if (!tilesVisited.empty())
-		{
-			for (std::vector<iPoint>::const_iterator it = tilesVisited.cbegin(); it != tilesVisited.cend(); ++it)
-			{
-				if (PathfindingManager::unitWalkability[it->x][it->y] != 0.0f)
-					PathfindingManager::unitWalkability[it->x][it->y] = 0.0f;
-			}
+		ReleaseReservedTiles();
+	}
+}
 
-			tilesVisited.clear();
-		}
+bool B_Unit::PrepareGroupMove(iPoint slot)
+{
+	if (current_state == DESTROYED)
+		return false;
+
+	audio->Play(UNIT_MOVES);
+	chaseObj = nullptr;
+
+	// Path stays empty until GroupMovement fills it from the leader path
+	App->pathfinding.DeletePendingPath(GetID());
+	App->pathfinding.UpdateStoredPaths(GetID(), std::vector<iPoint>());
+	path = App->pathfinding.GetPath(GetID());
+	movDest = slot;
+
+	next = false;
+	move = false;
+	moveOrder = true;
+	chasing = false;
+
+	ReleaseReservedTiles();
+
+	return true;
+}
+
+void B_Unit::Steer()
+{
+	float dt = App->time.GetGameDeltaTime();
+	Transform* t = game_object->GetTransform();
+
+	// Preferred velocity heads for the next tile, avoidance bends it around moving neighbours
+	velocity = App->avoidance.Solve(this, fPoint(float(dirX) * speed, float(dirY) * speed));
+
+	t->MoveX(velocity.x * dt);//Move x
+	t->MoveY(velocity.y * dt);//Move y
+
+	vec moved = t->GetGlobalPosition();
+	if (App->pathfinding.ValidTile(int(moved.x), int(moved.y)) == false)
+	{
+		t->MoveX(-velocity.x * dt);//Move x back
+		t->MoveY(-velocity.y * dt);//Move y back
+		velocity = fPoint(0.f, 0.f);
 	}
 }
 
@@ -899,22 +961,32 @@ void B_Unit::CheckPathTiles()
 {
 	if (!next)
 	{
-		if (PathfindingManager::unitWalkability[nextTile.x][nextTile.y] != 0.0f)
-			PathfindingManager::unitWalkability[nextTile.x][nextTile.y] == 0;
+		App->pathfinding.ReleaseTile(nextTile.x, nextTile.y, GetHandle());
+
+		// Raw tiles of the leg to the next waypoint, expanded again if the path changed or the unit strayed
+		iPoint tile = { int(pos.x), int(pos.y) };
+		if (segment.empty() || segment.back() != path->front()
+			|| abs(segment.front().x - tile.x) > 1 || abs(segment.front().y - tile.y) > 1)
+		{
+			StartLeg(tile);
+			if (path->empty())
+				return;
+		}
 
-		nextTile = path->front();
+		nextTile = segment.empty() ? path->front() : segment.front();
 		next = true;
 		move = true;
 		gotTile = false;
 	}
-	else if (PathfindingManager::unitWalkability[nextTile.x][nextTile.y] == 0.0f)
-	{
-		PathfindingManager::unitWalkability[nextTile.x][nextTile.y] = GetID();
-		tilesVisited.push_back(nextTile);
-		gotTile = true;
-	}
 	else if (!gotTile)
 	{
+		if (App->pathfinding.ReserveTile(nextTile.x, nextTile.y, GetHandle()))
+		{
+			tilesVisited.push_back(nextTile);
+			gotTile = true;
+			return;
+		}
+
 		iPoint cell = App->pathfinding.CheckEqualNeighbours(iPoint(int(pos.x), int(pos.y)), nextTile);
 
 		if (cell.x != -1 && cell.y != -1)
@@ -922,6 +994,33 @@ void B_Unit::CheckPathTiles()
 	}
 }
 
+void B_Unit::StartLeg(iPoint from)
+{
+	segment.clear();
+
+	if (App->pathfinding.LineOfSight(from, path->front()))
+		App->pathfinding.ExpandSegment(from, path->front(), segment);
+	else
+	{
+		// Knocked off the line: search again towards the same end
+		iPoint end = path->back();
+		path = App->pathfinding.CreatePath(from, end, GetID());
+	}
+}
+
+void B_Unit::ReachedNextTile()
+{
+	if (!segment.empty() && segment.front() == nextTile)
+		segment.erase(segment.begin());
+
+	// Waypoint reached once the last tile of its leg is
+	if (!path->empty() && nextTile == path->front())
+		path->erase(path->begin());
+
+	next = false;
+	App->pathfinding.ReleaseTile(nextTile.x, nextTile.y, GetHandle());
+}
+
 void B_Unit::ChangeState()
 {
 	//Change state to change sprite
@@ -964,81 +1063,45 @@ void B_Unit::CheckDirection(fPoint actualPos)
 	if (dirX == 1 && dirY == 1)
 	{
 		if (actualPos.x >= nextTile.x && actualPos.y >= nextTile.y)
-		{
-			if (!path->empty()) path->erase(path->begin());
-			next = false;
-			PathfindingManager::unitWalkability[nextTile.x][nextTile.y] = 0.0f;
-		}
+			ReachedNextTile();
 	}
 	else if (dirX == -1 && dirY == -1)
 	{
 		if (actualPos.x <= nextTile.x && actualPos.y <= nextTile.y)
-		{
-			if (!path->empty()) path->erase(path->begin());
-			next = false;
-			PathfindingManager::unitWalkability[nextTile.x][nextTile.y] = 0.0f;
-		}
+			ReachedNextTile();
 	}
 	else if (dirX == -1 && dirY == 1)
 	{
 		if (actualPos.x <= nextTile.x && actualPos.y >= nextTile.y)
-		{
-			if (!path->empty()) path->erase(path->begin());
-			next = false;
-			PathfindingManager::unitWalkability[nextTile.x][nextTile.y] = 0.0f;
-		}
+			ReachedNextTile();
 	}
 	else if (dirX == 1 && dirY == -1)
 	{
 		if (actualPos.x >= nextTile.x && actualPos.y <= nextTile.y)
-		{
-			if (!path->empty()) path->erase(path->begin());
-			next = false;
-			PathfindingManager::unitWalkability[nextTile.x][nextTile.y] = 0.0f;
-		}
+			ReachedNextTile();
 	}
 	else if (dirX == 0 && dirY == -1)
 	{
 		if (actualPos.y <= nextTile.y)
-		{
-			if (!path->empty()) path->erase(path->begin());
-			next = false;
-			PathfindingManager::unitWalkability[nextTile.x][nextTile.y] = 0.0f;
-		}
+			ReachedNextTile();
 	}
 	else if (dirX == 0 && dirY == 1)
 	{
 		if (actualPos.y >= nextTile.y)
-		{
-			if (!path->empty()) path->erase(path->begin());
-			next = false;
-			PathfindingManager::unitWalkability[nextTile.x][nextTile.y] = 0.0f;
-		}
+			ReachedNextTile();
 	}
 	else if (dirX == 1 && dirY == 0)
 	{
 		if (actualPos.x >= nextTile.x)
-		{
-			if (!path->empty()) path->erase(path->begin());
-			next = false;
-			PathfindingManager::unitWalkability[nextTile.x][nextTile.y] = 0.0f;
-		}
+			ReachedNextTile();
 	}
 	else if (dirX == -1 && dirY == 0)
 	{
 		if (actualPos.x <= nextTile.x)
-		{
-			if (!path->empty()) path->erase(path->begin());
-			next = false;
-			PathfindingManager::unitWalkability[nextTile.x][nextTile.y] = 0.0f;
-		}
+			ReachedNextTile();
 	}
 	else if (dirX == 0 && dirY == 0)
-	{
-		if(!path->empty()) path->erase(path->begin());
-		next = false;
-		PathfindingManager::unitWalkability[nextTile.x][nextTile.y] = 0.0f;
-	}
+		ReachedNextTile();
 
 	if (path->empty()) new_state = IDLE;
 }
@@ -1046,15 +1109,7 @@ void B_Unit::CheckDirection(fPoint actualPos)
 void B_Unit::OnDestroy()
 {
 	App->pathfinding.DeletePath(GetID());
-	if (!tilesVisited.empty())
-	{
-		for (std::vector<iPoint>::const_iterator it = tilesVisited.cbegin(); it != tilesVisited.cend(); ++it)
-		{
-			if (PathfindingManager::unitWalkability[it->x][it->y] != 0)
-				PathfindingManager::unitWalkability[it->x][it->y] = 0;
-		}
-		tilesVisited.clear();
-	}
+	ReleaseReservedTiles();
 }
 
 void B_Unit::DrawRanges()
@@ -1070,7 +1125,10 @@ void B_Unit::DrawRanges()
 
 void B_Unit::DoAttack()
 {
-	UnitAttackType();
+	// Ranged hits land with their projectile
+	if (!UnitAttackType())
+		Event::Push(DAMAGE, atkObj, damage, GetType());
+
 	std::pair<int, int> Pos(int(pos.x),int(pos.y));
 	vec objPos = atkObj->GetPos();
 	std::pair<int,int> atkPos(int(objPos.x), int(objPos.y));
@@ -1122,6 +1180,7 @@ void B_Unit::UpgradeUnit(int life, int dmg,int lvl)
 void B_Unit::OnRightClick(vec posClick, vec movPos)
 {		
 	audio->Play(UNIT_MOVES);
+	App->groupMove.Cancel(GetHandle());
 	chaseObj = nullptr;
 	SDL_Rect cam = App->render->GetCameraRect();
 	int x, y;
@@ -1129,54 +1188,22 @@ void B_Unit::OnRightClick(vec posClick, vec movPos)
 	x += cam.x;
 	y += cam.y;
 
-	for (std::map<double, Behaviour*>::iterator it = Behaviour::b_map.begin(); it != Behaviour::b_map.end(); ++it)
-	{
-		if (GetType() == GATHERER)
-		{
-			if ( it->second->GetType() == EDGE || it->second->GetType() == CAPSULE)
-			{
-				RectF coll = (*it).second->GetSelectionRect();
-				if (float(x) > coll.x && float(x) < coll.x + coll.w && float(y) > coll.y && float(y) < coll.y + coll.h)
-				{
-					chaseObj = (*it).second;
-					next = false;
-					move = false;
-					moveOrder = true;
-					chasing = false;
-					break;
-				}
-			}
-		}
-		else
-		{
-			if (it->second->GetType() == ENEMY_MELEE || it->second->GetType() == ENEMY_RANGED || it->second->GetType() == ENEMY_SUPER
-				|| it->second->GetType() == SPAWNER)
-			{
-				RectF coll = (*it).second->GetSelectionRect();
-				if (float(x) > coll.x && float(x) < coll.x + coll.w && float(y) > coll.y && float(y) < coll.y + coll.h)
-				{
-					chaseObj = (*it).second;
-					next = false;
-					move = false;
-					moveOrder = true;
-					chasing = false;
-					break;
-				}
-			}
-		}
-
-		if (!tilesVisited.empty())//Clean path tiles
-		{
-			for (std::vector<iPoint>::const_iterator it = tilesVisited.cbegin(); it != tilesVisited.cend(); ++it)
-			{
-				if (PathfindingManager::unitWalkability[it->x][it->y] != 0)
-					PathfindingManager::unitWalkability[it->x][it->y] = 0;
-			}
+	// Gatherers pick resources, combat units pick enemies
+	SpatialFilter targets = GetType() == GATHERER ?
+		SpatialFilter(UNIT_TYPE_MASK(EDGE) | UNIT_TYPE_MASK(CAPSULE)) :
+		SpatialFilter(UNIT_TYPE_MASK(ENEMY_MELEE) | UNIT_TYPE_MASK(ENEMY_RANGED) | UNIT_TYPE_MASK(ENEMY_SUPER) | UNIT_TYPE_MASK(SPAWNER));
 
-			tilesVisited.clear();
-		}
+	chaseObj = App->spatial.Pick(float(x), float(y), targets);
+	if (chaseObj != nullptr)
+	{
+		next = false;
+		move = false;
+		moveOrder = true;
+		chasing = false;
 	}
 
+	ReleaseReservedTiles();
+
 	if(chaseObj == nullptr)
 	{
 		if (movPos.x != -1 && movPos.y != -1)
@@ -1195,18 +1222,6 @@ void B_Unit::OnRightClick(vec posClick, vec movPos)
 			moveOrder = true;
 			chasing = false;
 		}
-
-		if (!tilesVisited.empty())//Clean path tiles
-		{
-			for (std::vector<iPoint>::const_iterator it = tilesVisited.cbegin(); it != tilesVisited.cend(); ++it)
-			{
-				if (PathfindingManager::unitWalkability[it->x][it->y] != 0)
-				{
-					PathfindingManager::unitWalkability[it->x][it->y] = 0;
-				}
-			}
-			tilesVisited.clear();
-		}
 	}	 
 }
  
@@ -1285,7 +1300,6 @@ BuildingWithQueue::BuildingWithQueue(Gameobject* go, UnitType type, UnitState st
 void BuildingWithQueue::Update()
 {
 	pos = game_object->GetTransform()->GetGlobalPosition();
-	if (providesVisibility) GetTilesInsideRadius();
 
 	if (!build_queue.empty())
 	{
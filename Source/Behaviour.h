@@ -15,6 +15,8 @@
 #define RAYCAST_TIME 0.1
 #define CREATION_TIME 1.0
 
+struct VisionArea;
+
 enum UnitState : int
 {
 	IDLE,
@@ -72,6 +74,9 @@ public:
 
 	void Load(pugi::xml_node& node) override;
 	void Save(pugi::xml_node& node) const override;
+	void Load(ByteReader& in) override;
+	void Save(ByteWriter& out) const override;
+	static void SkipRecord(ByteReader& in); // for types that can't be rebuilt
 
 	void Selected();
 	void UnSelected();
@@ -82,7 +87,7 @@ public:
 	void CheckFoWMap(bool debug=false);
 	bool IsDestroyed();
 	vec GetPos();
-	void GetTilesInsideRadius();
+	void GetVisionArea(VisionArea& area) const;
 	Collider* GetBodyCollider();
 	Collider* GetSelectionCollider();
 	RectF GetSelectionRect();
@@ -94,14 +99,18 @@ public:
 	virtual void create_bar() {}
 	virtual void update_health_ui() {}
 	virtual void CreatePanel() {}
+	void DestroyPanels(); // they hang from the canvas, deleting the unit leaves them. The bar dies on kill
 	virtual void UpdatePanel() {}
 	virtual void create_creation_bar() {}
 	virtual void update_creation_bar() {}
 	virtual void Upgrade() {}
 	virtual void FreeWalkabilityTiles() {}
 	virtual void Repath() {};
+	virtual bool PrepareGroupMove(iPoint slot) { return false; }
 	virtual void OnCollision(Collider selfCol, Collider col) {}
-	static bool IsHidden(double id) { return b_map[id]->visible; }
+	virtual void AcquireTargets() {}
+	virtual bool TargetLost() const { return false; }
+	static bool IsHidden(double id);
 	void SetColliders();
 
 	UnitType GetType() const { return type; }
@@ -115,10 +124,18 @@ public:
 protected:
 
 	virtual void AddUnitToQueue(UnitType type, vec pos = vec(), float time = -1) {}
+	void RemoveFromList();
+	void ReleaseReservedTiles();
 
 public: 
 	
-	static std::map<double, Behaviour*> b_map;
+	static std::vector<Behaviour*> b_list; // dense, unordered
+	int b_index = -1;
+	unsigned int spawn_id = 0u; // CommandStream ordinal this match, 0 if spawned outside one
+	int spatial_cell = -1, spatial_slot = -1; // SpatialIndex bucket
+	float retarget_timer = -1.f; // TargetingService countdown, < 0 until first slice
+	int avoidance_agent = -1; // LocalAvoidance snapshot slot
+	fPoint velocity = fPoint(0.f, 0.f); // map tiles/s steered this tick
 	UnitState current_state, new_state;
 	UnitState spriteState;
 	vec pos;
@@ -127,14 +144,10 @@ public:
 	AnimatedSprite* characteR = nullptr;
 	bool providesVisibility,visible;
 	Collider* bodyColl = nullptr;
-	Collider* visionColl = nullptr;
-	Collider* attackColl = nullptr;
 	Collider* selColl = nullptr;
 	RectF selectionRect;
 	std::pair<int,int> selectionOffset;
 	std::pair<float, float> baseCollOffset;
-	std::pair<float, float> visionCollOffset;
-	std::pair<float, float>	attackCollOffset;
 
 protected:	
 
@@ -235,15 +248,29 @@ public:
 	void OnDestroy() override;
 	void UpdatePath(int x, int y) override;
 	void CheckPathTiles();
+	void StartLeg(iPoint from);
+	void ReachedNextTile();
+	void Steer();
 	void ChangeState();
 	void CheckDirection(fPoint actualPos);
 	void DrawRanges();
 	void UpgradeUnit(int life, int damage, int lvl);
 	void Repath() override;
-	virtual void UnitAttackType() {}
-	void OnCollision(Collider selfCol, Collider col) override;
+	bool PrepareGroupMove(iPoint slot) override;
+	virtual bool UnitAttackType() { return false; } // true when a projectile carries the damage
+	void AcquireTargets() override;
+	bool TargetLost() const override;
 	int GetUnitLevel();
 
+	// UnitPool: dead units are parked, spawns revive them at full health
+	void Park();
+	void Revive();
+
+protected:
+
+	void ResetState();
+	virtual void ResetStats() {} // each unit's base stats, upgrades are reapplied on spawn
+
 protected:
 
 	int unitLevel;
@@ -253,7 +280,8 @@ protected:
 	Audio_FX attackFX;
 	vec attackPos;
 	iPoint movDest;
-	std::vector<iPoint>* path;
+	std::vector<iPoint>* path; // waypoints
+	std::vector<iPoint> segment; // raw tiles left on the leg to path->front()
 	std::pair<int, int> destPos;
 	iPoint nextTile;
 	bool next;
@@ -0,0 +1,466 @@
+#include "BenchmarkScenario.h"
+#include "Application.h"
+#include "Scene.h"
+#include "Behaviour.h"
+#include "Gameobject.h"
+#include "Transform.h"
+#include "PathfindingManager.h"
+#include "GroupMovement.h"
+#include "Counters.h"
+#include "Map.h"
+#include "ParticleSystem.h"
+#include "Log.h"
+
+#include "SDL/include/SDL_timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* scenario_names[MAX_SCENARIOS] = { "waves", "churn", "choke", "saveload", "particles" };
+
+BenchmarkScenario::BenchmarkScenario()
+{}
+
+BenchmarkScenario::~BenchmarkScenario()
+{}
+
+bool BenchmarkScenario::Set(const char* name)
+{
+	for (int i = 0; i < MAX_SCENARIOS; ++i)
+	{
+		if (strcmp(name, scenario_names[i]) == 0)
+		{
+			type = ScenarioType(i);
+			return true;
+		}
+	}
+
+	LOG("Unknown benchmark scenario %s", name);
+	return false;
+}
+
+ScenarioType BenchmarkScenario::GetType() const
+{
+	return type;
+}
+
+const char* BenchmarkScenario::GetName() const
+{
+	return scenario_names[type];
+}
+
+void BenchmarkScenario::Begin()
+{
+	units.clear();
+	spawned = killed = 0u;
+	peak_reserved = peak_stale = 0u;
+	settled_stale = settled_checks = 0u;
+	crossed = half_frame = all_frame = ticks = 0u;
+	overlaps = repaths = 0;
+	rounds = entities = loaded_entities = save_bytes = 0u;
+	for (int i = 0; i < MAX_SAVE_PHASES; ++i)
+		phase_total[i] = phase_max[i] = 0.0;
+	towers.assign(PARTICLES_TOWERS, ComponentHandle());
+	built = strays = peak_particles = 0u;
+	particle_ticks = 0;
+	ready = false;
+	running = (type != SCENARIO_WAVES);
+}
+
+void BenchmarkScenario::Update(unsigned int frame)
+{
+	if (!running)
+		return;
+
+	// The match begins before the map loads: look for room on the first tick
+	if (!ready)
+	{
+		std::pair<int, int> base = Map::WorldToTileBase(300.0f, 4600.0f);
+		iPoint near = { base.first, base.second };
+		switch (type)
+		{
+		case SCENARIO_CHOKE: area_side = CHOKE_AREA; break;
+		case SCENARIO_SAVELOAD: area_side = SAVELOAD_AREA; break;
+		case SCENARIO_PARTICLES: area_side = PARTICLES_AREA; near.x += PARTICLES_BASE_DISTANCE; break; // out of enemy sight
+		default: area_side = CHURN_AREA; break;
+		}
+
+		if (!FindOpenArea(near, area_side, area))
+		{
+			LOG("Benchmark %s: no %dx%d walkable area on the map", GetName(), area_side, area_side);
+			running = false;
+			return;
+		}
+
+		ready = true;
+
+		if (type == SCENARIO_CHOKE)
+			StartChoke();
+		else if (type == SCENARIO_SAVELOAD)
+			StartSaveLoad();
+	}
+
+	switch (type)
+	{
+	case SCENARIO_CHURN: UpdateChurn(frame); break;
+	case SCENARIO_CHOKE: UpdateChoke(frame); break;
+	case SCENARIO_SAVELOAD: UpdateSaveLoad(frame); break;
+	case SCENARIO_PARTICLES: UpdateParticles(frame); break;
+	default: break;
+	}
+}
+
+void BenchmarkScenario::UpdateChurn(unsigned int frame)
+{
+	// Dead units were parked or deleted: their handles stop resolving
+	for (std::vector<ComponentHandle>::iterator it = units.begin(); it != units.end();)
+	{
+		Component* comp = Component::Get(*it);
+		if (comp == nullptr || comp->AsBehaviour()->IsDestroyed())
+			it = units.erase(it);
+		else
+			++it;
+	}
+
+	unsigned int stale = App->pathfinding.GetStaleTileCount();
+	unsigned int reserved = App->pathfinding.GetReservedTileCount();
+	if (stale > peak_stale) peak_stale = stale;
+	if (reserved > peak_reserved) peak_reserved = reserved;
+
+	// Killed units release their tiles as they die: past a round, any stale tile leaked
+	if (killed > 0u && frame % CHURN_INTERVAL == CHURN_INTERVAL - 1u)
+	{
+		settled_stale = stale;
+		settled_checks++;
+	}
+
+	if (frame % CHURN_INTERVAL != 0u)
+		return;
+
+	// Kill a random half once crowded, mid walk and holding tiles
+	if (units.size() >= CHURN_MAX_UNITS)
+	{
+		for (unsigned int i = units.size() / 2u; i > 0u; --i)
+		{
+			unsigned int victim = unsigned(std::rand()) % units.size();
+			Behaviour* unit = Component::Get(units[victim])->AsBehaviour();
+			Event::Push(DAMAGE, unit, unit->current_life, int(UNKNOWN));
+			units[victim] = units.back();
+			units.pop_back();
+			killed++;
+		}
+	}
+
+	for (unsigned int i = 0u; i < CHURN_BATCH; ++i)
+	{
+		Transform* t = SpawnUnit(RandomTile());
+		if (t != nullptr && t->GetGameobject()->GetBehaviour() != nullptr)
+		{
+			units.push_back(t->GetGameobject()->GetBehaviour()->GetHandle());
+			spawned++;
+		}
+	}
+
+	// Everyone alive walks somewhere new: repaths release and reserve tiles
+	for (std::vector<ComponentHandle>::const_iterator it = units.cbegin(); it != units.cend(); ++it)
+	{
+		iPoint dest = RandomTile();
+		Event::Push(ON_RIGHT_CLICK, Component::Get(*it)->GetGameobject(), vec(float(dest.x), float(dest.y), 0.5f), vec(-1, -1, -1));
+	}
+}
+
+void BenchmarkScenario::StartChoke()
+{
+	// Wall down the middle of the area with a gap at its centre
+	wall_x = area.x + area_side / 2;
+	int gap_y = area.y + area_side / 2;
+	for (int y = area.y; y < area.y + area_side; ++y)
+		if (abs(y - gap_y) > CHOKE_GAP / 2)
+			App->pathfinding.SetWalkabilityTile(wall_x, y, false);
+
+	// Everyone packed on the west side, one per tile
+	for (int x = area.x; x < wall_x - 1 && units.size() < CHOKE_UNITS; ++x)
+	{
+		for (int y = area.y; y < area.y + area_side && units.size() < CHOKE_UNITS; ++y)
+		{
+			Transform* t = SpawnUnit({ x, y });
+			if (t != nullptr && t->GetGameobject()->GetBehaviour() != nullptr)
+			{
+				units.push_back(t->GetGameobject()->GetBehaviour()->GetHandle());
+				spawned++;
+			}
+		}
+	}
+
+	// Groups head for destinations spread over the east side
+	std::vector<Behaviour*> group;
+	for (unsigned int first = 0u; first < units.size(); first += CHOKE_GROUP)
+	{
+		group.clear();
+		for (unsigned int i = first; i < units.size() && i < first + CHOKE_GROUP; ++i)
+			group.push_back(Component::Get(units[i])->AsBehaviour());
+
+		unsigned int index = first / CHOKE_GROUP;
+		iPoint dest = { wall_x + area_side / 8 + int(index % 2u) * area_side / 4, area.y + area_side / 10 + int(index / 2u % 5u) * area_side / 5 };
+		App->groupMove.IssueOrder(group, dest);
+	}
+}
+
+void BenchmarkScenario::UpdateChoke(unsigned int frame)
+{
+	static Counter* overlap_count = Counters::Find("collision/overlaps resolved");
+	static Counter* repath_count = Counters::Find("units/repaths");
+
+	// Last finished frame
+	if (ticks > 0u)
+	{
+		overlaps += overlap_count->GetLast();
+		repaths += repath_count->GetLast();
+	}
+	ticks++;
+
+	unsigned int alive = 0u;
+	crossed = 0u;
+	for (std::vector<ComponentHandle>::const_iterator it = units.cbegin(); it != units.cend(); ++it)
+	{
+		Component* comp = Component::Get(*it);
+		if (comp != nullptr)
+		{
+			alive++;
+			if (comp->AsBehaviour()->GetPos().x > float(wall_x))
+				crossed++;
+		}
+	}
+
+	if (half_frame == 0u && crossed * 2u >= units.size())
+		half_frame = frame;
+	if (all_frame == 0u && alive > 0u && crossed == alive)
+		all_frame = frame;
+}
+
+void BenchmarkScenario::StartSaveLoad()
+{
+	// Units fill the area until the scene holds enough behaviours
+	for (int i = 0; i < area_side * area_side && Behaviour::b_list.size() < SAVELOAD_ENTITIES; ++i)
+	{
+		if (SpawnUnit({ area.x + i % area_side, area.y + i / area_side }) != nullptr)
+			spawned++;
+	}
+}
+
+void BenchmarkScenario::UpdateSaveLoad(unsigned int frame)
+{
+	if (rounds >= SAVELOAD_ROUNDS || frame == 0u || frame % SAVELOAD_INTERVAL != 0u)
+		return;
+
+	double ms[MAX_SAVE_PHASES];
+	double to_ms = 1000.0 / double(SDL_GetPerformanceFrequency());
+	entities = Behaviour::b_list.size();
+
+	unsigned long long start = SDL_GetPerformanceCounter();
+	App->scene->SaveGameNow();
+	unsigned long long captured = SDL_GetPerformanceCounter();
+	save_bytes = App->scene->WaitForSave();
+	unsigned long long written = SDL_GetPerformanceCounter();
+	App->scene->LoadGameNow();
+	unsigned long long loaded = SDL_GetPerformanceCounter();
+
+	ms[SAVE_CAPTURE] = double(captured - start) * to_ms;
+	ms[SAVE_WRITE] = double(written - captured) * to_ms;
+	ms[SAVE_LOAD] = double(loaded - written) * to_ms;
+
+	for (int i = 0; i < MAX_SAVE_PHASES; ++i)
+	{
+		phase_total[i] += ms[i];
+		if (ms[i] > phase_max[i]) phase_max[i] = ms[i];
+	}
+
+	loaded_entities = Behaviour::b_list.size();
+	rounds++;
+}
+
+void BenchmarkScenario::UpdateParticles(unsigned int frame)
+{
+	unsigned int alive = App->particleSys.GetCount();
+	if (alive > peak_particles) peak_particles = alive;
+	particle_ticks += alive;
+	ticks++;
+
+	if (frame % PARTICLES_INTERVAL != 0u)
+		return;
+
+	// Towers go up on the first tick and again wherever one fell, each one paid for
+	int line_x = area.x + area_side - 4;
+	int first_y = area.y + (area_side - int(PARTICLES_TOWERS)) / 2;
+	for (unsigned int i = 0u; i < PARTICLES_TOWERS; ++i)
+	{
+		Component* comp = Component::Get(towers[i]);
+		if (comp != nullptr && !comp->AsBehaviour()->IsDestroyed())
+			continue;
+
+		App->scene->UpdateStat(CURRENT_EDGE, TOWER_COST);
+		Transform* t = App->scene->SpawnBehaviour(TOWER, vec(float(line_x), float(first_y + int(i))));
+		if (t != nullptr && t->GetGameobject()->GetBehaviour() != nullptr)
+		{
+			towers[i] = t->GetGameobject()->GetBehaviour()->GetHandle();
+			built++;
+		}
+	}
+
+	if (frame < PARTICLES_FIRST_WAVE)
+		return;
+
+	// Enemies left without a target march on the base: strays that leave the area die
+	for (std::vector<ComponentHandle>::iterator it = units.begin(); it != units.end();)
+	{
+		Component* comp = Component::Get(*it);
+		if (comp == nullptr || comp->AsBehaviour()->IsDestroyed())
+		{
+			it = units.erase(it);
+			continue;
+		}
+
+		Behaviour* unit = comp->AsBehaviour();
+		vec pos = unit->GetPos();
+		if (pos.x < float(area.x) || pos.y < float(area.y) || pos.x >= float(area.x + area_side) || pos.y >= float(area.y + area_side))
+		{
+			Event::Push(DAMAGE, unit, unit->current_life, int(UNKNOWN));
+			strays++;
+			it = units.erase(it);
+		}
+		else
+			++it;
+	}
+
+	// Ranged enemies within sight of the line, both sides in range of each other
+	for (unsigned int i = 0u; i < PARTICLES_WAVE && units.size() < PARTICLES_MAX_ENEMIES; ++i)
+	{
+		vec pos(float(line_x - 8 - std::rand() % 4), float(area.y + std::rand() % area_side));
+		Transform* t = App->scene->SpawnBehaviour(ENEMY_RANGED, pos);
+		if (t != nullptr && t->GetGameobject()->GetBehaviour() != nullptr)
+		{
+			units.push_back(t->GetGameobject()->GetBehaviour()->GetHandle());
+			spawned++;
+		}
+	}
+}
+
+bool BenchmarkScenario::Report() const
+{
+	if (type == SCENARIO_WAVES)
+		return true;
+
+	bool ret = true;
+	char line[256];
+
+	if (type == SCENARIO_CHURN)
+	{
+		// A stale tile still holds a dead or dying unit: its reservation leaked
+		snprintf(line, 256, "churn: %u units spawned, %u killed, %u alive. Reserved tiles: %u now, %u peak. Stale tiles: %u now, %u peak",
+			spawned, killed, (unsigned int)units.size(), App->pathfinding.GetReservedTileCount(), peak_reserved,
+			App->pathfinding.GetStaleTileCount(), peak_stale);
+		Print(line);
+
+		if (settled_checks == 0u)
+		{
+			Print("churn: FAILED, no kill round settled, run it longer");
+			ret = false;
+		}
+		else if (settled_stale > 0u)
+		{
+			snprintf(line, 256, "churn: FAILED, %u tiles still held by dead units after the last kill round", settled_stale);
+			Print(line);
+			ret = false;
+		}
+		else
+		{
+			snprintf(line, 256, "churn: passed, no stale tiles after %u kill rounds", settled_checks);
+			Print(line);
+		}
+	}
+	else if (type == SCENARIO_CHOKE)
+	{
+		snprintf(line, 256, "choke: %u units through a %d tile gap, %u across. Half across at tick %u, all at tick %u (0: not reached)",
+			spawned, CHOKE_GAP, crossed, half_frame, all_frame);
+		Print(line);
+
+		unsigned int frames = ticks > 0u ? ticks : 1u;
+		snprintf(line, 256, "choke: %lld overlaps resolved (%.1f/tick), %lld repaths (%.2f/tick)",
+			overlaps, double(overlaps) / double(frames), repaths, double(repaths) / double(frames));
+		Print(line);
+	}
+	else if (type == SCENARIO_SAVELOAD)
+	{
+		snprintf(line, 256, "saveload: %u rounds, %u entities saved into %u KB, %u loaded back", rounds, entities, save_bytes / 1024u, loaded_entities);
+		Print(line);
+
+		static const char* phase_names[MAX_SAVE_PHASES] = { "capture", "write", "load" };
+		double count = rounds > 0u ? double(rounds) : 1.0;
+		for (int i = 0; i < MAX_SAVE_PHASES; ++i)
+		{
+			snprintf(line, 256, "saveload %-8s mean %9.3f ms, max %9.3f ms", phase_names[i], phase_total[i] / count, phase_max[i]);
+			Print(line);
+		}
+	}
+	else if (type == SCENARIO_PARTICLES)
+	{
+		snprintf(line, 256, "particles: %u towers built, %u enemies spawned, %u strays killed, %u alive. In flight: %.1f mean, %u peak",
+			built, spawned, strays, (unsigned int)units.size(), double(particle_ticks) / double(ticks > 0u ? ticks : 1u), peak_particles);
+		Print(line);
+	}
+
+	return ret;
+}
+
+bool BenchmarkScenario::FindOpenArea(iPoint near, int side, iPoint& corner) const
+{
+	std::pair<int, int> size = Map::GetMapSize_I();
+	int w = size.first, h = size.second;
+	if (w < side || h < side)
+		return false;
+
+	// Summed walkable tiles: every square is checked in constant time
+	std::vector<int> sums((w + 1) * (h + 1), 0);
+	for (int y = 0; y < h; ++y)
+		for (int x = 0; x < w; ++x)
+			sums[(x + 1) + (y + 1) * (w + 1)] = (App->pathfinding.ValidTile(x, y) ? 1 : 0)
+				+ sums[x + (y + 1) * (w + 1)] + sums[(x + 1) + y * (w + 1)] - sums[x + y * (w + 1)];
+
+	int best = -1;
+	for (int y = 0; y + side <= h; ++y)
+	{
+		for (int x = 0; x + side <= w; ++x)
+		{
+			int walkable = sums[(x + side) + (y + side) * (w + 1)] - sums[x + (y + side) * (w + 1)]
+				- sums[(x + side) + y * (w + 1)] + sums[x + y * (w + 1)];
+
+			int dist = abs(x + side / 2 - near.x) + abs(y + side / 2 - near.y);
+			if (walkable == side * side && (best < 0 || dist < best))
+			{
+				best = dist;
+				corner = { x, y };
+			}
+		}
+	}
+
+	return best >= 0;
+}
+
+Transform* BenchmarkScenario::SpawnUnit(iPoint tile) const
+{
+	// Matches start with next to no edge: player units would be refused
+	App->scene->UpdateStat(CURRENT_EDGE, MELEE_COST);
+	return App->scene->SpawnBehaviour(UNIT_MELEE, vec(float(tile.x), float(tile.y)));
+}
+
+iPoint BenchmarkScenario::RandomTile() const
+{
+	return { area.x + std::rand() % area_side, area.y + std::rand() % area_side };
+}
+
+void BenchmarkScenario::Print(const char* line) const
+{
+	printf("%s\n", line);
+	LOG("%s", line);
+}
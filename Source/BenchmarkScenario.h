@@ -0,0 +1,120 @@
+#ifndef __BENCHMARK_SCENARIO_H__
+#define __BENCHMARK_SCENARIO_H__
+
+#include "Component.h"
+#include "Point.h"
+
+#include <vector>
+
+#define CHURN_AREA 24			// tiles per side of the open square units churn in
+#define CHURN_INTERVAL 20u		// ticks between spawn and kill rounds
+#define CHURN_BATCH 24u			// units spawned per round
+#define CHURN_MAX_UNITS 160u	// alive at once, rounds kill half of them past it
+#define CHOKE_AREA 40			// tiles per side, split by a wall down the middle
+#define CHOKE_GAP 3				// tiles open in the wall
+#define CHOKE_UNITS 500u
+#define CHOKE_GROUP 50u			// units per group order
+#define SAVELOAD_ENTITIES 1000u	// behaviours in the scene when saving
+#define SAVELOAD_AREA 32		// tiles per side, one unit each
+#define SAVELOAD_INTERVAL 60u	// ticks between save and load rounds
+#define SAVELOAD_ROUNDS 5u
+#define PARTICLES_AREA 32		// tiles per side, the tower line stands near its east side
+#define PARTICLES_BASE_DISTANCE 40	// tiles east of the base the area is looked for from
+#define PARTICLES_TOWERS 24u	// in the line, one per tile
+#define PARTICLES_INTERVAL 60u	// ticks between waves, fallen towers are rebuilt with them
+#define PARTICLES_FIRST_WAVE 300u	// ticks, towers take 5 s to build
+#define PARTICLES_WAVE 40u		// ranged enemies per wave
+#define PARTICLES_MAX_ENEMIES 320u
+
+class Transform;
+
+enum ScenarioType : int
+{
+	SCENARIO_WAVES,	// enemy spawners and waves from the first tick
+	SCENARIO_CHURN,	// units spawned, ordered and killed nonstop: tile reservation leaks
+	SCENARIO_CHOKE,	// CHOKE_UNITS funnelling through a narrow gap: crowd avoidance
+	SCENARIO_SAVELOAD, // snapshot save and load rounds of SAVELOAD_ENTITIES
+	SCENARIO_PARTICLES, // a tower line trading shots with ranged enemy waves: projectile load
+	MAX_SCENARIOS
+};
+
+// Scripted benchmark matches. Waves is driven by a replayed command, the
+// others act on the scene every tick from a quiet map (no spawners), with
+// std::rand seeded by the benchmark so every run is the same match. Each
+// prints its own figures after the frame time report. Churn fails the run
+// when dead units still hold tiles once their kills had time to settle.
+class BenchmarkScenario
+{
+public:
+
+	BenchmarkScenario();
+	~BenchmarkScenario();
+
+	bool Set(const char* name); // false if unknown
+	ScenarioType GetType() const;
+	const char* GetName() const;
+
+	void Begin();
+	void Update(unsigned int frame);
+	bool Report() const; // false if the scenario's check failed
+
+private:
+
+	void UpdateChurn(unsigned int frame);
+	void StartChoke();
+	void UpdateChoke(unsigned int frame);
+	void StartSaveLoad();
+	void UpdateSaveLoad(unsigned int frame);
+	void UpdateParticles(unsigned int frame);
+
+	Transform* SpawnUnit(iPoint tile) const; // melee unit paid for by the scenario
+
+	// Closest square of walkable tiles to near, false if the map has none
+	bool FindOpenArea(iPoint near, int side, iPoint& corner) const;
+	iPoint RandomTile() const; // inside the open area
+	void Print(const char* line) const;
+
+private:
+
+	ScenarioType type = SCENARIO_WAVES;
+	bool running = false;
+	bool ready = false; // open area found
+	iPoint area = { 0, 0 };
+	int area_side = 0;
+
+	// Churn
+	std::vector<ComponentHandle> units;
+	unsigned int spawned = 0u;
+	unsigned int killed = 0u;
+	unsigned int peak_reserved = 0u;
+	unsigned int peak_stale = 0u;
+	unsigned int settled_stale = 0u;	// the tick before a round, kills had CHURN_INTERVAL - 1 ticks to let go
+	unsigned int settled_checks = 0u;
+
+	// Choke
+	int wall_x = 0;
+	unsigned int crossed = 0u;
+	unsigned int half_frame = 0u;	// first tick with half the units across, 0 until then
+	unsigned int all_frame = 0u;	// and with all of them
+	unsigned int ticks = 0u;			// run by choke and particles
+	long long overlaps = 0;
+	long long repaths = 0;
+
+	// Save and load: capture, write and load times in ms
+	enum SavePhase : int { SAVE_CAPTURE, SAVE_WRITE, SAVE_LOAD, MAX_SAVE_PHASES };
+	unsigned int rounds = 0u;
+	unsigned int entities = 0u;
+	unsigned int loaded_entities = 0u;
+	unsigned int save_bytes = 0u;
+	double phase_total[MAX_SAVE_PHASES] = {};
+	double phase_max[MAX_SAVE_PHASES] = {};
+
+	// Particles: towers by slot down the line, enemies share units
+	std::vector<ComponentHandle> towers;
+	unsigned int built = 0u;
+	unsigned int strays = 0u;
+	unsigned int peak_particles = 0u;
+	long long particle_ticks = 0;	// particles alive summed over ticks
+};
+
+#endif // __BENCHMARK_SCENARIO_H__
@@ -0,0 +1,106 @@
+#ifndef __BYTE_STREAM_H__
+#define __BYTE_STREAM_H__
+
+#include <string>
+#include <vector>
+#include <string.h>
+
+// Little endian, unpadded binary records for cooked assets and snapshots.
+// Only plain old data goes through Write/Read; strings and arrays carry
+// a 32 bit count in front.
+class ByteWriter
+{
+public:
+
+	ByteWriter(std::string& buffer) : buffer(buffer) {}
+
+	template<typename T>
+	void Write(const T& value)
+	{
+		buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	void WriteString(const std::string& value)
+	{
+		Write(static_cast<unsigned int>(value.size()));
+		buffer.append(value);
+	}
+
+	template<typename T>
+	void WriteArray(const std::vector<T>& values)
+	{
+		Write(static_cast<unsigned int>(values.size()));
+		if (!values.empty())
+			buffer.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+	}
+
+	unsigned int Size() const { return buffer.size(); }
+
+private:
+
+	std::string& buffer;
+};
+
+// Reads stop at the end of the buffer: every call past it fails and
+// leaves the value untouched, so a record can be checked once at the end
+class ByteReader
+{
+public:
+
+	ByteReader(const char* data, unsigned int size) : cursor(data), end(data + size) {}
+
+	template<typename T>
+	bool Read(T& value)
+	{
+		if (!Has(sizeof(T)))
+			return false;
+
+		memcpy(&value, cursor, sizeof(T));
+		cursor += sizeof(T);
+		return true;
+	}
+
+	bool ReadString(std::string& value)
+	{
+		unsigned int size = 0u;
+		if (!Read(size) || !Has(size))
+			return false;
+
+		value.assign(cursor, size);
+		cursor += size;
+		return true;
+	}
+
+	template<typename T>
+	bool ReadArray(std::vector<T>& values)
+	{
+		unsigned int count = 0u;
+		if (!Read(count) || !Has(count) || !Has(count * sizeof(T)))
+			return false;
+
+		values.resize(count);
+		if (count > 0u)
+			memcpy(values.data(), cursor, count * sizeof(T));
+		cursor += count * sizeof(T);
+		return true;
+	}
+
+	bool Has(unsigned int bytes)
+	{
+		if (good && (unsigned int)(end - cursor) < bytes)
+			good = false;
+
+		return good;
+	}
+
+	bool Good() const { return good; }
+	const char* Cursor() const { return cursor; }
+
+private:
+
+	const char* cursor;
+	const char* end;
+	bool good = true;
+};
+
+#endif // __BYTE_STREAM_H__
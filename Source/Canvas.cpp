@@ -184,7 +184,11 @@ void C_Button::PreUpdate()
 		case KEY_UP:
 		{
 			state = BUTTON_HOVERED;
-			if(clikable) Event::Push(event_triggered);
+			if (clikable)
+			{
+				Event::Push(event_triggered);
+				App->commands.Record(event_triggered);
+			}
 			break;
 		}
 		}
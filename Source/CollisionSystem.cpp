@@ -7,9 +7,24 @@
 #include "Map.h"
 #include "Event.h"
 #include "Log.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
 #include "Behaviour.h"
+#include "Counters.h"
 
 #include <vector>
+#include <algorithm>
+
+// Vision and attack ranges are spatial queries now: their layers stay empty and get no gauge
+static Counter* active_count[MAX_COLLISION_LAYERS] = {
+	Counters::Find("collision/active/default", COUNTER_GAUGE),
+	Counters::Find("collision/active/scene", COUNTER_GAUGE),
+	Counters::Find("collision/active/body", COUNTER_GAUGE),
+	nullptr,
+	nullptr };
+static Counter* broadphase_count = Counters::Find("collision/broadphase candidates");
+static Counter* narrowphase_count = Counters::Find("collision/narrowphase hits");
+static Counter* overlap_count = Counters::Find("collision/overlaps resolved");
 
 CollisionSystem::CollisionSystem()
 {
@@ -27,10 +42,6 @@ CollisionSystem::CollisionSystem()
 	collisionLayers[DEFAULT_COLL_LAYER][SCENE_COLL_LAYER] = true;
 	collisionLayers[BODY_COLL_LAYER][SCENE_COLL_LAYER] = true;
 	collisionLayers[SCENE_COLL_LAYER][BODY_COLL_LAYER] = true;
-	collisionLayers[BODY_COLL_LAYER][VISION_COLL_LAYER] = true;
-	collisionLayers[VISION_COLL_LAYER][BODY_COLL_LAYER] = true;
-	collisionLayers[BODY_COLL_LAYER][ATTACK_COLL_LAYER] = true;
-	collisionLayers[ATTACK_COLL_LAYER][BODY_COLL_LAYER] = true;
 	collisionTree = new Quadtree(10, 5, 0, { 0,0,14500,9000 }, nullptr);
 	debug = false;
 }
@@ -86,43 +97,53 @@ void CollisionSystem::Add(Collider* coll)
 	}
 }
 
+void CollisionSystem::Remove(Collider* coll)
+{
+	if (coll != nullptr)
+	{
+		std::vector<Collider*>& layer = layerColliders[coll->GetCollLayer()];
+		std::vector<Collider*>::iterator it = std::find(layer.begin(), layer.end(), coll);
+		if (it != layer.end())
+			layer.erase(it);
+	}
+}
+
 void CollisionSystem::ProcessRemovals()
 {
-	std::vector<Collider*> cache;
+	// Compacted in place, keeping the order
 	for (int i = 0; i < MAX_COLLISION_LAYERS; i++)
 	{
-		if (!layerColliders[i].empty())
-		{
-			for (std::vector<Collider*>::iterator it = layerColliders[i].begin(); it != layerColliders[i].end(); ++it)
-			{
-				if ((*it)->GetGameobject()->GetBehaviour()->IsDestroyed() == false) cache.push_back((*it)); 
-			}
-			layerColliders[i].clear();
-			if (!cache.empty()) { layerColliders[i] = cache; cache.clear(); }			
-		}
+		std::vector<Collider*>& layer = layerColliders[i];
+		std::vector<Collider*>::iterator last = layer.begin();
+		for (std::vector<Collider*>::iterator it = layer.begin(); it != layer.end(); ++it)
+			if ((*it)->GetGameobject()->GetBehaviour()->IsDestroyed() == false)
+				*last++ = *it;
+
+		layer.erase(last, layer.end());
 	}
 }
 
 void CollisionSystem::ProcessRemovals(double id)
 {
-	std::vector<Collider*> cache;
 	for (int i = 0; i < MAX_COLLISION_LAYERS; i++)
 	{
-		if (!layerColliders[i].empty())
+		std::vector<Collider*>& layer = layerColliders[i];
+		std::vector<Collider*>::iterator last = layer.begin();
+		for (std::vector<Collider*>::iterator it = layer.begin(); it != layer.end(); ++it)
 		{
-			for (std::vector<Collider*>::iterator it = layerColliders[i].begin(); it != layerColliders[i].end(); ++it)
-			{
-				if ((*it)->GetGoID() != id) cache.push_back(*it);
-				else (*it)->SetInactive();
-			}
-			if (!cache.empty()) layerColliders[i] = cache;
-			cache.clear();
+			if ((*it)->GetGoID() != id) *last++ = *it;
+			else (*it)->SetInactive();
 		}
+
+		layer.erase(last, layer.end());
 	}
 }
 
 void CollisionSystem::Resolve()
 {
+	FrameVector<Collider*> collisions;
+	collisions.reserve(activeColliders.size());
+
 	for (int i = 0; i < MAX_COLLISION_LAYERS; i++)
 	{
 		if (layerColliders[i].empty()) continue;
@@ -131,10 +152,12 @@ void CollisionSystem::Resolve()
 		{
 			if (!(*it)->GetGameobject()->GetStatic())//static object not collision resolve
 			{
-				std::vector<Collider*> collisions = collisionTree->Search(*(*it));
+				collisions.clear();
+				collisionTree->Search(*(*it), collisions);
+				broadphase_count->Add(collisions.size());
 				if (!collisions.empty())
 				{
-					for (std::vector<Collider*>::iterator itColls = collisions.begin(); itColls != collisions.end(); ++itColls)//For each posible detection in quad tree
+					for (FrameVector<Collider*>::iterator itColls = collisions.begin(); itColls != collisions.end(); ++itColls)//For each posible detection in quad tree
 					{
 						if (((*it)->GetID() != (*itColls)->GetID() && (*it)->GetGoID() != (*itColls)->GetGoID())
 							&& (collisionLayers[(*it)->GetCollLayer()][(*itColls)->GetCollLayer()]))
@@ -142,11 +165,16 @@ void CollisionSystem::Resolve()
 							Manifold m = (*it)->Intersects(*itColls);
 							if (m.colliding)
 							{
-								Event::Push(ON_COLLISION, (*it)->parentGo, (*it)->GetID(), (*itColls)->GetID());
-								Event::Push(ON_COLLISION, (*itColls)->parentGo, (*itColls)->GetID(), (*it)->GetID());
+								narrowphase_count->Add();
+								Event::Push(ON_COLLISION, (*it)->parentGo, (*it)->GetHandle(), (*itColls)->GetHandle());
+								Event::Push(ON_COLLISION, (*itColls)->parentGo, (*itColls)->GetHandle(), (*it)->GetHandle());
 
-								if ((*it)->GetCollType() != TRIGGER && (*itColls)->GetCollType() != TRIGGER)
+								// Pairs steering this tick already avoid each other, both sides see the same test
+								if ((*it)->GetCollType() != TRIGGER && (*itColls)->GetCollType() != TRIGGER && !(IsSteering(*it) && IsSteering(*itColls)))
+								{
 									(*it)->ResolveOverlap(m);
+									overlap_count->Add();
+								}
 							}
 						}
 					}
@@ -157,27 +185,63 @@ void CollisionSystem::Resolve()
 }
 
 
+bool CollisionSystem::IsSteering(const Collider* collider) const
+{
+	const Behaviour* b = collider->parentGo->GetBehaviour();
+	return b != nullptr && (b->velocity.x != 0.f || b->velocity.y != 0.f);
+}
+
 void CollisionSystem::Update()
 {
+	MemoryScope mem(MEM_COLLISION);
+	PROFILE_SCOPE("Collisions");
+
 	collisionTree->Clear();
 	ProcessRemovals();
+
+	activeColliders.clear();
 	for (int i = 0; i < MAX_COLLISION_LAYERS; i++)
 	{
+		unsigned int layer_begin = activeColliders.size();
 		if (!layerColliders[i].empty())
 		{
 			for (std::vector<Collider*>::iterator it = layerColliders[i].begin(); it != layerColliders[i].end(); ++it)
-			{
 				if ((*it)->IsActive() && (*it)->GetGameobject()->GetBehaviour()->GetState() != DESTROYED)
-				{
-					(*it)->SetPosition();
-					collisionTree->Insert(*it);
-				}
-			}
+					activeColliders.push_back(*it);
 		}
+
+		if (active_count[i] != nullptr)
+			active_count[i]->Set(activeColliders.size() - layer_begin);
 	}
 
+	// Broad phase: collider positions in parallel batches, then the quadtree
+	// build once all of them finished (Quadtree insertion is not thread safe)
+	std::vector<JobHandle> positions;
+	for (unsigned int begin = 0u; begin < activeColliders.size(); begin += COLLIDER_BATCH_SIZE)
+	{
+		unsigned int end = begin + COLLIDER_BATCH_SIZE;
+		if (end > activeColliders.size()) end = (unsigned int)activeColliders.size();
+
+		positions.push_back(App->jobs.Schedule("Collider Positions", [this, begin, end]()
+		{
+			for (unsigned int i = begin; i < end; ++i)
+				activeColliders[i]->SetPosition();
+		}));
+	}
+
+	JobHandle tree_build = App->jobs.Schedule("Quadtree Build", [this]()
+	{
+		for (std::vector<Collider*>::iterator it = activeColliders.begin(); it != activeColliders.end(); ++it)
+			collisionTree->Insert(*it);
+	}, positions);
+
+	App->jobs.Wait(tree_build);
+
 	Resolve();
+}
 
+void CollisionSystem::DebugDraw()
+{
 	if (debug)
 	{
 		for (int i = 0; i < MAX_COLLISION_LAYERS; i++)
@@ -1,6 +1,8 @@
 #ifndef __COLLISIONSYSTEM_H__
 #define __COLLISIONSYSTEM_H__
 
+#define COLLIDER_BATCH_SIZE 64u
+
 #include "SDL/include/SDL.h"
 #include "Point.h"
 #include "Gameobject.h"
@@ -20,9 +22,11 @@ public:
 	void Add(Gameobject* obj);
 	void Add(Collider* coll);
 	void Add(std::vector<Gameobject*>& objects);
+	void Remove(Collider* coll);
 	void ProcessRemovals();
 	void ProcessRemovals(double id);
 	void Update();
+	void DebugDraw();
 	void SetLayerCollision(CollisionLayer one, CollisionLayer two, bool collide);
 	void SetDebug();
 	void Clear();
@@ -31,11 +35,13 @@ public:
 private:
 
 	void Resolve();
+	bool IsSteering(const Collider* collider) const;
 
 private:
 
 	bool collisionLayers[MAX_COLLISION_LAYERS][MAX_COLLISION_LAYERS]; //Store layers collisions
 	std::vector<Collider*> layerColliders[MAX_COLLISION_LAYERS];
+	std::vector<Collider*> activeColliders; // refreshed each frame by the broad phase
 	Quadtree* collisionTree;
 	bool debug;
 };
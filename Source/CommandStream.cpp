@@ -0,0 +1,624 @@
+#include "CommandStream.h"
+#include "Application.h"
+#include "Scene.h"
+#include "Behaviour.h"
+#include "Gameobject.h"
+#include "ByteStream.h"
+#include "Counters.h"
+#include "Defs.h"
+#include "Log.h"
+#include "MemoryTracker.h"
+
+#include "SDL/include/SDL.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <time.h>
+
+CommandStream::CommandStream()
+{}
+
+CommandStream::~CommandStream()
+{}
+
+bool CommandStream::StartRecording(const char* file)
+{
+	mode = RECORDING;
+	path = file;
+	App->time.SetLockstep(true);
+	LOG("Recording matches to %s", file);
+	return true;
+}
+
+bool CommandStream::StartReplay(const char* file)
+{
+	if (!Load(file))
+		return false;
+
+	mode = REPLAYING;
+	path = file;
+	StartHeadless();
+
+	LOG("Replaying %s: %u commands over %u frames", file, (unsigned int)commands.size(), end_frame);
+	return true;
+}
+
+bool CommandStream::StartBenchmark(float minutes)
+{
+	if (minutes <= 0.f)
+	{
+		LOG("Benchmark needs a positive number of simulated minutes");
+		return false;
+	}
+
+	mode = BENCHMARK;
+	end_frame = (unsigned int)(minutes * 60.f / App->time.GetFixedDeltaTime());
+	StartHeadless();
+
+	LOG("Benchmarking %.1f simulated minutes: %u ticks", minutes, end_frame);
+	return true;
+}
+
+bool CommandStream::SetScenario(const char* name)
+{
+	return scenario.Set(name);
+}
+
+void CommandStream::StartHeadless()
+{
+	// No window, audio device, GPU or vsync: as fast as the simulation goes
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+	SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+	SDL_setenv("SDL_RENDER_DRIVER", "software", 1);
+	App->time.SetLockstep(true);
+}
+
+bool CommandStream::IsRecording() const
+{
+	return mode == RECORDING;
+}
+
+bool CommandStream::IsReplaying() const
+{
+	return mode == REPLAYING;
+}
+
+bool CommandStream::IsHeadless() const
+{
+	return mode == REPLAYING || mode == BENCHMARK;
+}
+
+bool CommandStream::ReplayFinished() const
+{
+	return IsHeadless() && active && frame >= end_frame;
+}
+
+bool CommandStream::Passed() const
+{
+	return passed;
+}
+
+void CommandStream::Begin()
+{
+	if (mode == IDLE)
+		return;
+
+	// A new match while recording drops the previous one
+	if (mode == RECORDING)
+	{
+		commands.clear();
+		seeds.clear();
+		checksums.clear();
+	}
+	else if (mode == BENCHMARK)
+	{
+		path = std::string("benchmark ") + scenario.GetName();
+
+		// Waves skip the lore and tutorial: spawners from the first tick
+		commands.clear();
+		if (scenario.GetType() == SCENARIO_WAVES)
+			commands.push_back(Command(0u, GAMEPLAY, 0u, int(SPAWNER_STATE)));
+	}
+
+	active = true;
+	frame = 0u;
+	next_command = next_seed = next_checksum = 0u;
+	desync_frame = 0u;
+	spawns.clear();
+	timings.clear();
+	frame_timings.samples.clear();
+	ticked = false;
+	replay_start = SDL_GetPerformanceCounter();
+
+	std::srand(Seed());
+
+	if (mode == BENCHMARK)
+		scenario.Begin();
+}
+
+void CommandStream::Update()
+{
+	if (!active || !IsHeadless())
+		return;
+
+	FlushTimings();
+
+	while (next_command < commands.size() && commands[next_command].frame <= frame)
+		Apply(commands[next_command++]);
+
+	if (mode == BENCHMARK)
+		scenario.Update(frame);
+}
+
+void CommandStream::EndSimulation(unsigned int ticks)
+{
+	// Paused frames don't advance the match
+	if (active && ticks > 0u)
+	{
+		frame += ticks;
+		ticked = true;
+
+		if (mode == RECORDING)
+			checksums.push_back(StateChecksum());
+		else if (mode == REPLAYING && next_checksum < checksums.size())
+		{
+			unsigned int checksum = StateChecksum();
+			if (checksum != checksums[next_checksum] && desync_frame == 0u)
+			{
+				desync_frame = frame;
+				LOG("Replay desync: frame %u state checksum %08x, recorded %08x", frame, checksum, checksums[next_checksum]);
+			}
+
+			next_checksum++;
+		}
+	}
+}
+
+void CommandStream::End()
+{
+	if (!active)
+		return;
+
+	if (mode == RECORDING)
+	{
+		end_frame = frame;
+		Save();
+	}
+	else if (IsHeadless())
+		passed = Report();
+
+	active = false;
+}
+
+void CommandStream::AddSpawn(Behaviour* behaviour)
+{
+	if (!active || behaviour == nullptr)
+		return;
+
+	spawns.push_back(behaviour->GetHandle());
+	behaviour->spawn_id = spawns.size();
+}
+
+void CommandStream::Record(const Event& e)
+{
+	if (mode != RECORDING || !active || !Recordable(e))
+		return;
+
+	if (e.listener == App->scene)
+	{
+		RecordEvent(e.type, nullptr, e.data1, e.data2);
+		return;
+	}
+
+	// Otherwise the behaviour that owns the button
+	for (std::vector<Behaviour*>::const_iterator it = Behaviour::b_list.cbegin(); it != Behaviour::b_list.cend(); ++it)
+	{
+		if (static_cast<EventListener*>(*it) == e.listener)
+		{
+			RecordEvent(e.type, *it, e.data1, e.data2);
+			return;
+		}
+	}
+
+	LOG("Recording: event %d targets neither the scene nor a behaviour, not recorded", int(e.type));
+}
+
+void CommandStream::RecordEvent(EventType type, const Behaviour* target, const Cvar& data1, const Cvar& data2)
+{
+	if (mode != RECORDING || !active)
+		return;
+
+	if (target != nullptr && target->spawn_id == 0u)
+	{
+		LOG("Recording: event %d targets a behaviour spawned outside the match, not recorded", int(type));
+		return;
+	}
+
+	commands.push_back(Command(frame, int(type), target != nullptr ? target->spawn_id : 0u, data1, data2));
+}
+
+void CommandStream::RecordGroupOrder(const std::vector<Behaviour*>& units, iPoint destination)
+{
+	if (mode != RECORDING || !active)
+		return;
+
+	Command command(frame, COMMAND_GROUP_ORDER, 0u, vec(float(destination.x), float(destination.y), 0.f));
+
+	for (std::vector<Behaviour*>::const_iterator it = units.cbegin(); it != units.cend(); ++it)
+		if ((*it)->spawn_id != 0u)
+			command.units.push_back((*it)->spawn_id);
+
+	commands.push_back(command);
+}
+
+unsigned int CommandStream::Seed()
+{
+	unsigned int seed = (unsigned int)time(NULL);
+
+	if (mode == RECORDING && active)
+		seeds.push_back(seed);
+	else if (mode == BENCHMARK)
+		seed = BENCHMARK_SEED ^ (next_seed++ * 2654435761u); // differs per call, same sequence every run
+	else if (mode == REPLAYING && active)
+	{
+		if (next_seed < seeds.size())
+			seed = seeds[next_seed++];
+		else
+			LOG("Replay desync: frame %u asked for more seeds than recorded", frame);
+	}
+
+	return seed;
+}
+
+unsigned long long CommandStream::AddTiming(const char* system, unsigned long long start)
+{
+	unsigned long long now = SDL_GetPerformanceCounter();
+
+	if (IsHeadless() && active)
+	{
+		float ms = float(now - start) * 1000.f / float(SDL_GetPerformanceFrequency());
+
+		std::vector<SystemTimings>::iterator it = timings.begin();
+		for (; it != timings.end() && it->name != system; ++it);
+
+		if (it != timings.end())
+			it->current += ms;
+		else
+		{
+			SystemTimings entry = { system, ms, std::vector<float>() };
+			timings.push_back(entry);
+		}
+	}
+
+	return now;
+}
+
+bool CommandStream::Recordable(const Event& e) const
+{
+	switch (e.type)
+	{
+	case BUILD_GATHERER:
+	case BUILD_MELEE:
+	case BUILD_RANGED:
+	case BUILD_SUPER:
+	case BUILD_TOWER:
+	case BUILD_CENTER:
+	case BUILD_WALL:
+	case BUILD_LAB:
+	case BUILD_BARRACKS:
+	case BUILD_CAPSULE:
+	case DO_UPGRADE:
+	case SPAWN_UNIT:
+	case UPGRADE_GATHERER:
+	case UPGRADE_MELEE:
+	case UPGRADE_RANGED:
+	case UPGRADE_SUPER:
+	case GAMEPLAY:
+	case SKIP_TUTORIAL:
+		return true;
+	case PLACE_BUILDING:
+		return e.data2.GetType() == Cvar::VEC; // the placement, not the preview
+	default:
+		return false;
+	}
+}
+
+void CommandStream::Apply(const Command& command)
+{
+	if (command.type == COMMAND_GROUP_ORDER)
+	{
+		static std::vector<Behaviour*> units;
+		units.clear();
+
+		for (std::vector<unsigned int>::const_iterator it = command.units.cbegin(); it != command.units.cend(); ++it)
+		{
+			Behaviour* unit = GetSpawn(*it);
+			if (unit != nullptr)
+				units.push_back(unit);
+		}
+
+		vec dest = command.data1.AsVec();
+		App->groupMove.IssueOrder(units, { int(dest.x), int(dest.y) });
+	}
+	else if (command.target == 0u)
+		Event::Push(EventType(command.type), App->scene, command.data1, command.data2);
+	else
+	{
+		Behaviour* target = GetSpawn(command.target);
+		if (target == nullptr)
+			LOG("Replay desync: frame %u targets spawn %u, missing", frame, command.target);
+		else if (command.type == ON_RIGHT_CLICK)
+			Event::Push(ON_RIGHT_CLICK, target->GetGameobject(), command.data1, command.data2);
+		else
+			Event::Push(EventType(command.type), target, command.data1, command.data2);
+	}
+}
+
+Behaviour* CommandStream::GetSpawn(unsigned int ordinal) const
+{
+	if (ordinal == 0u || ordinal > spawns.size())
+		return nullptr;
+
+	// Dead and pooled units stop resolving with their handle
+	Component* comp = Component::Get(spawns[ordinal - 1u]);
+	return comp != nullptr ? comp->AsBehaviour() : nullptr;
+}
+
+unsigned int CommandStream::StateChecksum() const
+{
+	// Summed per behaviour: independent of the order of the dense list
+	unsigned int ret = Behaviour::b_list.size();
+	for (std::vector<Behaviour*>::const_iterator it = Behaviour::b_list.cbegin(); it != Behaviour::b_list.cend(); ++it)
+	{
+		const Behaviour* b = *it;
+		const int fields[6] = { int(b->spawn_id), int(b->GetType()), int(b->current_state), b->current_life, int(b->pos.x * 16.f), int(b->pos.y * 16.f) };
+
+		// FNV-1a
+		unsigned int hash = 2166136261u;
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(fields);
+		for (unsigned int i = 0u; i < sizeof(fields); ++i)
+			hash = (hash ^ bytes[i]) * 16777619u;
+
+		ret += hash;
+	}
+
+	for (int i = 0; i < MAX_PLAYER_STATS; ++i)
+		ret = ret * 31u + unsigned(Scene::GetStat(i));
+
+	return ret;
+}
+
+void CommandStream::FlushTimings()
+{
+	frame_timings.current = 0.f;
+	for (std::vector<SystemTimings>::iterator it = timings.begin(); it != timings.end(); ++it)
+	{
+		if (ticked)
+			it->samples.push_back(it->current);
+
+		frame_timings.current += it->current;
+		it->current = 0.f;
+	}
+
+	if (ticked)
+		frame_timings.samples.push_back(frame_timings.current);
+
+	ticked = false;
+}
+
+void CommandStream::ReportTimings(SystemTimings& entry) const
+{
+	std::vector<float>& samples = entry.samples;
+	if (samples.empty())
+		return;
+
+	float total = 0.f;
+	for (std::vector<float>::const_iterator s = samples.cbegin(); s != samples.cend(); ++s)
+		total += *s;
+
+	std::sort(samples.begin(), samples.end());
+	unsigned int last = samples.size() - 1u;
+
+	char line[256];
+	snprintf(line, 256, "%-20s %9.3f %9.3f %9.3f %9.3f %9.3f", entry.name, total / float(samples.size()),
+		samples[last * 50u / 100u], samples[last * 95u / 100u], samples[last * 99u / 100u], samples[last]);
+	printf("%s\n", line);
+	LOG("%s", line);
+}
+
+bool CommandStream::Save() const
+{
+	std::string buffer;
+	ByteWriter out(buffer);
+
+	out.Write(static_cast<unsigned int>(COMMAND_STREAM_MAGIC));
+	out.Write(static_cast<unsigned int>(COMMAND_STREAM_VERSION));
+	out.Write(end_frame);
+	out.WriteArray(seeds);
+	out.WriteArray(checksums);
+
+	out.Write(static_cast<unsigned int>(commands.size()));
+	for (std::vector<Command>::const_iterator it = commands.cbegin(); it != commands.cend(); ++it)
+	{
+		out.Write(it->frame);
+		out.Write(it->type);
+		out.Write(it->target);
+		WriteCvar(out, it->data1);
+		WriteCvar(out, it->data2);
+		out.WriteArray(it->units);
+	}
+
+	// Plain file: recordings live wherever the command line says
+	bool ret = false;
+	SDL_RWops* rw = SDL_RWFromFile(path.c_str(), "wb");
+	if (rw != nullptr)
+	{
+		ret = (SDL_RWwrite(rw, buffer.c_str(), 1, buffer.size()) == buffer.size());
+		SDL_RWclose(rw);
+	}
+
+	if (ret)
+		LOG("Match recorded to %s: %u frames, %u commands, %u seeds, %u checksums", path.c_str(), end_frame,
+			(unsigned int)commands.size(), (unsigned int)seeds.size(), (unsigned int)checksums.size());
+	else
+		LOG("Error writing match recording %s: %s", path.c_str(), SDL_GetError());
+
+	return ret;
+}
+
+bool CommandStream::Load(const char* file)
+{
+	SDL_RWops* rw = SDL_RWFromFile(file, "rb");
+	if (rw == nullptr)
+	{
+		LOG("Error opening match recording %s: %s", file, SDL_GetError());
+		return false;
+	}
+
+	std::string buffer(size_t(SDL_RWsize(rw)), '\0');
+	bool ret = buffer.empty() || SDL_RWread(rw, &buffer[0], 1, buffer.size()) == buffer.size();
+	SDL_RWclose(rw);
+
+	ByteReader in(buffer.c_str(), buffer.size());
+	unsigned int magic = 0u, version = 0u, count = 0u;
+	in.Read(magic);
+	in.Read(version);
+
+	if (!ret || magic != COMMAND_STREAM_MAGIC || version != COMMAND_STREAM_VERSION)
+	{
+		LOG("Error reading match recording %s: unknown format", file);
+		return false;
+	}
+
+	in.Read(end_frame);
+	in.ReadArray(seeds);
+	in.ReadArray(checksums);
+	in.Read(count);
+
+	commands.clear();
+	for (unsigned int i = 0u; i < count && in.Good(); ++i)
+	{
+		Command command;
+		in.Read(command.frame);
+		in.Read(command.type);
+		in.Read(command.target);
+		ReadCvar(in, command.data1);
+		ReadCvar(in, command.data2);
+		in.ReadArray(command.units);
+		commands.push_back(command);
+	}
+
+	if (!in.Good())
+		LOG("Error reading match recording %s: truncated", file);
+
+	return in.Good();
+}
+
+bool CommandStream::Report()
+{
+	FlushTimings();
+
+	float wall = float(SDL_GetPerformanceCounter() - replay_start) / float(SDL_GetPerformanceFrequency());
+
+	char line[256];
+	snprintf(line, 256, "%s: %u sim ticks in %.2f s, %.1f sim ticks/s (%.1fx real time)", path.c_str(), frame, wall,
+		wall > 0.f ? float(frame) / wall : 0.f, wall > 0.f ? float(frame) * App->time.GetFixedDeltaTime() / wall : 0.f);
+	printf("%s\n", line);
+	LOG("%s", line);
+
+	snprintf(line, 256, "%-20s %9s %9s %9s %9s %9s", "system (ms)", "mean", "p50", "p95", "p99", "max");
+	printf("%s\n", line);
+	LOG("%s", line);
+
+	for (std::vector<SystemTimings>::iterator it = timings.begin(); it != timings.end(); ++it)
+		ReportTimings(*it);
+
+	// Whole frames: a system's worst frames are rarely every system's
+	ReportTimings(frame_timings);
+
+	const FrameArena& arena = App->frameArena;
+	unsigned int frames = arena.GetFrames() > 0u ? arena.GetFrames() : 1u;
+	snprintf(line, 256, "frame arena: %.1f allocations/frame, %.2f heap overflows/frame, peak %u KB",
+		float(arena.GetTotalAllocations()) / float(frames), float(arena.GetTotalOverflows()) / float(frames), (unsigned int)(arena.GetPeak() / 1024u));
+	printf("%s\n", line);
+	LOG("%s", line);
+
+	// Heap allocations per frame on every tag, the figure the arena brings down
+	unsigned int memory_frames = MemoryTracker::GetFrames() > 0u ? MemoryTracker::GetFrames() : 1u;
+	long long heap_allocations = 0;
+	for (int i = 0; i < MAX_MEM_TAGS; ++i)
+		heap_allocations += MemoryTracker::GetStats(MemoryTag(i)).allocations;
+
+	static const Counter* heap_count = Counters::Find("memory/heap allocations", COUNTER_GAUGE);
+	snprintf(line, 256, "heap: %.1f allocations/frame, max %lld in a frame",
+		double(heap_allocations) / double(memory_frames), heap_count->GetMax());
+	printf("%s\n", line);
+	LOG("%s", line);
+
+	snprintf(line, 256, "%-20s %9s %9s %9s %9s %9s", "memory", "live KB", "blocks", "peak KB", "allocs/f", "KB/f");
+	printf("%s\n", line);
+	LOG("%s", line);
+
+	// Rates over the whole run, KB/f is the last frame
+	for (int i = 0; i < MAX_MEM_TAGS; ++i)
+	{
+		MemoryTracker::Stats stats = MemoryTracker::GetStats(MemoryTag(i));
+		snprintf(line, 256, "%-20s %9lld %9lld %9lld %9.1f %9.2f", MemoryTracker::GetTagName(MemoryTag(i)), stats.live_bytes / 1024,
+			stats.live_blocks, stats.peak_bytes / 1024, double(stats.allocations) / double(memory_frames), double(stats.frame_bytes) / 1024.0);
+		printf("%s\n", line);
+		LOG("%s", line);
+	}
+
+	// Containers suspected to grow over long sessions
+	snprintf(line, 256, "components %u, stored paths %u, pending paths %u", Component::Count(),
+		App->pathfinding.GetStoredPathCount(), App->pathfinding.GetPendingPathCount());
+	printf("%s\n", line);
+	LOG("%s", line);
+
+	if (mode == REPLAYING)
+	{
+		if (desync_frame > 0u)
+			snprintf(line, 256, "state checksums: DESYNC from frame %u (%u of %u compared)", desync_frame, next_checksum, (unsigned int)checksums.size());
+		else
+			snprintf(line, 256, "state checksums: %u of %u frames match", next_checksum, (unsigned int)checksums.size());
+		printf("%s\n", line);
+		LOG("%s", line);
+	}
+
+	return mode != BENCHMARK || scenario.Report();
+}
+
+void CommandStream::WriteCvar(ByteWriter& out, const Cvar& value)
+{
+	Cvar::VAR_TYPE type = value.GetType();
+
+	switch (type)
+	{
+	case Cvar::BOOL: out.Write(type); out.Write(value.AsBool()); break;
+	case Cvar::INT: out.Write(type); out.Write(value.AsInt()); break;
+	case Cvar::UINT: out.Write(type); out.Write(value.AsUInt()); break;
+	case Cvar::FLOAT: out.Write(type); out.Write(value.AsFloat()); break;
+	case Cvar::DOUBLE: out.Write(type); out.Write(value.AsDouble()); break;
+	case Cvar::VEC: out.Write(type); out.Write(value.AsVec()); break;
+	default: out.Write(Cvar::UNDEFINED); break; // orders never carry pointers or vectors
+	}
+}
+
+bool CommandStream::ReadCvar(ByteReader& in, Cvar& value)
+{
+	Cvar::VAR_TYPE type = Cvar::UNDEFINED;
+	in.Read(type);
+
+	switch (type)
+	{
+	case Cvar::BOOL: { bool v = false; in.Read(v); value.SetValue(v, true); break; }
+	case Cvar::INT: { int v = 0; in.Read(v); value.SetValue(v, true); break; }
+	case Cvar::UINT: { unsigned int v = 0u; in.Read(v); value.SetValue(v, true); break; }
+	case Cvar::FLOAT: { float v = 0.f; in.Read(v); value.SetValue(v, true); break; }
+	case Cvar::DOUBLE: { double v = 0.0; in.Read(v); value.SetValue(v, true); break; }
+	case Cvar::VEC: { vec v; in.Read(v); value.SetValue(v, true); break; }
+	default: break;
+	}
+
+	return in.Good();
+}
@@ -0,0 +1,144 @@
+#ifndef __COMMAND_STREAM_H__
+#define __COMMAND_STREAM_H__
+
+#include "Event.h"
+#include "Component.h"
+#include "Point.h"
+#include "BenchmarkScenario.h"
+
+#include <string>
+#include <vector>
+
+#define COMMAND_STREAM_MAGIC 0x4345524A		// "JREC"
+#define COMMAND_STREAM_VERSION 2
+#define COMMAND_GROUP_ORDER (int(MAX_EVENT_TYPES) + 2)	// GroupMovement::IssueOrder
+#define BENCHMARK_SEED 1234u		// benchmarks replay the same match every run
+
+class Behaviour;
+class ByteWriter;
+class ByteReader;
+
+// Player orders and random seeds of a match, keyed by simulated frame.
+// Recording and replaying both run the simulation in lockstep (one fixed
+// tick per frame, path searches and events drained every frame), so a
+// replay fed the same commands reproduces the match with no input, window
+// or audio. Orders name behaviours by spawn ordinal, counted from the start
+// of the match, never by component handle: a replay skips the intro and
+// menu scenes, so handles differ. A checksum of the scene state recorded
+// every frame tells where a replay desyncs. Replays measure every system
+// and print frame time percentiles.
+// Benchmarks are replays of no recording: a fixed seed and a scripted
+// scenario (the enemy waves unless told otherwise) for a given number of
+// simulated minutes.
+class CommandStream
+{
+public:
+
+	CommandStream();
+	~CommandStream();
+
+	// From the command line, before modules initialize
+	bool StartRecording(const char* file);
+	bool StartReplay(const char* file);
+	bool StartBenchmark(float minutes);
+	bool SetScenario(const char* name);
+
+	bool IsRecording() const;
+	bool IsReplaying() const;
+	bool IsHeadless() const; // replay or benchmark
+	bool ReplayFinished() const;
+	bool Passed() const; // false if a benchmark scenario check failed
+
+	void Begin();	// new match: frame 0 and first seed
+	void Update();	// start of every frame: replays due commands
+	void EndSimulation(unsigned int ticks); // after the fixed ticks: advances the frame
+	void End();		// writes the recording or prints the replay report
+
+	// Behaviours that orders can target get the next spawn ordinal
+	void AddSpawn(Behaviour* behaviour);
+
+	// Player orders. A null target is the scene
+	void Record(const Event& e);
+	void RecordEvent(EventType type, const Behaviour* target, const Cvar& data1 = Cvar(), const Cvar& data2 = Cvar());
+	void RecordGroupOrder(const std::vector<Behaviour*>& units, iPoint destination);
+
+	// Use instead of time(NULL) when seeding std::rand
+	unsigned int Seed();
+
+	// Replay profiling: adds the time since start to this frame's system total, returns now
+	unsigned long long AddTiming(const char* system, unsigned long long start);
+
+private:
+
+	struct Command
+	{
+		Command() {}
+		Command(unsigned int frame, int type, unsigned int target, const Cvar& data1 = Cvar(), const Cvar& data2 = Cvar()) :
+			frame(frame), type(type), target(target), data1(data1), data2(data2) {}
+
+		unsigned int frame = 0u;
+		int type = 0;
+		unsigned int target = 0u; // spawn ordinal, 0 is the scene
+		Cvar data1;
+		Cvar data2;
+		std::vector<unsigned int> units; // spawn ordinals
+	};
+
+	struct SystemTimings
+	{
+		const char* name;
+		float current;
+		std::vector<float> samples; // ms per frame
+	};
+
+	enum Mode : int
+	{
+		IDLE,
+		RECORDING,
+		REPLAYING,
+		BENCHMARK
+	};
+
+	void StartHeadless();
+	bool Recordable(const Event& e) const;
+	void Apply(const Command& command);
+	Behaviour* GetSpawn(unsigned int ordinal) const;
+	unsigned int StateChecksum() const;
+	bool Save() const;
+	bool Load(const char* file);
+	void FlushTimings();
+	void ReportTimings(SystemTimings& entry) const; // sorts its samples
+	bool Report(); // false if a benchmark scenario check failed
+
+	static void WriteCvar(ByteWriter& out, const Cvar& value);
+	static bool ReadCvar(ByteReader& in, Cvar& value);
+
+private:
+
+	Mode mode = IDLE;
+	bool active = false; // a match is running
+	bool passed = true;
+	std::string path;
+
+	unsigned int frame = 0u;
+	unsigned int end_frame = 0u;
+
+	std::vector<Command> commands;
+	unsigned int next_command = 0u;
+	std::vector<unsigned int> seeds;
+	unsigned int next_seed = 0u;
+
+	std::vector<ComponentHandle> spawns; // by ordinal - 1, this match
+	std::vector<unsigned int> checksums; // one per simulated frame
+	unsigned int next_checksum = 0u;
+	unsigned int desync_frame = 0u; // first frame whose checksum differs, 0 if none
+
+	BenchmarkScenario scenario;
+
+	std::vector<SystemTimings> timings;
+	SystemTimings frame_timings = { "frame", 0.f, std::vector<float>() }; // every system summed
+	bool ticked = false; // last frame advanced the match: its timings are a sample
+	unsigned long long replay_start = 0u;
+};
+
+#endif // __COMMAND_STREAM_H__
@@ -1,16 +1,33 @@
 #include "Component.h"
 #include "Gameobject.h"
+#include "Log.h"
 
 double Component::component_count = 0;
-std::map<double, Component*> Component::ComponentsList;
+std::vector<Component*> Component::slots;
+std::vector<unsigned int> Component::generations;
+std::vector<unsigned int> Component::free_slots;
+std::unordered_map<double, ComponentHandle> Component::id_to_handle;
+std::vector<Component*> Component::pools[MAX_TYPES];
 
 Component::Component(ComponentType type, Gameobject* go) : id(++component_count), type(type), game_object(go)
 {
+	Register();
+
 	if (go != nullptr)
-	{
 		go->AddComponent(this);
-		ComponentsList.emplace(id,this);
-	}
+}
+
+// Copies share id but are not registered: only the original owns the slot
+Component::Component(const Component& copy) :
+	id(copy.id),
+	active(copy.active),
+	type(copy.type),
+	game_object(copy.game_object)
+{}
+
+Component::~Component()
+{
+	Unregister();
 }
 
 bool Component::IsActive() const
@@ -18,7 +35,92 @@ bool Component::IsActive() const
 	return active && game_object->IsActive();
 }
 
+bool Component::ActiveThisPass() const
+{
+	return active && game_object != nullptr && game_object->ActiveThisPass();
+}
+
 bool Component::operator==(Component * comp)
 {
 	return comp != nullptr && id == comp->id;
 }
+
+void Component::Renew()
+{
+	Unregister();
+	id = ++component_count;
+	Register();
+}
+
+Component* Component::Get(ComponentHandle h)
+{
+	unsigned int index = h & HANDLE_INDEX_MASK;
+	return (h != INVALID_COMPONENT_HANDLE && index < slots.size() && generations[index] == (h >> HANDLE_INDEX_BITS)) ? slots[index] : nullptr;
+}
+
+Component* Component::Find(double component_id)
+{
+	std::unordered_map<double, ComponentHandle>::const_iterator it = id_to_handle.find(component_id);
+	return it != id_to_handle.cend() ? Get(it->second) : nullptr;
+}
+
+const std::vector<Component*>& Component::GetPool(ComponentType t)
+{
+	return pools[t];
+}
+
+unsigned int Component::Count()
+{
+	return slots.size() - free_slots.size();
+}
+
+void Component::Register()
+{
+	unsigned int index;
+	if (!free_slots.empty())
+	{
+		index = free_slots.back();
+		free_slots.pop_back();
+		slots[index] = this;
+	}
+	else
+	{
+		index = slots.size();
+		if (index > HANDLE_INDEX_MASK)
+		{
+			LOG("Component slot table full, component %f left without handle", id);
+			return;
+		}
+
+		slots.push_back(this);
+		generations.push_back(1u);
+	}
+
+	handle = (generations[index] << HANDLE_INDEX_BITS) | index;
+	id_to_handle[id] = handle;
+
+	pool_index = pools[type].size();
+	pools[type].push_back(this);
+}
+
+void Component::Unregister()
+{
+	if (Get(handle) == this)
+	{
+		// Swap-remove from dense pool
+		std::vector<Component*>& pool = pools[type];
+		pool[pool_index] = pool.back();
+		pool[pool_index]->pool_index = pool_index;
+		pool.pop_back();
+
+		// Retire slot, bumping its generation so stale handles fail
+		unsigned int index = handle & HANDLE_INDEX_MASK;
+		slots[index] = nullptr;
+		generations[index] = (generations[index] + 1u) & HANDLE_GENERATION_MASK;
+		if (generations[index] == 0u) generations[index] = 1u;
+		free_slots.push_back(index);
+
+		id_to_handle.erase(id);
+		handle = INVALID_COMPONENT_HANDLE;
+	}
+}
@@ -4,6 +4,16 @@
 #include "EventListener.h"
 #include "PugiXml/src/pugixml.hpp"
 #include <map>
+#include <vector>
+#include <unordered_map>
+
+// 32-bit generational handle: low bits index a slot, high bits hold its generation
+typedef unsigned int ComponentHandle;
+
+#define INVALID_COMPONENT_HANDLE 0u
+#define HANDLE_INDEX_BITS 20u
+#define HANDLE_INDEX_MASK ((1u << HANDLE_INDEX_BITS) - 1u)
+#define HANDLE_GENERATION_MASK ((1u << (32u - HANDLE_INDEX_BITS)) - 1u)
 
 enum ComponentType
 {
@@ -48,13 +58,16 @@ class Transform;
 class Behaviour;
 class Collider;
 class UI_Component;
+class ByteWriter;
+class ByteReader;
 
 class Component : public EventListener
 {
 public:
 
 	Component(ComponentType type, Gameobject* go);
-	virtual ~Component() {}
+	Component(const Component& copy);
+	virtual ~Component();
 
 	virtual void PreUpdate() {}
 	virtual void Update() {}
@@ -63,7 +76,12 @@ public:
 	virtual void Load(pugi::xml_node& node) {}
 	virtual void Save(pugi::xml_node& node) const {}
 
+	// Binary snapshot records
+	virtual void Load(ByteReader& in) {}
+	virtual void Save(ByteWriter& out) const {}
+
 	bool IsActive() const;
+	bool ActiveThisPass() const; // cached by Gameobject::HierarchyPass
 
 	void SetActive() { active = true; }
 	void SetInactive() { active = false; }
@@ -76,15 +94,40 @@ public:
 	Gameobject* GetGameobject() const { return game_object;	}
 
 	double GetID() const { return id; }
+	ComponentHandle GetHandle() const { return handle; }
 
 	bool operator==(Component* comp);
-	static std::map<double, Component*> ComponentsList;
+
+	// Recycled components come back with a new id and handle: stale ones stop resolving
+	void Renew();
+
+	// Handle & pool access
+	static Component* Get(ComponentHandle handle);
+	static Component* Find(double id); // GetID() mapping layer
+	static const std::vector<Component*>& GetPool(ComponentType type);
+	static unsigned int Count();
+
+private:
+
+	void Register();
+	void Unregister();
 
 private:
 
 	static double component_count;
 
+	// Slot table
+	static std::vector<Component*> slots;
+	static std::vector<unsigned int> generations;
+	static std::vector<unsigned int> free_slots;
+	static std::unordered_map<double, ComponentHandle> id_to_handle;
+
+	// Dense per-type storage
+	static std::vector<Component*> pools[MAX_TYPES];
+
 	double id = -1;
+	ComponentHandle handle = INVALID_COMPONENT_HANDLE;
+	unsigned int pool_index = 0u;
 	bool active = true;
 	ComponentType type = COMP_NONE;
 
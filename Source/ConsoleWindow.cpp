@@ -1,7 +1,44 @@
 #include "ConsoleWindow.h"
+#include "Application.h"
+#include "UI_Text.h"
+#include "Log.h"
 
 ConsoleWindow::ConsoleWindow(const RectF rect) : EditorWindow(rect)
 {}
 
 ConsoleWindow::~ConsoleWindow()
-{}
\ No newline at end of file
+{}
+
+bool ConsoleWindow::Init()
+{
+	float height = 1.0f / float(CONSOLE_WINDOW_LINES);
+	for (unsigned int i = 0u; i < CONSOLE_WINDOW_LINES; ++i)
+	{
+		UI_Text* line = new UI_Text(this, { 0.01f, height * float(i), 0.98f, height }, " ");
+		line->scale_to_fit = true;
+		elements.push_back(line);
+	}
+
+	return !elements.empty();
+}
+
+void ConsoleWindow::_Update()
+{
+	color.a = (state.mouse_inside ? 255 : 220);
+
+	if ((refresh_timer -= App->time.GetDeltaTime()) > 0.f)
+		return;
+
+	refresh_timer = CONSOLE_WINDOW_REFRESH;
+
+	unsigned int total = Logger::GetConsoleLines(lines);
+	if (total == last_total)
+		return;
+
+	last_total = total;
+
+	// Newest line at the bottom
+	unsigned int first = lines.size() > CONSOLE_WINDOW_LINES ? lines.size() - CONSOLE_WINDOW_LINES : 0u;
+	for (unsigned int i = 0u; i < CONSOLE_WINDOW_LINES; ++i)
+		elements[i]->ToUiText()->text->SetText(first + i < lines.size() ? lines[first + i].c_str() : " ");
+}
@@ -3,12 +3,30 @@
 
 #include "EditorWindow.h"
 
+#include <string>
+
+#define CONSOLE_WINDOW_LINES 12u
+#define CONSOLE_WINDOW_REFRESH 0.25f // seconds
+
+// Latest lines the log writer handed to the console history
 class ConsoleWindow : public EditorWindow
 {
 public:
 
 	ConsoleWindow(const RectF rect);
 	~ConsoleWindow();
+
+	bool Init() override;
+
+private:
+
+	void _Update() override;
+
+private:
+
+	float refresh_timer = 0.f;
+	unsigned int last_total = 0u;
+	std::vector<std::string> lines;
 };
 
-#endif // __CONSOLE_WINDOW_H__
\ No newline at end of file
+#endif // __CONSOLE_WINDOW_H__
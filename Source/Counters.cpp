@@ -0,0 +1,153 @@
+#include "Counters.h"
+#include "Log.h"
+
+#include "SDL/include/SDL_timer.h"
+#include "SDL/include/SDL_rwops.h"
+#include "SDL/include/SDL_error.h"
+
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	// Function local so counters found during static initialization are safe
+	struct Registry
+	{
+		std::deque<Counter> counters; // deque never moves its elements
+		std::mutex mutex;
+
+		unsigned int frames = 0u;
+		unsigned int last_dump = 0u;
+		std::string dump_path = COUNTERS_DEFAULT_FILE;
+		SDL_RWops* dump_file = nullptr;
+	};
+
+	Registry& GetRegistry()
+	{
+		static Registry registry;
+		return registry;
+	}
+}
+
+Counter* Counters::Find(const char* name, CounterKind kind)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	for (std::deque<Counter>::iterator it = registry.counters.begin(); it != registry.counters.end(); ++it)
+		if (it->name == name)
+			return &(*it);
+
+	registry.counters.emplace_back();
+	Counter& counter = registry.counters.back();
+	counter.name = name;
+	counter.kind = kind;
+	return &counter;
+}
+
+void Counters::EndFrame()
+{
+	Registry& registry = GetRegistry();
+	{
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (std::deque<Counter>::iterator it = registry.counters.begin(); it != registry.counters.end(); ++it)
+		{
+			if (it->kind == COUNTER_FRAME)
+				it->last = it->value.exchange(0, std::memory_order_relaxed);
+			else
+				it->last = it->value.load(std::memory_order_relaxed);
+
+			if (it->last > it->max)
+				it->max = it->last;
+		}
+	}
+
+	registry.frames++;
+
+	unsigned int now = SDL_GetTicks();
+	if (registry.last_dump == 0u)
+		registry.last_dump = now;
+	else if (now - registry.last_dump >= COUNTERS_DUMP_INTERVAL)
+	{
+		registry.last_dump = now;
+		Dump();
+	}
+}
+
+unsigned int Counters::GetFrames()
+{
+	return GetRegistry().frames;
+}
+
+void Counters::GetAll(std::vector<const Counter*>& list)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	list.clear();
+	for (std::deque<Counter>::const_iterator it = registry.counters.cbegin(); it != registry.counters.cend(); ++it)
+		list.push_back(&(*it));
+}
+
+void Counters::SetDumpFile(const char* path)
+{
+	Registry& registry = GetRegistry();
+
+	if (registry.dump_file != nullptr)
+	{
+		SDL_RWclose(registry.dump_file);
+		registry.dump_file = nullptr;
+	}
+
+	registry.dump_path = path;
+}
+
+bool Counters::Dump()
+{
+	Registry& registry = GetRegistry();
+
+	if (registry.dump_path.empty())
+		return false;
+
+	// Truncated on the first dump of the run, appended afterwards
+	if (registry.dump_file == nullptr && (registry.dump_file = SDL_RWFromFile(registry.dump_path.c_str(), "wb")) == nullptr)
+	{
+		LOG("Error opening counters log %s: %s", registry.dump_path.c_str(), SDL_GetError());
+		registry.dump_path.clear();
+		return false;
+	}
+
+	char line[256];
+	snprintf(line, 256, "[%.1f s, frame %u]\n", double(SDL_GetTicks()) / 1000.0, registry.frames);
+	std::string text = line;
+
+	std::vector<const Counter*> list;
+	GetAll(list);
+	for (std::vector<const Counter*>::const_iterator it = list.cbegin(); it != list.cend(); ++it)
+	{
+		snprintf(line, 256, "%s: %lld (max %lld)\n", (*it)->GetName(), (*it)->GetLast(), (*it)->GetMax());
+		text += line;
+	}
+
+	bool ret = SDL_RWwrite(registry.dump_file, text.c_str(), 1, text.size()) == text.size();
+	if (!ret)
+		LOG("Error writing counters log %s: %s", registry.dump_path.c_str(), SDL_GetError());
+
+	return ret;
+}
+
+void Counters::CleanUp()
+{
+	Registry& registry = GetRegistry();
+
+	if (registry.frames > 0u)
+		Dump();
+
+	if (registry.dump_file != nullptr)
+	{
+		SDL_RWclose(registry.dump_file);
+		registry.dump_file = nullptr;
+	}
+}
@@ -0,0 +1,62 @@
+#ifndef __COUNTERS_H__
+#define __COUNTERS_H__
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#define COUNTERS_DUMP_INTERVAL 10000u // ms between dumps to the counters log
+#define COUNTERS_DEFAULT_FILE "counters.log"
+
+enum CounterKind : int
+{
+	COUNTER_FRAME,	// added to during a frame, cleared by EndFrame
+	COUNTER_GAUGE	// set to the current value, kept until set again
+};
+
+class Counter
+{
+public:
+
+	void Add(long long amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+	void Set(long long v) { value.store(v, std::memory_order_relaxed); }
+
+	const char* GetName() const { return name.c_str(); }
+	CounterKind GetKind() const { return kind; }
+	long long GetLast() const { return last; }	// last finished frame
+	long long GetMax() const { return max; }	// since start
+
+private:
+
+	friend class Counters;
+
+	std::string name;
+	CounterKind kind;
+	std::atomic<long long> value{ 0 };
+	long long last = 0;
+	long long max = 0;
+};
+
+// Registry of named atomic counters the subsystems update every frame.
+// Find returns a pointer that stays valid for the whole run, so callers
+// keep it in a static instead of looking the name up each time. Add and
+// Set are safe from job threads; EndFrame, the readers and the dumps
+// belong to the main thread.
+class Counters
+{
+public:
+
+	static Counter* Find(const char* name, CounterKind kind = COUNTER_FRAME);
+
+	// Main thread, once per frame
+	static void EndFrame();
+
+	static unsigned int GetFrames();
+	static void GetAll(std::vector<const Counter*>& list);
+
+	static void SetDumpFile(const char* path); // empty disables the dumps
+	static bool Dump();
+	static void CleanUp(); // last dump and closes the file
+};
+
+#endif // __COUNTERS_H__
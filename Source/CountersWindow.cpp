@@ -0,0 +1,43 @@
+#include "CountersWindow.h"
+#include "Application.h"
+#include "Counters.h"
+#include "UI_Text.h"
+
+#include <stdio.h>
+
+CountersWindow::CountersWindow(const RectF rect) : EditorWindow(rect)
+{}
+
+CountersWindow::~CountersWindow()
+{}
+
+bool CountersWindow::Init()
+{
+	return true;
+}
+
+void CountersWindow::_Update()
+{
+	color.a = (state.mouse_inside ? 255 : 220);
+
+	if ((refresh_timer -= App->time.GetDeltaTime()) > 0.f)
+		return;
+
+	refresh_timer = COUNTERS_WINDOW_REFRESH;
+
+	// Counters can register late, lines grow with them
+	Counters::GetAll(counters);
+	while (elements.size() < counters.size())
+	{
+		UI_Text* line = new UI_Text(this, { 0.02f, 0.03f * float(elements.size()), 0.96f, 0.03f }, " ");
+		line->scale_to_fit = true;
+		elements.push_back(line);
+	}
+
+	char text[128];
+	for (unsigned int i = 0; i < counters.size(); ++i)
+	{
+		snprintf(text, 128, "%s: %lld (max %lld)", counters[i]->GetName(), counters[i]->GetLast(), counters[i]->GetMax());
+		elements[i]->ToUiText()->text->SetText(text);
+	}
+}
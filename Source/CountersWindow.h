@@ -0,0 +1,30 @@
+#ifndef __COUNTERS_WINDOW_H__
+#define __COUNTERS_WINDOW_H__
+
+#include "EditorWindow.h"
+
+#define COUNTERS_WINDOW_REFRESH 0.25f // seconds
+
+class Counter;
+
+// Last frame value and max of every registered counter, one line each
+class CountersWindow : public EditorWindow
+{
+public:
+
+	CountersWindow(const RectF rect);
+	~CountersWindow();
+
+	bool Init() override;
+
+private:
+
+	void _Update() override;
+
+private:
+
+	float refresh_timer = 0.f;
+	std::vector<const Counter*> counters;
+};
+
+#endif // __COUNTERS_WINDOW_H__
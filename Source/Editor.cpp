@@ -10,6 +10,7 @@
 #include "PropertiesWindow.h"
 #include "ConsoleWindow.h"
 #include "ConfigWindow.h"
+#include "CountersWindow.h"
 #include "Defs.h"
 #include "Log.h"
 
@@ -34,8 +35,9 @@ bool Editor::Init()
 	windows.push_back(hierarchy = new HierarchyWindow({ 0.02f, 0.05f, 0.2f, 0.9f }));
 	//windows.push_back(properties = new PropertiesWindow({ 0.8f, 0.05f, 0.2f, 0.4f }));
 
-	//windows.push_back(console = new ConsoleWindow({ 0.0f, 0.7f, 0.4f, 0.3f }));
+	windows.push_back(console = new ConsoleWindow({ 0.25f, 0.7f, 0.5f, 0.28f }));
 	//windows.push_back(config = new ConfigWindow({ 0.7f, 0.6f, 0.3f, 0.4f }));
+	windows.push_back(counters = new CountersWindow({ 0.78f, 0.05f, 0.2f, 0.9f }));
 
 
 	return !windows.empty();
@@ -11,6 +11,7 @@ class HierarchyWindow;
 class PropertiesWindow;
 class ConsoleWindow;
 class ConfigWindow;
+class CountersWindow;
 class Gameobject;
 
 class Editor : public Module
@@ -37,6 +38,7 @@ public:
 	PropertiesWindow* properties = nullptr;
 	ConsoleWindow* console = nullptr;
 	ConfigWindow* config = nullptr;
+	CountersWindow* counters = nullptr;
 
 private:
 
@@ -26,7 +26,7 @@ struct WindowState
 	bool dragging = false;
 };
 
-enum KeyState;
+enum KeyState : int;
 class UI_Element;
 
 class EditorWindow : public EventListener
@@ -9,6 +9,18 @@
 #include <vector>
 
 EnemyMeleeUnit::EnemyMeleeUnit(Gameobject* go) : B_Unit(go, ENEMY_MELEE, IDLE, B_ENEMY_MELEE)
+{
+	ResetStats();
+	SetColliders();
+
+	//SFX
+	deathFX = IA_MELEE_DIE_FX;
+	attackFX = IA_MELEE_ATK_FX;
+}
+
+EnemyMeleeUnit::~EnemyMeleeUnit() {}
+
+void EnemyMeleeUnit::ResetStats()
 {
 	//Stats
 	current_life = 50;
@@ -22,12 +34,4 @@ EnemyMeleeUnit::EnemyMeleeUnit(Gameobject* go) : B_Unit(go, ENEMY_MELEE, IDLE, B
 	arriveDestination = true;
 	providesVisibility = false;
 	new_state = IDLE;
-
-	SetColliders();
-
-	//SFX
-	deathFX = IA_MELEE_DIE_FX;
-	attackFX = IA_MELEE_ATK_FX;
 }
-
-EnemyMeleeUnit::~EnemyMeleeUnit() {}
\ No newline at end of file
@@ -13,6 +13,8 @@ public:
 	EnemyMeleeUnit(Gameobject* go);
 	~EnemyMeleeUnit();
 
+	void ResetStats() override;
+
 protected:
 	bool base_found;
 	Gameobject* baseCenter;
@@ -9,6 +9,19 @@
 #include "ParticleSystem.h"
 
 EnemyRangedUnit::EnemyRangedUnit(Gameobject* go) : B_Unit(go, ENEMY_RANGED, IDLE, B_RANGED)
+{
+	ResetStats();
+
+	//SFX
+	deathFX = IA_RANGED_DIE_FX;
+	attackFX = IA_RANGED_ATK_FX;
+	SetColliders();
+}
+
+EnemyRangedUnit::~EnemyRangedUnit()
+{}
+
+void EnemyRangedUnit::ResetStats()
 {
 	//Stats
 	max_life = 35;
@@ -19,19 +32,12 @@ EnemyRangedUnit::EnemyRangedUnit(Gameobject* go) : B_Unit(go, ENEMY_RANGED, IDLE
 	attack_range = 11.0f;
 	vision_range = 15.0f;
 	providesVisibility = false;
-
-	//SFX
-	deathFX = IA_RANGED_DIE_FX;
-	attackFX = IA_RANGED_ATK_FX;
-	SetColliders();
 }
 
-EnemyRangedUnit::~EnemyRangedUnit()
-{}
-
-void EnemyRangedUnit::UnitAttackType()
+bool EnemyRangedUnit::UnitAttackType()
 {
 	attackPos = atkObj->GetPos();
-	App->particleSys.AddParticle(pos, attackPos, 8.0f, PURPLE_PARTICLE);
+	App->particleSys.Launch(pos, atkObj, 8.0f, PURPLE_PARTICLE, damage, GetType());
 	audio->Play(attackFX);
+	return true;
 }
\ No newline at end of file
@@ -8,6 +8,19 @@
 #include "ParticleSystem.h"
 
 EnemySuperUnit::EnemySuperUnit(Gameobject* go) : B_Unit(go, ENEMY_SUPER, IDLE, B_RANGED)
+{
+	ResetStats();
+
+	//SFX
+	deathFX = IA_SUPER_DIE_FX;
+	attackFX = IA_SUPER_ATK_FX;
+	SetColliders();
+}
+
+EnemySuperUnit::~EnemySuperUnit()
+{}
+
+void EnemySuperUnit::ResetStats()
 {
 	//Stats
 	max_life = 75;
@@ -18,18 +31,11 @@ EnemySuperUnit::EnemySuperUnit(Gameobject* go) : B_Unit(go, ENEMY_SUPER, IDLE, B
 	attack_range = 10.0f;
 	vision_range = 15.0f;
 	providesVisibility = false;
-
-	//SFX
-	deathFX = IA_SUPER_DIE_FX;
-	attackFX = IA_SUPER_ATK_FX;
-	SetColliders();
 }
 
-EnemySuperUnit::~EnemySuperUnit()
-{}
-
-void EnemySuperUnit::UnitAttackType()
+bool EnemySuperUnit::UnitAttackType()
 {
 	attackPos = atkObj->GetPos();
-	App->particleSys.AddParticle(pos, attackPos, 8.0f, PURPLE_PARTICLE);
+	App->particleSys.Launch(pos, atkObj, 8.0f, PURPLE_PARTICLE, damage, GetType());
+	return true;
 }
\ No newline at end of file
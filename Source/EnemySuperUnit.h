@@ -13,7 +13,8 @@ public:
 	EnemySuperUnit(Gameobject* go);
 	~EnemySuperUnit();
 
-	void UnitAttackType() override;
+	void ResetStats() override;
+	bool UnitAttackType() override;
 };
 
 #endif#
\ No newline at end of file
@@ -1,16 +1,25 @@
 #include "Event.h"
 #include "EventListener.h"
+#include "Log.h"
+#include "Counters.h"
 #include "SDL/include/SDL_timer.h"
 
+#include <string.h>
+
 bool Event::paused = false;
-std::queue<Event> Event::events_queue;
+std::queue<Event> Event::events_queue[MAX_EVENT_PRIORITIES];
+Event::LatencyStats Event::latency[MAX_EVENT_TYPES];
+
+static Counter* dispatched_count = Counters::Find("events/dispatched");
+static Counter* remaining_count = Counters::Find("events/remaining", COUNTER_GAUGE);
 
 Event::Event(EventType t, EventListener * lis, Cvar d1, Cvar d2)
 	: type(t), listener(lis), data1(d1), data2(d2), timestamp(SDL_GetTicks())
 {}
 
+// Copies keep the original timestamp so queue latency can be measured
 Event::Event(const Event& e)
-	: type(e.type), listener(e.listener), data1(e.data1), data2(e.data2), timestamp(SDL_GetTicks())
+	: type(e.type), listener(e.listener), data1(e.data1), data2(e.data2), timestamp(e.timestamp)
 {}
 
 Event::~Event()
@@ -28,52 +37,211 @@ bool Event::IsValid() const
 	return type < MAX_EVENT_TYPES && listener != nullptr;
 }
 
+void Event::Dispatch() const
+{
+	if (IsValid())
+	{
+		// Record queue latency
+		unsigned int ms = SDL_GetTicks() - timestamp;
+		unsigned int bucket = 0u;
+		for (unsigned int limit = 1u; ms >= limit && bucket < EVENT_LATENCY_BUCKETS - 1; limit <<= 1)
+			++bucket;
+
+		LatencyStats& stats = latency[type];
+		stats.buckets[bucket]++;
+		stats.count++;
+		stats.total += ms;
+		if (ms > stats.max) stats.max = ms;
+
+		dispatched_count->Add();
+		CallListener();
+	}
+}
+
 void Event::Push(EventType t, EventListener * lis, Cvar d1, Cvar d2)
 {
 	if (!Event::paused)
-		Event::events_queue.push(Event(t, lis, d1, d2));
+		Event::events_queue[GetPriority(t)].push(Event(t, lis, d1, d2));
 }
 
 void Event::Push(EventType t, std::vector<EventListener*>& lis, Cvar d1, Cvar d2)
 {
 	if (!Event::paused)
+	{
+		std::queue<Event>& queue = Event::events_queue[GetPriority(t)];
 		for (std::vector<EventListener*>::iterator it = lis.begin(); it != lis.end(); ++it)
-			Event::events_queue.push(Event(t, *it, d1, d2));
+			queue.push(Event(t, *it, d1, d2));
+	}
 }
 
 void Event::Push(const Event e)
 {
 	if (!Event::paused)
-		Event::events_queue.push(e);
+		Event::events_queue[GetPriority(e.type)].push(e);
 }
 
 void Event::PumpAll()
 {
-	while (!Event::events_queue.empty())
-	{
-		const Event e = Event::events_queue.front();
-		Event::events_queue.pop();
+	while (RemainingEvents() > 0)
+		Pump();
 
-		if (e.IsValid())
-			e.CallListener();
-	}
+	remaining_count->Set(0);
 }
 
 void Event::Pump()
 {
-	if (!Event::events_queue.empty())
+	for (int i = 0; i < MAX_EVENT_PRIORITIES; ++i)
 	{
-		const Event e = Event::events_queue.front();
-		Event::events_queue.pop();
+		if (!Event::events_queue[i].empty())
+		{
+			const Event e = Event::events_queue[i].front();
+			Event::events_queue[i].pop();
+			e.Dispatch();
+			break;
+		}
+	}
+}
 
-		if (e.IsValid())
-			e.CallListener();
+void Event::PumpCritical(unsigned int deadline)
+{
+	// Critical events never wait for spare frame time. Only the ones queued
+	// now: a listener pushing another critical event must not livelock the frame
+	DispatchCritical();
+
+	// Bound the age of everything else: queues are FIFO, so only fronts need checking.
+	// At least one aged event goes through each frame, then the deadline applies
+	unsigned int now = SDL_GetTicks();
+	unsigned int promoted = 0u;
+	for (int i = EVENT_NORMAL; i < MAX_EVENT_PRIORITIES && promoted < EVENT_MAX_PROMOTED; ++i)
+	{
+		while (!Event::events_queue[i].empty() && now - Event::events_queue[i].front().timestamp >= EVENT_MAX_AGE_MS)
+		{
+			if (promoted >= EVENT_MAX_PROMOTED || (promoted > 0u && SDL_GetTicks() >= deadline))
+				return;
+
+			const Event e = Event::events_queue[i].front();
+			Event::events_queue[i].pop();
+			e.Dispatch();
+			promoted++;
+
+			// Critical events pushed by listeners go first
+			DispatchCritical();
+		}
 	}
 }
 
+void Event::DispatchCritical()
+{
+	std::queue<Event>& critical = Event::events_queue[EVENT_CRITICAL];
+
+	for (unsigned int count = critical.size(); count > 0u && !critical.empty(); --count)
+	{
+		const Event e = critical.front();
+		critical.pop();
+		e.Dispatch();
+	}
+}
+
+void Event::PumpFor(unsigned int ms)
+{
+	unsigned int deadline = SDL_GetTicks() + ms;
+
+	PumpCritical(deadline);
+
+	while (RemainingEvents() > 0 && SDL_GetTicks() < deadline)
+		Pump();
+
+	remaining_count->Set(RemainingEvents());
+}
+
 unsigned int Event::RemainingEvents()
 {
-	return Event::events_queue.size();
+	unsigned int ret = 0u;
+	for (int i = 0; i < MAX_EVENT_PRIORITIES; ++i)
+		ret += Event::events_queue[i].size();
+
+	return ret;
+}
+
+unsigned int Event::RemainingEvents(EventPriority priority)
+{
+	return Event::events_queue[priority].size();
+}
+
+EventPriority Event::GetPriority(EventType t)
+{
+	switch (t)
+	{
+	case REQUEST_LOAD:
+	case REQUEST_SAVE:
+	case REQUEST_QUIT:
+	case WINDOW_QUIT:
+	case SCENE_PLAY:
+	case SCENE_PAUSE:
+	case SCENE_TICK:
+	case SCENE_STOP:
+	case SPAWN_UNIT:
+	case ON_SELECT:
+	case ON_UNSELECT:
+	case ON_RIGHT_CLICK:
+	case DAMAGE:
+	case UPDATE_PATH:
+	case REPATH:
+		return EVENT_CRITICAL;
+
+	case PLAY_FX:
+	case HALT_FX:
+	case HOVER_IN:
+	case HOVER_OUT:
+	case CAMERA_MOVED:
+	case MINIMAP_UPDATE_TEXTURE:
+	case DRAW_RANGE:
+	case SHOW_SPRITE:
+	case HIDE_SPRITE:
+	case CHECK_FOW:
+	case ON_COLLISION:
+		return EVENT_LOW;
+
+	default:
+		return EVENT_NORMAL;
+	}
+}
+
+const unsigned int* Event::GetLatencyHistogram(EventType t)
+{
+	return t < MAX_EVENT_TYPES ? latency[t].buckets : nullptr;
+}
+
+unsigned int Event::GetMaxLatency(EventType t)
+{
+	return t < MAX_EVENT_TYPES ? latency[t].max : 0u;
+}
+
+float Event::GetAverageLatency(EventType t)
+{
+	return (t < MAX_EVENT_TYPES && latency[t].count > 0u) ? float(double(latency[t].total) / double(latency[t].count)) : 0.f;
+}
+
+void Event::ResetLatencyStats()
+{
+	memset(latency, 0, sizeof(latency));
+}
+
+void Event::LogLatencyStats()
+{
+	LOG("Event queue latency (ms buckets: <1 <2 <4 <8 <16 <32 <64 <128 <256 >=256)");
+
+	for (int t = 0; t < MAX_EVENT_TYPES; ++t)
+	{
+		const LatencyStats& stats = latency[t];
+		if (stats.count > 0u)
+		{
+			const unsigned int* b = stats.buckets;
+			LOG("Event type %d (priority %d): count %u, avg %.2f ms, max %u ms | %u %u %u %u %u %u %u %u %u %u",
+				t, int(GetPriority(EventType(t))), stats.count, GetAverageLatency(EventType(t)), stats.max,
+				b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7], b[8], b[9]);
+		}
+	}
 }
 
 void Event::ResumeEvents()
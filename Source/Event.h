@@ -113,6 +113,21 @@ enum EventType : char
 	MAX_EVENT_TYPES
 };
 
+enum EventPriority : char
+{
+	EVENT_CRITICAL,	// drained every frame
+	EVENT_NORMAL,	// pumped while frame time remains
+	EVENT_LOW,		// cosmetic and high-volume events
+	MAX_EVENT_PRIORITIES
+};
+
+// Queue latency histogram buckets: [0,1) [1,2) [2,4) ... [256,inf) ms
+#define EVENT_LATENCY_BUCKETS 10
+// Normal and low events older than this are drained as critical ones
+#define EVENT_MAX_AGE_MS 100u
+// Aged events drained that way per frame at most
+#define EVENT_MAX_PROMOTED 64u
+
 class Event
 {
 public:
@@ -126,7 +141,19 @@ public:
 	static void Push(const Event e);
 	static void PumpAll();
 	static void Pump();
+	static void PumpCritical(unsigned int deadline);
+	static void PumpFor(unsigned int ms);
 	static unsigned int RemainingEvents();
+	static unsigned int RemainingEvents(EventPriority priority);
+
+	static EventPriority GetPriority(EventType t);
+
+	// Latency metrics
+	static const unsigned int* GetLatencyHistogram(EventType t);
+	static unsigned int GetMaxLatency(EventType t);
+	static float GetAverageLatency(EventType t);
+	static void ResetLatencyStats();
+	static void LogLatencyStats();
 
 	static void ResumeEvents();
 	static void PauseEvents();
@@ -135,6 +162,8 @@ public:
 private:
 
 	void CallListener() const;
+	void Dispatch() const;
+	static void DispatchCritical(); // the critical events queued so far
 	bool IsValid() const;
 	void Clear();
 
@@ -149,7 +178,17 @@ public:
 private:
 
 	static bool paused;
-	static std::queue<Event> events_queue;
+	static std::queue<Event> events_queue[MAX_EVENT_PRIORITIES];
+
+	struct LatencyStats
+	{
+		unsigned int buckets[EVENT_LATENCY_BUCKETS];
+		unsigned int count;
+		unsigned int max;
+		unsigned long long total;
+	};
+
+	static LatencyStats latency[MAX_EVENT_TYPES];
 };
 
 #endif // __EVENT_H__
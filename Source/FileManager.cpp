@@ -1,10 +1,14 @@
 #include "FileManager.h"
+#include "Application.h"
 #include "Defs.h"
 #include "Log.h"
 
 #include "SDL/include/SDL.h"
 #include "physfs-3.0.2/include/physfs.h"
 
+#include <string.h> // before miniz, it uses memcpy/memset unqualified
+#include "physfs-3.0.2/include/physfs_miniz.h"
+
 #ifdef DEBUG
 #ifdef PLATFORMx86
 #pragma comment( lib, "physfs-3.0.2/x86/DebugData/physfs.lib" )
@@ -39,6 +43,9 @@ bool FileManager::Init(const char* argv0)
 
 		if (ret)
 		{
+			if (PHYSFS_setWriteDir(path) == 0)
+				LOG("Error setting write directory: %s", PHYSFS_getLastError());
+
 			base_path = path;
 			std::string assets_path = base_path + "Assets.zip";
 			if (!(ret = AddDirectory(assets_path.c_str(), NULL)))
@@ -76,7 +83,7 @@ const char* FileManager::GetBasePath()
 	return base_path.c_str();
 }
 
-pugi::xml_node& FileManager::ConfigNode()
+pugi::xml_node FileManager::ConfigNode()
 {
 	return config.first_child();
 }
@@ -159,24 +166,78 @@ unsigned int FileManager::Load(const char* file, char** buffer) const
 
 SDL_RWops* FileManager::LoadRWops(const char* file) const
 {
-	char* buffer;
-	int size = Load(file, &buffer);
+	return App->assets.Open(file);
+}
+
+bool FileManager::Exists(const char* file) const
+{
+	return PHYSFS_exists(file) != 0;
+}
+
+bool FileManager::Save(const char* file, const char* buffer, unsigned int size, std::string* error) const
+{
+	bool ret = false;
+	const char* failed = nullptr;
+
+	std::string dir = file;
+	std::string::size_type slash = dir.find_last_of('/');
+	if (slash != std::string::npos)
+		PHYSFS_mkdir(dir.substr(0, slash).c_str());
+
+	PHYSFS_file* fs_file = PHYSFS_openWrite(file);
 
-	if (size > 0)
+	if (fs_file != NULL)
 	{
-		SDL_RWops* r = SDL_RWFromConstMem(buffer, size);
-		if (r != nullptr)
-			r->close = close_sdl_rwops;
+		PHYSFS_sint64 written = PHYSFS_writeBytes(fs_file, buffer, size);
+		if (!(ret = (written == PHYSFS_sint64(size))))
+			failed = "writing to";
 
-		return r;
+		if (PHYSFS_close(fs_file) == 0 && ret)
+		{
+			failed = "closing";
+			ret = false;
+		}
 	}
 	else
-		return NULL;
+		failed = "opening";
+
+	if (failed != nullptr)
+	{
+		std::string message = std::string("File System error while ") + failed + " file " + file + ": " + PHYSFS_getLastError();
+
+		if (error != nullptr)
+			*error = message;
+		else
+			LOG("%s", message.c_str());
+	}
+
+	return ret;
+}
+
+long long FileManager::GetLastModTime(const char* file) const
+{
+	PHYSFS_Stat stat;
+	return PHYSFS_stat(file, &stat) != 0 ? stat.modtime : -1;
 }
 
-int close_sdl_rwops(SDL_RWops* rw)
+unsigned int FileManager::Inflate(const char* source, unsigned int size, char* destination, unsigned int capacity, bool zlib_header)
 {
-	DEL_ARRAY(rw->hidden.mem.base);
-	SDL_FreeRW(rw);
-	return 0;
-}
\ No newline at end of file
+	tinfl_decompressor inflator;
+	tinfl_init(&inflator);
+
+	size_t in_size = size;
+	size_t out_size = capacity;
+	mz_uint32 flags = TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF | (zlib_header ? TINFL_FLAG_PARSE_ZLIB_HEADER : 0);
+
+	tinfl_status status = tinfl_decompress(&inflator,
+		reinterpret_cast<const mz_uint8*>(source), &in_size,
+		reinterpret_cast<mz_uint8*>(destination), reinterpret_cast<mz_uint8*>(destination), &out_size, flags);
+
+	if (status != TINFL_STATUS_DONE)
+	{
+		LOG("Inflate error: status %d after %d bytes", int(status), int(out_size));
+		return 0u;
+	}
+
+	return (unsigned int)out_size;
+}
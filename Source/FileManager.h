@@ -3,12 +3,10 @@
 
 #include <string>
 
-#include "PugiXml\src\pugixml.hpp"
+#include "PugiXml/src/pugixml.hpp"
 
 struct SDL_RWops;
 
-int close_sdl_rwops(SDL_RWops* rw);
-
 class FileManager
 {
 public:
@@ -22,14 +20,26 @@ public:
 	bool AddDirectory(const char* path, const char* mount_point = nullptr);
 	const char* GetBasePath();
 
-	static pugi::xml_node& ConfigNode();
+	static pugi::xml_node ConfigNode();
 
 	bool SaveConfig() const;
 	bool LoadConfig();
 	bool LoadXML(const char* file, pugi::xml_document& doc);
 
 	unsigned int Load(const char* file, char** buffer) const;
-	SDL_RWops* LoadRWops(const char* file) const;
+	SDL_RWops* LoadRWops(const char* file) const; // read only, through the asset cache
+
+	bool Exists(const char* file) const;
+
+	// Writes under the base path, creating missing directories. With an
+	// error string nothing is logged, so worker jobs can call it
+	bool Save(const char* file, const char* buffer, unsigned int size, std::string* error = nullptr) const;
+
+	// Seconds since epoch, -1 if unknown or missing
+	long long GetLastModTime(const char* file) const;
+
+	// Raw deflate or zlib stream into a buffer of known size, returns bytes written
+	static unsigned int Inflate(const char* source, unsigned int size, char* destination, unsigned int capacity, bool zlib_header);
 
 public:
 
@@ -10,6 +10,8 @@
 #include "Log.h"
 #include "JuicyMath.h"
 
+#include "optick-1.3.0.0/include/optick.h"
+
 #include <vector>
 
 std::vector<std::vector<bool> > FogOfWarManager::fogMap;
@@ -121,7 +123,51 @@ void FogOfWarManager::DeleteFoWMap()
 
 void FogOfWarManager::Update()
 {
-	ResetFoWMap();
+	OPTICK_EVENT();
+
+	if (fogMap.empty())
+		return;
+
+	visionSources.clear();
+	for (std::vector<Behaviour*>::iterator it = Behaviour::b_list.begin(); it != Behaviour::b_list.end(); ++it)
+	{
+		if ((*it)->providesVisibility && (*it)->ActiveThisPass())
+		{
+			VisionArea area;
+			(*it)->GetVisionArea(area);
+			visionSources.push_back(area);
+		}
+	}
+
+	// Every job owns whole columns so no two threads write the same bit vector
+	App->jobs.ParallelFor("FoW Stamp", (unsigned int)width, FOW_COLUMNS_PER_JOB, [this](unsigned int first, unsigned int last)
+	{
+		StampColumns(int(first), int(last));
+	});
+}
+
+void FogOfWarManager::StampColumns(int first, int last)
+{
+	for (int x = first; x < last; x++)
+		for (int y = 0; y < height; y++)
+			fogMap[x][y] = false;
+
+	for (std::vector<VisionArea>::const_iterator it = visionSources.cbegin(); it != visionSources.cend(); ++it)
+	{
+		int start_x = it->start.x > first ? it->start.x : first;
+		int end_x = it->end.x < last ? it->end.x : last;
+		int start_y = it->start.y > 0 ? it->start.y : 0;
+		int end_y = it->end.y < height ? it->end.y : height;
+
+		for (int x = start_x; x < end_x; x++)
+		{
+			for (int y = start_y; y < end_y; y++)
+			{
+				if (iPoint(x, y).DistanceTo(it->center) <= it->radius)
+					fogMap[x][y] = true;
+			}
+		}
+	}
 }
 
 void FogOfWarManager::UpdateFoWMap()
@@ -9,6 +9,16 @@
 #include "Gameobject.h"
 #include "FoWDefs.h"
 
+#define FOW_COLUMNS_PER_JOB 16u
+
+struct VisionArea
+{
+	iPoint start;	// first tile of the bounding box
+	iPoint end;		// one past the last tile
+	iPoint center;
+	float radius;
+};
+
 struct FoWDataStruct
 {
 	unsigned short tileFogBits; //saves information about which type of fog are we in (useful for smooth edges)
@@ -27,6 +37,8 @@ public:
 
 	//Resets the map to its shrouded state
 	void ResetFoWMap();
+	//Resets and stamps every vision area over columns [first, last), run as a job
+	void StampColumns(int first, int last);
 	void CreateFoWMap();
 	void DeleteFoWMap();
 	//Updates the data on the FoWMap based on the FoWEntities position and mask shape
@@ -56,6 +68,9 @@ private:
 	int smoothTexID = -1;
 	int debugTexID = -1;
 
+	//Visibility providers gathered on the main thread each frame
+	std::vector<VisionArea> visionSources;
+
 	//Map that we use to translate bits to Texture Id's
 	std::map<unsigned short, int> bitToTextureTable;
 
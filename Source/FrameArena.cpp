@@ -0,0 +1,131 @@
+#include "FrameArena.h"
+#include "Application.h"
+#include "Counters.h"
+#include "Log.h"
+
+#include <stdlib.h>
+
+static Counter* arena_count = Counters::Find("memory/arena allocations", COUNTER_GAUGE);
+static Counter* overflow_count = Counters::Find("memory/arena overflows", COUNTER_GAUGE);
+
+FrameArena::FrameArena()
+{}
+
+FrameArena::~FrameArena()
+{
+	CleanUp();
+}
+
+void* FrameArena::Allocate(size_t bytes, size_t align)
+{
+	allocations++;
+
+	if (buffer == nullptr)
+	{
+		capacity = FRAME_ARENA_SIZE;
+		buffer = static_cast<char*>(malloc(capacity));
+	}
+
+	size_t start = (offset + align - 1u) & ~(align - 1u);
+	if (buffer != nullptr && start + bytes <= capacity)
+	{
+		offset = start + bytes;
+		return buffer + start;
+	}
+
+	// Full: this frame pays a heap allocation, the next ones get a bigger buffer
+	void* ret = malloc(bytes);
+	overflows.push_back(ret);
+	overflow_bytes += bytes + align;
+	return ret;
+}
+
+void FrameArena::Reset()
+{
+	last_used = offset + overflow_bytes;
+	last_allocations = allocations;
+	last_overflows = overflows.size();
+	arena_count->Set(last_allocations);
+	overflow_count->Set(last_overflows);
+
+	if (last_used > peak)
+		peak = last_used;
+
+	frames++;
+	total_allocations += allocations;
+	total_overflows += overflows.size();
+
+	for (std::vector<void*>::iterator it = overflows.begin(); it != overflows.end(); ++it)
+		free(*it);
+
+	if (!overflows.empty())
+	{
+		while (capacity < last_used)
+			capacity *= 2u;
+
+		free(buffer);
+		buffer = static_cast<char*>(malloc(capacity));
+		LOG("Frame arena grown to %u KB", (unsigned int)(capacity / 1024u));
+	}
+
+	overflows.clear();
+	overflow_bytes = 0u;
+	offset = 0u;
+	allocations = 0u;
+}
+
+void FrameArena::CleanUp()
+{
+	for (std::vector<void*>::iterator it = overflows.begin(); it != overflows.end(); ++it)
+		free(*it);
+
+	overflows.clear();
+	free(buffer);
+	buffer = nullptr;
+	capacity = offset = overflow_bytes = 0u;
+}
+
+unsigned int FrameArena::GetAllocations() const
+{
+	return last_allocations;
+}
+
+unsigned int FrameArena::GetOverflows() const
+{
+	return last_overflows;
+}
+
+size_t FrameArena::GetUsed() const
+{
+	return last_used;
+}
+
+size_t FrameArena::GetCapacity() const
+{
+	return capacity;
+}
+
+unsigned int FrameArena::GetFrames() const
+{
+	return frames;
+}
+
+unsigned long long FrameArena::GetTotalAllocations() const
+{
+	return total_allocations;
+}
+
+unsigned long long FrameArena::GetTotalOverflows() const
+{
+	return total_overflows;
+}
+
+size_t FrameArena::GetPeak() const
+{
+	return peak;
+}
+
+void* FrameAllocate(size_t bytes, size_t align)
+{
+	return App->frameArena.Allocate(bytes, align);
+}
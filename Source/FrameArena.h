@@ -0,0 +1,76 @@
+#ifndef __FRAME_ARENA_H__
+#define __FRAME_ARENA_H__
+
+#include <stddef.h>
+#include <vector>
+
+#define FRAME_ARENA_SIZE (1024u * 1024u) // starting capacity, grows to the frame peak
+
+// Linear allocator for temporaries that die with the frame: every
+// allocation bumps an offset and nothing is freed until Reset, at the end
+// of Application::Update. Frames that run out fall back to the heap and
+// the buffer grows to fit them on the next Reset. Main thread only.
+class FrameArena
+{
+public:
+
+	FrameArena();
+	~FrameArena();
+
+	void* Allocate(size_t bytes, size_t align);
+	void Reset();
+	void CleanUp();
+
+	// Last finished frame
+	unsigned int GetAllocations() const;
+	unsigned int GetOverflows() const; // heap allocations done because the buffer was full
+	size_t GetUsed() const;
+	size_t GetCapacity() const;
+
+	// Since start
+	unsigned int GetFrames() const;
+	unsigned long long GetTotalAllocations() const;
+	unsigned long long GetTotalOverflows() const;
+	size_t GetPeak() const;
+
+private:
+
+	char* buffer = nullptr;
+	size_t capacity = 0u;
+	size_t offset = 0u;
+	size_t overflow_bytes = 0u;
+	std::vector<void*> overflows;
+
+	// Counters
+	unsigned int allocations = 0u;
+	unsigned int last_allocations = 0u;
+	unsigned int last_overflows = 0u;
+	size_t last_used = 0u;
+	size_t peak = 0u;
+	unsigned int frames = 0u;
+	unsigned long long total_allocations = 0u;
+	unsigned long long total_overflows = 0u;
+};
+
+void* FrameAllocate(size_t bytes, size_t align); // App->frameArena
+
+// STL allocator on the frame arena: containers using it must not outlive the frame
+template<typename T>
+struct FrameAllocator
+{
+	typedef T value_type;
+
+	FrameAllocator() {}
+	template<typename U> FrameAllocator(const FrameAllocator<U>&) {}
+
+	T* allocate(size_t n) { return static_cast<T*>(FrameAllocate(n * sizeof(T), alignof(T))); }
+	void deallocate(T*, size_t) {}
+
+	template<typename U> bool operator==(const FrameAllocator<U>&) const { return true; }
+	template<typename U> bool operator!=(const FrameAllocator<U>&) const { return false; }
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+#endif // __FRAME_ARENA_H__
@@ -16,11 +16,13 @@
 #include "Edge.h"
 #include "EdgeCapsule.h"
 #include "Spawner.h"
+#include "ByteStream.h"
 #include "Log.h"
 
 #include "optick-1.3.0.0/include/optick.h"
 
 double Gameobject::go_count = 0;
+unsigned int Gameobject::current_pass = 0u;
 
 Gameobject::Gameobject(const char* n, Gameobject* p) : id(++go_count), name(n), parent(p)
 {
@@ -47,49 +49,45 @@ Gameobject::~Gameobject()
 		DEL(*component);
 }
 
-void Gameobject::PreUpdate()
+void Gameobject::HierarchyPass(UpdatePhase phase)
 {
-	for (std::vector<Component*>::iterator component = components.begin(); component != components.end(); ++component)
-		if ((*component)->IsActive())
-			(*component)->PreUpdate();
-
-	for (std::vector<Gameobject*>::iterator child = childs.begin(); child != childs.end(); ++child)
-		if ((*child)->active)
-			(*child)->PreUpdate();
-}
-
-void Gameobject::Update()
-{
-	OPTICK_EVENT();
+	if (active)
+		pass_stamp = current_pass;
 
-	if (death_timer > 0.f)
+	if (phase == UPDATE_PHASE)
 	{
-		death_timer -= App->time.GetGameDeltaTime();
+		if (death_timer > 0.f)
+		{
+			death_timer -= App->time.GetGameDeltaTime();
 
-		if (death_timer <= 0.f)
-			Destroy();
-	}
+			if (death_timer <= 0.f)
+				Destroy();
+		}
 
-	UpdateRemoveQueue();
+		UpdateRemoveQueue();
+	}
 
-	for (std::vector<Component*>::iterator component = components.begin(); component != components.end(); ++component)
-		if ((*component)->IsActive())
-			(*component)->Update();
+	// UI components keep hierarchy order so parents draw before their childs
+	if (ui != nullptr && pass_stamp == current_pass)
+	{
+		for (std::vector<Component*>::iterator component = components.begin(); component != components.end(); ++component)
+		{
+			const ComponentType type = (*component)->GetType();
+			if (type >= UI_GENERAL && type < UI_MAX && (*component)->ActiveThisPass())
+			{
+				switch (phase)
+				{
+				case PRE_UPDATE_PHASE: (*component)->PreUpdate(); break;
+				case UPDATE_PHASE: (*component)->Update(); break;
+				case POST_UPDATE_PHASE: (*component)->PostUpdate(); break;
+				}
+			}
+		}
+	}
 
 	for (int i = 0; i < childs.size(); ++i)
 		if (childs[i] != nullptr && childs[i]->active)
-			childs[i]->Update();
-}
-
-void Gameobject::PostUpdate()
-{
-	for (std::vector<Component*>::iterator component = components.begin(); component != components.end(); ++component)
-		if ((*component)->IsActive())
-			(*component)->PostUpdate();
-
-	for (std::vector<Gameobject*>::iterator child = childs.begin(); child != childs.end(); ++child)
-		if ((*child)->active)
-			(*child)->PostUpdate();
+			childs[i]->HierarchyPass(phase);
 }
 
 bool Gameobject::IsActive() const
@@ -292,11 +290,31 @@ bool Gameobject::Destroy(float ms)
 	toDestroy = true;
 
 	if ((death_timer = ms) <= 0.f)
-		ret = (parent != nullptr && parent->RemoveChild(this));
+	{
+		// Dead units are parked in their pool instead of deleted
+		if (behaviour != nullptr && App->unitPool.Release(behaviour))
+			toDestroy = false;
+		else
+		{
+			if (behaviour != nullptr)
+				behaviour->DestroyPanels();
+
+			ret = (parent != nullptr && parent->RemoveChild(this));
+		}
+	}
 
 	return ret;
 }
 
+void Gameobject::RenewComponents()
+{
+	for (std::vector<Component*>::iterator component = components.begin(); component != components.end(); ++component)
+		(*component)->Renew();
+
+	for (std::vector<Gameobject*>::iterator child = childs.begin(); child != childs.end(); ++child)
+		(*child)->RenewComponents();
+}
+
 void Gameobject::UpdateRemoveQueue()
 {
 	while (!comp_to_remove.empty())
@@ -307,6 +325,9 @@ void Gameobject::UpdateRemoveQueue()
 		{
 			if (comp_id == (*it)->GetID())
 			{
+				if (*it == transform)
+					transform = nullptr; // UI components drop it, childs check for it
+
 				DEL(*it);
 				components.erase(it);
 				break;
@@ -337,6 +358,26 @@ void Gameobject::UpdateRemoveQueue()
 	}
 }
 
+// Behaviours that can be rebuilt from a save
+static Behaviour* CreateSavedBehaviour(Gameobject* go, UnitType type)
+{
+	switch (type)
+	{
+	case GATHERER: return new Gatherer(go);
+	case UNIT_MELEE: return new MeleeUnit(go);
+	case UNIT_RANGED: return new RangedUnit(go);
+	case ENEMY_MELEE: return new EnemyMeleeUnit(go);
+	case BASE_CENTER: return new Base_Center(go);
+	case TOWER: return new Tower(go, false);
+	case BARRACKS: return new Barracks(go, false);
+	case LAB: return new Lab(go, false);
+	case EDGE: return new Edge(go);
+	case CAPSULE: return new Capsule(go);
+	case SPAWNER: return new Spawner(go);
+	default: return nullptr;
+	}
+}
+
 void Gameobject::Load(pugi::xml_node& node)
 {
 	// Setup Childs
@@ -345,66 +386,9 @@ void Gameobject::Load(pugi::xml_node& node)
 		Gameobject* go = new Gameobject(bh_node.attribute("name").as_string("from XML"), this);
 		go->transform->Load(bh_node);
 
-		switch (UnitType(bh_node.attribute("type").as_int(0)))
-		{
-		case GATHERER:
-		{
-			(new Gatherer(go))->Load(bh_node);
-			break;
-		}
-		case UNIT_MELEE:
-		{
-			(new MeleeUnit(go))->Load(bh_node);
-			break;
-		}
-		case UNIT_RANGED:
-		{
-			(new RangedUnit(go))->Load(bh_node);
-			break;
-		}
-		case ENEMY_MELEE:
-		{
-			(new EnemyMeleeUnit(go))->Load(bh_node);
-			break;
-		}
-		case BASE_CENTER:
-		{
-			(new Base_Center(go))->Load(bh_node);
-			break;
-		}
-		case TOWER:
-		{
-			(new Tower(go, false))->Load(bh_node);
-			break;
-		}
-		case BARRACKS:
-		{
-			(new Barracks(go, false))->Load(bh_node);
-			break;
-		}
-		case LAB:
-		{
-			(new Lab(go, false))->Load(bh_node);
-			break;
-		}
-		case EDGE:
-		{
-			(new Edge(go))->Load(bh_node);
-			break;
-		}
-		case CAPSULE:
-		{
-			(new Capsule(go))->Load(bh_node);
-			break;
-		}
-		case SPAWNER:
-		{
-			(new Spawner(go))->Load(bh_node);
-			break;
-		}
-		default:
-			break;
-		}
+		Behaviour* bh = CreateSavedBehaviour(go, UnitType(bh_node.attribute("type").as_int(0)));
+		if (bh != nullptr)
+			bh->Load(bh_node);
 	}
 }
 
@@ -424,13 +408,58 @@ void Gameobject::Save(pugi::xml_node& node) const
 	}
 }
 
+void Gameobject::Load(ByteReader& in)
+{
+	unsigned int count = 0u;
+	in.Read(count);
+
+	std::string go_name;
+	for (unsigned int i = 0u; i < count && in.Good(); ++i)
+	{
+		int type = 0;
+		in.Read(type);
+		in.ReadString(go_name);
+
+		Gameobject* go = new Gameobject(go_name.c_str(), this);
+		go->transform->Load(in);
+
+		Behaviour* bh = CreateSavedBehaviour(go, UnitType(type));
+		if (bh != nullptr)
+			bh->Load(in);
+		else
+			Behaviour::SkipRecord(in);
+	}
+}
+
+void Gameobject::Save(ByteWriter& out) const
+{
+	unsigned int count = 0u;
+	for (std::vector<Gameobject*>::const_iterator it = childs.cbegin(); it != childs.cend(); ++it)
+		if ((*it)->behaviour != nullptr && (*it)->active)
+			count++;
+
+	// Record: type, name, transform, behaviour
+	out.Write(count);
+	for (std::vector<Gameobject*>::const_iterator it = childs.cbegin(); it != childs.cend(); ++it)
+	{
+		const Behaviour* bh = (*it)->behaviour;
+		if (bh != nullptr && (*it)->active)
+		{
+			out.Write(int(bh->GetType()));
+			out.WriteString((*it)->name);
+			(*it)->transform->Save(out);
+			bh->Save(out);
+		}
+	}
+}
+
 void Gameobject::AddNewChild(Gameobject * child)
 {
 	if (child != nullptr)
 	{
 		childs.push_back(child);
 
-		if (child->transform)
+		if (child->transform && transform)
 			child->transform->SetParent(transform);
 	}
 }
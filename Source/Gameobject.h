@@ -11,6 +11,13 @@ class Behaviour;
 class UI_Component;
 class Collider;
 
+enum UpdatePhase : int
+{
+	PRE_UPDATE_PHASE,
+	UPDATE_PHASE,
+	POST_UPDATE_PHASE
+};
+
 class Gameobject : public EventListener
 {
 public:
@@ -19,9 +26,10 @@ public:
 	Gameobject(const Gameobject& copy);
 	~Gameobject();
 
-	void PreUpdate();
-	void Update();
-	void PostUpdate();
+	// Walks the tree once per phase: caches active state, runs removals and UI components
+	void HierarchyPass(UpdatePhase phase);
+	static void BeginPass() { ++current_pass; }
+	bool ActiveThisPass() const { return pass_stamp == current_pass; }
 
 	bool IsActive() const;
 	void SetActive() { active = true; }
@@ -54,6 +62,7 @@ public:
 	bool RemoveChild(Gameobject* child);
 	bool RemoveComponent(Component* comp);
 	bool Destroy(float ms = 0.f);
+	void RenewComponents(); // pooled: re-issues ids & handles of the whole bundle
 	void UpdateRemoveQueue();
 	bool BeingDestroyed() { return toDestroy; }
 	void SetStatic(bool s) { isStatic = s; }
@@ -61,6 +70,8 @@ public:
 
 	void Load(pugi::xml_node& node);
 	void Save(pugi::xml_node& node) const;
+	void Load(ByteReader& in);
+	void Save(ByteWriter& out) const;
 
 private:
 
@@ -69,11 +80,13 @@ private:
 private:
 
 	static double go_count;
+	static unsigned int current_pass;
 
 	std::string name;
 	double id;
 	bool active = true;
 	bool isStatic = false;
+	unsigned int pass_stamp = 0u;
 
 	std::vector<Component*> components;
 	std::vector<Gameobject*> childs;
@@ -11,13 +11,7 @@
 
 Gatherer::Gatherer(Gameobject* go) : B_Unit(go, GATHERER, IDLE, B_GATHERER)
 {
-	atkTime = 2.0f;
-	speed = 3;
-	damage = 10;
-	current_life = max_life = 20;
-	attack_range = 2.0f;
-	vision_range = 20.0f;
-	providesVisibility = true;
+	ResetStats();
 	deathFX = GATHERER_DIE_FX;
 	attackFX = GATHERER_ATK_FX;
 
@@ -34,10 +28,21 @@ Gatherer::Gatherer(Gameobject* go) : B_Unit(go, GATHERER, IDLE, B_GATHERER)
 
 Gatherer::~Gatherer(){}
 
+void Gatherer::ResetStats()
+{
+	//Stats
+	atkTime = 2.0f;
+	speed = 3;
+	damage = 10;
+	current_life = max_life = 20;
+	attack_range = 2.0f;
+	vision_range = 20.0f;
+	providesVisibility = true;
+}
+
 void Gatherer::Update()
 {
-	if (providesVisibility) GetTilesInsideRadius();
-	else CheckFoWMap();
+	if (!providesVisibility) CheckFoWMap();
 
 	if (current_state != DESTROYED)
 	{
@@ -53,7 +58,6 @@ void Gatherer::Update()
 					if (!atkObj->IsDestroyed()) //Attack
 					{
 						DoAttack();
-						Event::Push(DAMAGE, atkObj, damage, GetType());
 					}
 					else
 						atkObj = nullptr;
@@ -66,7 +70,6 @@ void Gatherer::Update()
 				if (!atkObj->IsDestroyed()) //ATTACK
 				{
 					DoAttack();
-					Event::Push(DAMAGE, atkObj, damage, GetType());
 				}
 				else
 					atkObj = nullptr;
@@ -108,7 +111,7 @@ void Gatherer::Update()
 			if (path != nullptr && !path->empty())
 				CheckPathTiles();
 
-			if (move && PathfindingManager::unitWalkability[nextTile.x][nextTile.y] == GetID())
+			if (move && App->pathfinding.IsTileReservedBy(nextTile.x, nextTile.y, GetHandle()))
 			{
 				calculating_path = false;
 				nonMovingCounter = 0.0f;
@@ -129,14 +132,7 @@ void Gatherer::Update()
 				else
 					dirY = 0;
 
-				game_object->GetTransform()->MoveX(dirX * speed * App->time.GetGameDeltaTime());//Move x
-				game_object->GetTransform()->MoveY(dirY * speed * App->time.GetGameDeltaTime());//Move y
-
-				if (App->pathfinding.ValidTile(int(pos.x), int(pos.y)) == false)
-				{
-					game_object->GetTransform()->MoveX(-dirX * speed * App->time.GetGameDeltaTime());//Move x back
-					game_object->GetTransform()->MoveY(-dirY * speed * App->time.GetGameDeltaTime());//Move y back
-				}
+				Steer();
 
 				ChangeState();
 				CheckDirection(actualPos);
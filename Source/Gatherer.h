@@ -14,6 +14,7 @@ public:
 	Gatherer(Gameobject* go);
 	~Gatherer();
 
+	void ResetStats() override;
 	void Update() override;
 	void CreatePanel() override;
 
@@ -0,0 +1,393 @@
+#include "GroupMovement.h"
+#include "Application.h"
+#include "PathfindingManager.h"
+#include "Behaviour.h"
+#include "Log.h"
+#include "Defs.h"
+
+#include "optick-1.3.0.0/include/optick.h"
+
+#include <algorithm>
+
+GroupMovement::GroupMovement()
+{}
+
+GroupMovement::~GroupMovement()
+{}
+
+void GroupMovement::Update()
+{
+	OPTICK_EVENT();
+
+	for (std::vector<Order>::iterator order = orders.begin(); order != orders.end();)
+	{
+		// Leader path still being searched
+		if (App->pathfinding.GetToDoPath(order->path_id) != nullptr)
+		{
+			++order;
+			continue;
+		}
+
+		std::vector<iPoint>* leader_path = App->pathfinding.GetPath(order->path_id);
+		if (leader_path != nullptr)
+		{
+			// Stored paths are smoothed waypoints: shift the raw tiles instead
+			leader_tiles.clear();
+			App->pathfinding.ExpandPath(order->leader_start, *leader_path, leader_tiles);
+
+			for (std::vector<Member>::const_iterator it = order->members.cbegin(); it != order->members.cend(); ++it)
+			{
+				Component* comp = Component::Get(it->unit);
+				if (comp != nullptr && !comp->AsBehaviour()->IsDestroyed())
+				{
+					if (BuildMemberPath(leader_tiles, *it, member_path))
+						App->pathfinding.UpdateStoredPaths(comp->GetID(), member_path);
+					else
+						App->pathfinding.CreatePath(it->start, it->slot, comp->GetID()); // no walkable corridor beside the leader's
+				}
+			}
+
+			App->pathfinding.DeletePath(order->path_id);
+		}
+
+		order = orders.erase(order);
+	}
+}
+
+void GroupMovement::CleanUp()
+{
+	for (std::vector<Order>::const_iterator it = orders.cbegin(); it != orders.cend(); ++it)
+	{
+		App->pathfinding.DeletePendingPath(it->path_id);
+		App->pathfinding.DeletePath(it->path_id);
+	}
+
+	orders.clear();
+}
+
+bool GroupMovement::IssueOrder(const std::vector<Behaviour*>& units, iPoint destination)
+{
+	OPTICK_EVENT();
+
+	std::vector<Behaviour*> movers;
+	starts.clear();
+	iPoint centre = { 0, 0 };
+
+	for (std::vector<Behaviour*>::const_iterator it = units.cbegin(); it != units.cend(); ++it)
+	{
+		if (!(*it)->IsDestroyed())
+		{
+			vec pos = (*it)->GetPos();
+			movers.push_back(*it);
+			starts.push_back({ int(pos.x), int(pos.y) });
+			centre.x += int(pos.x);
+			centre.y += int(pos.y);
+		}
+	}
+
+	if (movers.size() < 2u)
+		return false;
+
+	centre.x /= int(movers.size());
+	centre.y /= int(movers.size());
+
+	GenerateSlots(destination, movers.size(), slots);
+	AssignSlots(starts, centre, slots, destination);
+
+	// Unit closest to the group centre leads
+	unsigned int leader = 0u;
+	int best = -1;
+	for (unsigned int i = 0u; i < starts.size(); ++i)
+	{
+		int dist = starts[i].DistanceManhattan(centre);
+		if (best < 0 || dist < best)
+		{
+			best = dist;
+			leader = i;
+		}
+	}
+
+	iPoint leader_slot = slots[assignment[leader]];
+
+	// Members already following another order leave it
+	for (std::vector<Behaviour*>::const_iterator it = movers.cbegin(); it != movers.cend(); ++it)
+		Cancel((*it)->GetHandle());
+
+	Order order;
+	order.path_id = next_path_id;
+	order.leader_start = starts[leader];
+	next_path_id -= 1.0;
+
+	for (unsigned int i = 0u; i < movers.size(); ++i)
+	{
+		iPoint slot = slots[assignment[i]];
+		if (movers[i]->PrepareGroupMove(slot))
+		{
+			Member member;
+			member.unit = movers[i]->GetHandle();
+			member.start = starts[i];
+			member.slot = slot;
+			member.offset = slot - leader_slot;
+			order.members.push_back(member);
+		}
+	}
+
+	App->pathfinding.CreatePath(starts[leader], leader_slot, order.path_id);
+	orders.push_back(order);
+
+	return true;
+}
+
+void GroupMovement::Cancel(ComponentHandle unit)
+{
+	for (std::vector<Order>::iterator order = orders.begin(); order != orders.end(); ++order)
+	{
+		for (std::vector<Member>::iterator it = order->members.begin(); it != order->members.end(); ++it)
+		{
+			if (it->unit == unit)
+			{
+				order->members.erase(it);
+				return;
+			}
+		}
+	}
+}
+
+unsigned int GroupMovement::GetPendingOrders() const
+{
+	return orders.size();
+}
+
+void GroupMovement::GenerateSlots(iPoint destination, unsigned int count, std::vector<iPoint>& out)
+{
+	const int side = FORMATION_SEARCH_RADIUS * 2 + 1;
+	visited.assign(side * side, 0);
+	frontier.clear();
+	out.clear();
+
+	if (App->pathfinding.ValidTile(destination.x, destination.y))
+	{
+		frontier.push_back(destination);
+		visited[FORMATION_SEARCH_RADIUS + FORMATION_SEARCH_RADIUS * side] = 1;
+	}
+
+	// Breadth first: slots fill rings of walkable tiles around the destination
+	for (unsigned int head = 0u; head < frontier.size() && out.size() < count; ++head)
+	{
+		iPoint tile = frontier[head];
+		out.push_back(tile);
+
+		for (int dy = -1; dy <= 1; ++dy)
+		{
+			for (int dx = -1; dx <= 1; ++dx)
+			{
+				int lx = tile.x + dx - destination.x + FORMATION_SEARCH_RADIUS;
+				int ly = tile.y + dy - destination.y + FORMATION_SEARCH_RADIUS;
+
+				if (lx >= 0 && ly >= 0 && lx < side && ly < side && !visited[lx + ly * side])
+				{
+					visited[lx + ly * side] = 1;
+					if (App->pathfinding.ValidTile(tile.x + dx, tile.y + dy))
+						frontier.push_back({ tile.x + dx, tile.y + dy });
+				}
+			}
+		}
+	}
+
+	if (out.size() < count)
+	{
+		LOG("Group order: only %d free tiles around destination for %d units", out.size(), count);
+		iPoint fallback = out.empty() ? destination : out.back();
+		while (out.size() < count)
+			out.push_back(fallback);
+	}
+}
+
+void GroupMovement::AssignSlots(const std::vector<iPoint>& units, iPoint centre, const std::vector<iPoint>& targets, iPoint destination)
+{
+	// Hungarian method on squared distance between each unit's offset from
+	// the group centre and each slot's offset from the destination: the
+	// formation keeps its shape and paths don't cross
+	const int n = int(units.size());
+	const float inf = 1e30f;
+
+	costs.resize(n * n);
+	for (int i = 0; i < n; ++i)
+	{
+		for (int j = 0; j < n; ++j)
+		{
+			float dx = float((units[i].x - centre.x) - (targets[j].x - destination.x));
+			float dy = float((units[i].y - centre.y) - (targets[j].y - destination.y));
+			costs[i * n + j] = dx * dx + dy * dy;
+		}
+	}
+
+	// 1-based potentials, column owners and augmenting links
+	std::vector<float> u(n + 1, 0.f), v(n + 1, 0.f), min_v(n + 1);
+	std::vector<int> owner(n + 1, 0), way(n + 1, 0);
+	std::vector<char> used(n + 1);
+
+	for (int i = 1; i <= n; ++i)
+	{
+		owner[0] = i;
+		int col = 0;
+		min_v.assign(n + 1, inf);
+		used.assign(n + 1, 0);
+
+		do
+		{
+			used[col] = 1;
+			int row = owner[col], next_col = 0;
+			float delta = inf;
+
+			for (int j = 1; j <= n; ++j)
+			{
+				if (!used[j])
+				{
+					float cur = costs[(row - 1) * n + (j - 1)] - u[row] - v[j];
+					if (cur < min_v[j])
+					{
+						min_v[j] = cur;
+						way[j] = col;
+					}
+					if (min_v[j] < delta)
+					{
+						delta = min_v[j];
+						next_col = j;
+					}
+				}
+			}
+
+			for (int j = 0; j <= n; ++j)
+			{
+				if (used[j])
+				{
+					u[owner[j]] += delta;
+					v[j] -= delta;
+				}
+				else
+					min_v[j] -= delta;
+			}
+
+			col = next_col;
+
+		} while (owner[col] != 0);
+
+		do
+		{
+			int prev = way[col];
+			owner[col] = owner[prev];
+			col = prev;
+
+		} while (col != 0);
+	}
+
+	assignment.resize(n);
+	for (int j = 1; j <= n; ++j)
+		assignment[owner[j] - 1] = j - 1;
+}
+
+bool GroupMovement::BuildMemberPath(const std::vector<iPoint>& leader_path, const Member& member, std::vector<iPoint>& out)
+{
+	out.clear();
+
+	// Join the shifted path at the closest waypoint the member can walk straight to
+	int first = -1;
+	int best = -1;
+	for (unsigned int i = 0u; i < leader_path.size(); ++i)
+	{
+		iPoint shifted = leader_path[i] + member.offset;
+		int dist = shifted.DistanceManhattan(member.start);
+		if ((best < 0 || dist < best) && App->pathfinding.LineOfSight(member.start, shifted))
+		{
+			best = dist;
+			first = int(i);
+		}
+	}
+
+	if (first < 0)
+		return false;
+
+	// Shifted tiles inside walls are dropped, the gap they leave gets bridged
+	iPoint last = member.start;
+	for (unsigned int i = unsigned(first); i < leader_path.size(); ++i)
+	{
+		iPoint shifted = leader_path[i] + member.offset;
+		if (shifted == last || !App->pathfinding.ValidTile(shifted.x, shifted.y))
+			continue;
+
+		if (!JoinTiles(last, shifted, out))
+			return false;
+
+		last = shifted;
+	}
+
+	// Always end on the assigned slot
+	if (last != member.slot && !JoinTiles(last, member.slot, out))
+		return false;
+
+	if (out.empty())
+		out.push_back(member.slot);
+
+	App->pathfinding.SmoothPath(out, member.start);
+	return true;
+}
+
+bool GroupMovement::JoinTiles(iPoint from, iPoint to, std::vector<iPoint>& out)
+{
+	if (App->pathfinding.LineOfSight(from, to))
+	{
+		out.push_back(to);
+		return true;
+	}
+
+	// Breadth first inside the box around both tiles grown by GROUP_BRIDGE_RADIUS
+	iPoint corner = { MIN(from.x, to.x) - GROUP_BRIDGE_RADIUS, MIN(from.y, to.y) - GROUP_BRIDGE_RADIUS };
+	int width = abs(to.x - from.x) + GROUP_BRIDGE_RADIUS * 2 + 1;
+	int height = abs(to.y - from.y) + GROUP_BRIDGE_RADIUS * 2 + 1;
+
+	bridge_parents.assign(width * height, -1);
+	frontier.clear();
+	frontier.push_back(from);
+	bridge_parents[(from.x - corner.x) + (from.y - corner.y) * width] = (from.x - corner.x) + (from.y - corner.y) * width;
+
+	for (unsigned int head = 0u; head < frontier.size(); ++head)
+	{
+		iPoint tile = frontier[head];
+		int index = (tile.x - corner.x) + (tile.y - corner.y) * width;
+
+		if (tile == to)
+		{
+			// Walk the parents back to from, then append in order
+			unsigned int begin = out.size();
+			for (; tile != from; index = bridge_parents[index])
+			{
+				out.push_back(tile);
+				tile = { corner.x + bridge_parents[index] % width, corner.y + bridge_parents[index] / width };
+			}
+
+			std::reverse(out.begin() + begin, out.end());
+			return true;
+		}
+
+		for (int dy = -1; dy <= 1; ++dy)
+		{
+			for (int dx = -1; dx <= 1; ++dx)
+			{
+				iPoint next = { tile.x + dx, tile.y + dy };
+				int lx = next.x - corner.x;
+				int ly = next.y - corner.y;
+
+				// Single steps: the line of sight applies the diagonal corner rule
+				if (lx >= 0 && ly >= 0 && lx < width && ly < height && bridge_parents[lx + ly * width] < 0
+					&& App->pathfinding.LineOfSight(tile, next))
+				{
+					bridge_parents[lx + ly * width] = index;
+					frontier.push_back(next);
+				}
+			}
+		}
+	}
+
+	return false;
+}
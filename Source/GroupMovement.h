@@ -0,0 +1,79 @@
+#ifndef __GROUP_MOVEMENT_H__
+#define __GROUP_MOVEMENT_H__
+
+#include "Point.h"
+#include "Component.h"
+
+#include <vector>
+
+#define FORMATION_SEARCH_RADIUS 16	// tiles flood filled around the destination looking for slots
+#define GROUP_PATH_FIRST_ID -1.0	// group searches use negative ids, units keep their own
+#define GROUP_BRIDGE_RADIUS 4		// tiles around a gap searched to walk around what the shift dropped
+
+class Behaviour;
+
+// One path search per group order: the unit nearest to the group centre
+// leads, formation slots are flood filled over walkable tiles around the
+// destination and matched to units at minimum total cost. Once the leader
+// path is ready every member walks it shifted by its slot offset, short
+// searches bridging where the shift hits walls.
+class GroupMovement
+{
+public:
+
+	GroupMovement();
+	~GroupMovement();
+
+	void Update();
+	void CleanUp();
+
+	// False if fewer than two units can take the order
+	bool IssueOrder(const std::vector<Behaviour*>& units, iPoint destination);
+
+	// Drops a unit from its pending order after it received another one
+	void Cancel(ComponentHandle unit);
+
+	unsigned int GetPendingOrders() const;
+
+private:
+
+	struct Member
+	{
+		ComponentHandle unit;
+		iPoint start;
+		iPoint slot;
+		iPoint offset; // slot relative to the leader slot
+	};
+
+	struct Order
+	{
+		double path_id;
+		iPoint leader_start;
+		std::vector<Member> members;
+	};
+
+	void GenerateSlots(iPoint destination, unsigned int count, std::vector<iPoint>& out);
+	void AssignSlots(const std::vector<iPoint>& units, iPoint centre, const std::vector<iPoint>& targets, iPoint destination);
+	// False if the shifted path can't be walked, the member then searches its own
+	bool BuildMemberPath(const std::vector<iPoint>& leader_path, const Member& member, std::vector<iPoint>& out);
+	// Appends a walkable tile chain from (excluded) to to (included)
+	bool JoinTiles(iPoint from, iPoint to, std::vector<iPoint>& out);
+
+private:
+
+	std::vector<Order> orders;
+	double next_path_id = GROUP_PATH_FIRST_ID;
+
+	// Reused scratch
+	std::vector<iPoint> starts;
+	std::vector<iPoint> slots;
+	std::vector<iPoint> frontier;
+	std::vector<char> visited;
+	std::vector<float> costs;
+	std::vector<int> assignment; // unit -> slot
+	std::vector<iPoint> leader_tiles;
+	std::vector<iPoint> member_path;
+	std::vector<int> bridge_parents;
+};
+
+#endif // __GROUP_MOVEMENT_H__
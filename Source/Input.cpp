@@ -9,6 +9,8 @@
 #include "SDL/include/SDL.h"
 #include "optick-1.3.0.0/include/optick.h"
 
+#include <string.h>
+
 #define MAX_OWN_EVENTS_MS 6
 
 Input::Input() : Module("input")
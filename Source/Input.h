@@ -8,7 +8,7 @@
 
 struct SDL_Rect;
 
-enum KeyState
+enum KeyState : int
 {
 	KEY_IDLE = 0,
 	KEY_DOWN,
@@ -0,0 +1,249 @@
+#include "JobSystem.h"
+#include "Log.h"
+#include "Profiler.h"
+
+#include "optick-1.3.0.0/include/optick.h"
+
+#include <chrono>
+
+// Queue owned by the calling thread: 0 on main thread, 1..N on workers
+static thread_local unsigned int current_queue = 0u;
+
+Job::Job(const char* name, const std::function<void()>& work) :
+	name(name),
+	work(work),
+	pending(1),
+	done(false)
+{}
+
+JobSystem::JobSystem() : running(false), queued_jobs(0)
+{}
+
+JobSystem::~JobSystem()
+{
+	CleanUp();
+}
+
+bool JobSystem::Init(unsigned int worker_count)
+{
+	if (worker_count == 0u)
+	{
+		unsigned int hardware_threads = std::thread::hardware_concurrency();
+		worker_count = hardware_threads > 1u ? hardware_threads - 1u : 0u;
+	}
+
+	if (worker_count > MAX_JOB_WORKERS)
+		worker_count = MAX_JOB_WORKERS;
+
+	running = true;
+
+	queues.push_back(new WorkQueue()); // main thread
+	for (unsigned int i = 1u; i <= worker_count; ++i)
+	{
+		queues.push_back(new WorkQueue());
+		worker_names.push_back("Worker " + std::to_string(i));
+	}
+
+	for (unsigned int i = 1u; i <= worker_count; ++i)
+		workers.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+
+	LOG("Job System initialized with %d worker threads.", worker_count);
+
+	return true;
+}
+
+void JobSystem::CleanUp()
+{
+	if (running)
+	{
+		// Finish pending work before stopping the workers
+		while (RunOne(0u)) {}
+
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+			running = false;
+		}
+		wake.notify_all();
+
+		for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+			if (it->joinable())
+				it->join();
+
+		workers.clear();
+	}
+
+	for (std::vector<WorkQueue*>::iterator it = queues.begin(); it != queues.end(); ++it)
+		delete *it;
+
+	queues.clear();
+	worker_names.clear();
+	queued_jobs = 0;
+}
+
+JobHandle JobSystem::Schedule(const char* name, const std::function<void()>& work, const std::vector<JobHandle>& dependencies)
+{
+	JobHandle job = std::make_shared<Job>(name, work);
+
+	for (std::vector<JobHandle>::const_iterator it = dependencies.cbegin(); it != dependencies.cend(); ++it)
+	{
+		if (*it != nullptr)
+		{
+			std::lock_guard<std::mutex> lock((*it)->dependents_mutex);
+			if (!(*it)->done)
+			{
+				++job->pending;
+				(*it)->dependents.push_back(job);
+			}
+		}
+	}
+
+	// Release the scheduling guard: enqueue now if no dependency is pending
+	if (--job->pending == 0)
+		Enqueue(job);
+
+	return job;
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+	OPTICK_EVENT();
+
+	if (job != nullptr)
+		while (!job->done)
+			if (!RunOne(current_queue))
+				std::this_thread::yield();
+}
+
+void JobSystem::ParallelFor(const char* name, unsigned int count, unsigned int batch_size, const std::function<void(unsigned int, unsigned int)>& func)
+{
+	if (count == 0u)
+		return;
+
+	if (batch_size == 0u)
+		batch_size = 1u;
+
+	if (workers.empty() || count <= batch_size)
+	{
+		func(0u, count);
+		return;
+	}
+
+	std::vector<JobHandle> batches;
+	batches.reserve((count + batch_size - 1u) / batch_size);
+
+	for (unsigned int begin = 0u; begin < count; begin += batch_size)
+	{
+		unsigned int end = begin + batch_size < count ? begin + batch_size : count;
+		batches.push_back(Schedule(name, [&func, begin, end]() { func(begin, end); }));
+	}
+
+	for (std::vector<JobHandle>::iterator it = batches.begin(); it != batches.end(); ++it)
+		Wait(*it);
+}
+
+unsigned int JobSystem::GetWorkerCount() const
+{
+	return (unsigned int)workers.size();
+}
+
+void JobSystem::WorkerLoop(unsigned int queue)
+{
+	OPTICK_THREAD(worker_names[queue - 1u].c_str());
+
+	current_queue = queue;
+
+	while (running)
+	{
+		if (!RunOne(queue))
+		{
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+			wake.wait_for(lock, std::chrono::milliseconds(1), [this]() { return queued_jobs > 0 || !running; });
+		}
+	}
+}
+
+void JobSystem::Enqueue(const JobHandle& job)
+{
+	unsigned int queue = current_queue < queues.size() ? current_queue : 0u;
+
+	{
+		std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+		queues[queue]->jobs.push_back(job);
+	}
+
+	++queued_jobs;
+	wake.notify_one();
+}
+
+bool JobSystem::RunOne(unsigned int queue)
+{
+	JobHandle job = Pop(queue);
+
+	if (job == nullptr)
+		job = Steal(queue);
+
+	if (job != nullptr)
+		Execute(job);
+
+	return job != nullptr;
+}
+
+JobHandle JobSystem::Pop(unsigned int queue)
+{
+	JobHandle ret;
+
+	if (queue < queues.size())
+	{
+		std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+		if (!queues[queue]->jobs.empty())
+		{
+			ret = queues[queue]->jobs.back();
+			queues[queue]->jobs.pop_back();
+			--queued_jobs;
+		}
+	}
+
+	return ret;
+}
+
+JobHandle JobSystem::Steal(unsigned int thief)
+{
+	JobHandle ret;
+
+	for (unsigned int i = 1u; i < queues.size() && ret == nullptr; ++i)
+	{
+		WorkQueue* victim = queues[(thief + i) % queues.size()];
+
+		std::lock_guard<std::mutex> lock(victim->mutex);
+		if (!victim->jobs.empty())
+		{
+			ret = victim->jobs.front();
+			victim->jobs.pop_front();
+			--queued_jobs;
+		}
+	}
+
+	return ret;
+}
+
+void JobSystem::Execute(const JobHandle& job)
+{
+	OPTICK_PUSH_DYNAMIC(job->name);
+	{
+		ProfileScope zone(job->name);
+		job->work();
+	}
+	OPTICK_POP();
+
+	std::vector<JobHandle> ready;
+
+	{
+		std::lock_guard<std::mutex> lock(job->dependents_mutex);
+		job->done = true;
+		ready.swap(job->dependents);
+	}
+
+	for (std::vector<JobHandle>::iterator it = ready.begin(); it != ready.end(); ++it)
+		if (--(*it)->pending == 0)
+			Enqueue(*it);
+}
@@ -0,0 +1,83 @@
+#ifndef __JOB_SYSTEM_H__
+#define __JOB_SYSTEM_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define MAX_JOB_WORKERS 15u
+
+struct Job;
+typedef std::shared_ptr<Job> JobHandle;
+
+struct Job
+{
+	Job(const char* name, const std::function<void()>& work);
+
+	const char* name;
+	std::function<void()> work;
+
+	std::atomic<int> pending;		// unfinished dependencies (+1 while being scheduled)
+	std::atomic<bool> done;
+
+	std::mutex dependents_mutex;
+	std::vector<JobHandle> dependents;
+};
+
+// Fixed pool of worker threads with one deque each. Owners push/pop
+// from the back, idle workers steal from the front of the others.
+// Queue 0 belongs to the main thread, which helps while it waits.
+// Jobs must not touch SDL, the Render layers, LOG or the Event queue.
+class JobSystem
+{
+public:
+
+	JobSystem();
+	~JobSystem();
+
+	bool Init(unsigned int worker_count = 0u); // 0 = hardware threads - 1
+	void CleanUp();
+
+	JobHandle Schedule(const char* name, const std::function<void()>& work, const std::vector<JobHandle>& dependencies = std::vector<JobHandle>());
+	void Wait(const JobHandle& job);
+
+	// Splits [0, count) in batches of batch_size and blocks until all of them ran
+	void ParallelFor(const char* name, unsigned int count, unsigned int batch_size, const std::function<void(unsigned int, unsigned int)>& func);
+
+	unsigned int GetWorkerCount() const;
+
+private:
+
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+	};
+
+	void WorkerLoop(unsigned int queue);
+	void Enqueue(const JobHandle& job);
+	bool RunOne(unsigned int queue);
+	JobHandle Pop(unsigned int queue);
+	JobHandle Steal(unsigned int thief);
+	void Execute(const JobHandle& job);
+
+private:
+
+	std::vector<std::thread> workers;
+	std::vector<WorkQueue*> queues;
+	std::vector<std::string> worker_names;
+
+	std::atomic<bool> running;
+	std::atomic<int> queued_jobs;
+
+	std::mutex sleep_mutex;
+	std::condition_variable wake;
+};
+
+#endif // __JOB_SYSTEM_H__
@@ -64,7 +64,7 @@ Lab::~Lab()
 				App->pathfinding.SetWalkabilityTile(int(pos.x) + i + 2, int(pos.y) + a - 1, false);
 	}
 
-	b_map.erase(GetID());
+	RemoveFromList();
 }
 
 
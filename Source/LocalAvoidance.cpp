@@ -0,0 +1,220 @@
+#include "LocalAvoidance.h"
+#include "Application.h"
+#include "PathfindingManager.h"
+#include "Behaviour.h"
+#include "Gameobject.h"
+#include "Transform.h"
+#include "Map.h"
+
+#include "optick-1.3.0.0/include/optick.h"
+
+#include <math.h>
+
+#define AVOIDANCE_LOOKAHEAD 0.25f // seconds: candidates ending on blocked tiles are skipped
+#define AVOIDANCE_NO_COLLISION 1e10f
+
+LocalAvoidance::LocalAvoidance()
+{}
+
+LocalAvoidance::~LocalAvoidance()
+{}
+
+void LocalAvoidance::Update()
+{
+	OPTICK_EVENT();
+
+	std::pair<int, int> size = Map::GetMapSize_I();
+	columns = (size.first + AVOIDANCE_CELL_TILES - 1) / AVOIDANCE_CELL_TILES;
+	rows = (size.second + AVOIDANCE_CELL_TILES - 1) / AVOIDANCE_CELL_TILES;
+
+	agents.clear();
+	cell_start.assign(columns * rows + 1, 0);
+
+	if (columns <= 0 || rows <= 0)
+		return;
+
+	// Snapshot moving unit types
+	for (std::vector<Behaviour*>::iterator it = Behaviour::b_list.begin(); it != Behaviour::b_list.end(); ++it)
+	{
+		Behaviour* b = *it;
+		b->avoidance_agent = -1;
+
+		UnitType type = b->GetType();
+		if (type < GATHERER || type > ENEMY_SUPER || b->IsDestroyed())
+			continue;
+
+		vec pos = b->GetGameobject()->GetTransform()->GetGlobalPosition();
+
+		Agent agent;
+		agent.pos = { pos.x, pos.y };
+		agent.vel = b->velocity;
+		agent.owner = b;
+		b->velocity = fPoint(0.f, 0.f); // stays zero unless steered this tick
+		agent.cell = CellIndex(pos.x, pos.y);
+
+		b->avoidance_agent = int(agents.size());
+		agents.push_back(agent);
+		cell_start[agent.cell + 1]++;
+	}
+
+	// Counting sort by cell
+	for (unsigned int i = 1u; i < cell_start.size(); ++i)
+		cell_start[i] += cell_start[i - 1];
+
+	cell_agents.resize(agents.size());
+	std::vector<int> fill(cell_start.begin(), cell_start.end() - 1);
+	for (unsigned int i = 0u; i < agents.size(); ++i)
+		cell_agents[fill[agents[i].cell]++] = int(i);
+}
+
+void LocalAvoidance::Clear()
+{
+	agents.clear();
+	cell_start.clear();
+	cell_agents.clear();
+	columns = rows = 0;
+}
+
+fPoint LocalAvoidance::Solve(const Behaviour* self, fPoint preferred) const
+{
+	int index = self->avoidance_agent;
+	if (index < 0 || index >= int(agents.size()) || agents[index].owner != self)
+		return preferred;
+
+	const Agent& agent = agents[index];
+
+	// Gather nearby moving agents, idle ones are shoved aside by collision resolution
+	int neighbours[AVOIDANCE_MAX_NEIGHBOURS];
+	int count = 0;
+
+	int first_col = int(agent.pos.x - AVOIDANCE_NEIGHBOUR_DIST) / AVOIDANCE_CELL_TILES;
+	int last_col = int(agent.pos.x + AVOIDANCE_NEIGHBOUR_DIST) / AVOIDANCE_CELL_TILES;
+	int first_row = int(agent.pos.y - AVOIDANCE_NEIGHBOUR_DIST) / AVOIDANCE_CELL_TILES;
+	int last_row = int(agent.pos.y + AVOIDANCE_NEIGHBOUR_DIST) / AVOIDANCE_CELL_TILES;
+	if (first_col < 0) first_col = 0;
+	if (first_row < 0) first_row = 0;
+	if (last_col >= columns) last_col = columns - 1;
+	if (last_row >= rows) last_row = rows - 1;
+
+	float sqr_dist = AVOIDANCE_NEIGHBOUR_DIST * AVOIDANCE_NEIGHBOUR_DIST;
+	for (int row = first_row; row <= last_row && count < AVOIDANCE_MAX_NEIGHBOURS; ++row)
+	{
+		for (int col = first_col; col <= last_col && count < AVOIDANCE_MAX_NEIGHBOURS; ++col)
+		{
+			int cell = col + row * columns;
+			for (int i = cell_start[cell]; i < cell_start[cell + 1] && count < AVOIDANCE_MAX_NEIGHBOURS; ++i)
+			{
+				int other = cell_agents[i];
+				float dx = agents[other].pos.x - agent.pos.x;
+				float dy = agents[other].pos.y - agent.pos.y;
+				if (other != index && dx * dx + dy * dy < sqr_dist && (agents[other].vel.x != 0.f || agents[other].vel.y != 0.f))
+					neighbours[count++] = other;
+			}
+		}
+	}
+
+	if (count == 0)
+		return preferred;
+
+	// Nothing in the way of the preferred velocity: common case
+	if (Penalty(agent, preferred, preferred, neighbours, count, AVOIDANCE_NO_COLLISION) == 0.f)
+		return preferred;
+
+	// Otherwise sample two speed rings around the preferred heading, standing still as fallback
+	float max_speed = sqrtf(preferred.x * preferred.x + preferred.y * preferred.y);
+	float heading = atan2f(preferred.y, preferred.x);
+	const float two_pi = 6.2831853f;
+
+	fPoint best = { 0.f, 0.f };
+	float best_penalty = Penalty(agent, best, preferred, neighbours, count, AVOIDANCE_NO_COLLISION);
+
+	for (int ring = 1; ring <= 2; ++ring)
+	{
+		float speed = max_speed / float(ring);
+
+		for (int d = 0; d < AVOIDANCE_DIRECTIONS; ++d)
+		{
+			float angle = heading + two_pi * float(d) / float(AVOIDANCE_DIRECTIONS);
+			fPoint candidate = { cosf(angle) * speed, sinf(angle) * speed };
+
+			if (!App->pathfinding.ValidTile(int(agent.pos.x + candidate.x * AVOIDANCE_LOOKAHEAD), int(agent.pos.y + candidate.y * AVOIDANCE_LOOKAHEAD)))
+				continue;
+
+			float penalty = Penalty(agent, candidate, preferred, neighbours, count, best_penalty);
+			if (penalty < best_penalty)
+			{
+				best_penalty = penalty;
+				best = candidate;
+			}
+		}
+	}
+
+	return best;
+}
+
+unsigned int LocalAvoidance::GetAgentCount() const
+{
+	return agents.size();
+}
+
+int LocalAvoidance::CellIndex(float x, float y) const
+{
+	int col = int(x) / AVOIDANCE_CELL_TILES;
+	int row = int(y) / AVOIDANCE_CELL_TILES;
+
+	if (col < 0) col = 0;
+	else if (col >= columns) col = columns - 1;
+
+	if (row < 0) row = 0;
+	else if (row >= rows) row = rows - 1;
+
+	return col + row * columns;
+}
+
+float LocalAvoidance::Penalty(const Agent& self, fPoint candidate, fPoint preferred, const int* neighbours, int count, float cutoff) const
+{
+	// Deviation from the preferred velocity plus imminence of the first collision
+	float dx = candidate.x - preferred.x;
+	float dy = candidate.y - preferred.y;
+	float deviation = sqrtf(dx * dx + dy * dy);
+	float ret = deviation;
+
+	for (int n = 0; n < count && ret < cutoff; ++n)
+	{
+		float t = TimeToCollision(self, candidate, agents[neighbours[n]]);
+		if (t < AVOIDANCE_HORIZON)
+		{
+			float collision = deviation + AVOIDANCE_WEIGHT / (t > 0.01f ? t : 0.01f);
+			if (collision > ret) ret = collision;
+		}
+	}
+
+	return ret;
+}
+
+float LocalAvoidance::TimeToCollision(const Agent& self, fPoint candidate, const Agent& other) const
+{
+	// Reciprocal: each side takes half of the avoidance
+	fPoint rel_vel;
+	rel_vel.x = 2.f * candidate.x - self.vel.x - other.vel.x;
+	rel_vel.y = 2.f * candidate.y - self.vel.y - other.vel.y;
+
+	float px = other.pos.x - self.pos.x;
+	float py = other.pos.y - self.pos.y;
+	float radius = 2.f * AVOIDANCE_UNIT_RADIUS;
+
+	float b = px * rel_vel.x + py * rel_vel.y;
+	float c = px * px + py * py - radius * radius;
+
+	// Already overlapping: only velocities moving apart are free
+	if (c < 0.f)
+		return b > 0.f ? 0.f : AVOIDANCE_NO_COLLISION;
+
+	float a = rel_vel.x * rel_vel.x + rel_vel.y * rel_vel.y;
+	float disc = b * b - a * c;
+
+	if (a <= 0.f || b <= 0.f || disc < 0.f)
+		return AVOIDANCE_NO_COLLISION;
+
+	return (b - sqrtf(disc)) / a;
+}
@@ -0,0 +1,61 @@
+#ifndef __LOCAL_AVOIDANCE_H__
+#define __LOCAL_AVOIDANCE_H__
+
+#include "Point.h"
+
+#include <vector>
+
+#define AVOIDANCE_CELL_TILES 2			// bucket side in map tiles
+#define AVOIDANCE_NEIGHBOUR_DIST 2.5f	// tiles around an agent checked for neighbours
+#define AVOIDANCE_MAX_NEIGHBOURS 12
+#define AVOIDANCE_UNIT_RADIUS 0.35f		// tiles
+#define AVOIDANCE_HORIZON 1.5f			// seconds ahead collisions are considered
+#define AVOIDANCE_DIRECTIONS 12			// sampled headings per speed ring
+#define AVOIDANCE_WEIGHT 0.6f			// tiles/s of deviation worth one second of time to collision
+
+class Behaviour;
+
+// Velocity level avoidance between moving units (sampled reciprocal
+// velocity obstacles). Update snapshots every unit into a flat tile bucket
+// grid once per tick; Solve then picks, from a ring of candidates, the
+// velocity closest to the preferred one that stays clear of neighbours.
+// Every agent reads the same snapshot, so solving order doesn't matter.
+class LocalAvoidance
+{
+public:
+
+	LocalAvoidance();
+	~LocalAvoidance();
+
+	void Update();
+	void Clear();
+
+	// Map tiles per second
+	fPoint Solve(const Behaviour* self, fPoint preferred) const;
+
+	unsigned int GetAgentCount() const;
+
+private:
+
+	struct Agent
+	{
+		fPoint pos;
+		fPoint vel;
+		const Behaviour* owner;
+		int cell;
+	};
+
+	int CellIndex(float x, float y) const;
+	float Penalty(const Agent& self, fPoint candidate, fPoint preferred, const int* neighbours, int count, float cutoff) const;
+	float TimeToCollision(const Agent& self, fPoint candidate, const Agent& other) const;
+
+private:
+
+	std::vector<Agent> agents;
+	std::vector<int> cell_start;	// agents of cell c: cell_agents[cell_start[c] .. cell_start[c + 1])
+	std::vector<int> cell_agents;
+	int columns = 0;
+	int rows = 0;
+};
+
+#endif // __LOCAL_AVOIDANCE_H__
@@ -1,15 +1,348 @@
 #include "Log.h"
 
-void log(const char file[], int line, const char* format, ...)
+#include "SDL/include/SDL_timer.h"
+
+#include <stdarg.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace
 {
-	static char tmp_string[4096];
-	static char tmp_string2[4096];
-	static va_list  ap;
+	struct LogRecord
+	{
+		std::atomic<unsigned int> sequence;
+		int level;
+		const char* file;
+		int line;
+		unsigned int time;
+		char text[LOG_RECORD_SIZE];
+	};
+
+	LogRecord ring[LOG_RING_SIZE];
+	std::atomic<unsigned int> enqueue_pos(0u);
+	unsigned int dequeue_pos = 0u; // writer thread only
+	std::atomic<unsigned int> dropped(0u);
+
+	std::atomic<bool> running(false);
+	std::atomic<unsigned int> producers(0u); // inside Write, CleanUp waits for them
+	std::thread writer;
+	std::mutex sync_mutex; // synchronous writes before Init and after CleanUp
+
+	// The writer sleeps while the ring is empty, producers wake it
+	std::mutex wake_mutex;
+	std::condition_variable wake;
+	std::atomic<bool> sleeping(false);
+
+	// Call sites that suppressed messages at some point
+	struct ListedSite
+	{
+		LogSite* site;
+		int level;
+		const char* file;
+		int line;
+	};
+
+	std::mutex sites_mutex;
+	std::vector<ListedSite> listed_sites;
+
+	FILE* log_file = nullptr;
+	std::string log_path;
+	long file_size = 0l;
+
+	std::mutex console_mutex;
+	std::deque<std::string> console;
+	unsigned int console_total = 0u;
+
+	const char* level_names[4] = { "debug", "info", "warning", "error" };
+
+	void RotateFile()
+	{
+		fclose(log_file);
+
+		// log.txt.1 -> log.txt.2, log.txt -> log.txt.1
+		for (int i = LOG_FILE_COUNT - 1; i > 0; --i)
+		{
+			std::string to = log_path + "." + std::to_string(i);
+			std::string from = (i > 1 ? log_path + "." + std::to_string(i - 1) : log_path);
+			remove(to.c_str());
+			rename(from.c_str(), to.c_str());
+		}
+
+		log_file = fopen(log_path.c_str(), "wb");
+		file_size = 0l;
+	}
+
+	void Output(const LogRecord& record)
+	{
+		char line[LOG_RECORD_SIZE + 256];
+		snprintf(line, sizeof(line), "\n%s(%d) : %s", record.file, record.line, record.text);
+
+#ifdef _WIN32
+		OutputDebugString(line);
+#else
+		// No debugger output channel: headless builds log to stderr
+		fputs(line, stderr);
+#endif
+
+		if (log_file != nullptr)
+		{
+			int written = fprintf(log_file, "[%10.3f] %-7s %s(%d) : %s\n", double(record.time) / 1000.0,
+				level_names[record.level], record.file, record.line, record.text);
+
+			if (written > 0 && (file_size += written) >= LOG_FILE_MAX_SIZE)
+				RotateFile();
+		}
+	}
+
+	void Fill(LogRecord& record, int level, const char* file, int line, unsigned int time, unsigned int suppressed, const char* format, va_list ap)
+	{
+		record.level = level;
+		record.file = file;
+		record.line = line;
+		record.time = time;
+
+		int length = vsnprintf(record.text, LOG_RECORD_SIZE, format, ap);
+		if (suppressed > 0u && length >= 0 && unsigned(length) < LOG_RECORD_SIZE)
+			snprintf(record.text + length, LOG_RECORD_SIZE - length, " (%u similar messages suppressed)", suppressed);
+	}
+
+	void ToConsole(const LogRecord& record)
+	{
+		std::lock_guard<std::mutex> lock(console_mutex);
+		console.push_back(record.text);
+		if (console.size() > LOG_CONSOLE_LINES)
+			console.pop_front();
+
+		console_total++;
+	}
+
+	bool Ready()
+	{
+		return int(ring[dequeue_pos % LOG_RING_SIZE].sequence.load(std::memory_order_acquire) - (dequeue_pos + 1u)) >= 0;
+	}
+
+	bool Pop(LogRecord*& record)
+	{
+		if (!Ready())
+			return false;
+
+		record = &ring[dequeue_pos % LOG_RING_SIZE];
+		return true;
+	}
+
+	void Release(LogRecord& record)
+	{
+		record.sequence.store(dequeue_pos + LOG_RING_SIZE, std::memory_order_release);
+		dequeue_pos++;
+	}
+
+	void Drain()
+	{
+		LogRecord* record;
+		while (Pop(record))
+		{
+			Output(*record);
+			ToConsole(*record);
+			Release(*record);
+		}
+
+		unsigned int lost = dropped.exchange(0u, std::memory_order_relaxed);
+		if (lost > 0u)
+		{
+			LogRecord note;
+			note.level = LOG_LEVEL_WARNING;
+			note.file = __FILE__;
+			note.line = __LINE__;
+			note.time = SDL_GetTicks();
+			snprintf(note.text, LOG_RECORD_SIZE, "Log ring full: %u messages dropped", lost);
+			Output(note);
+			ToConsole(note);
+		}
+	}
+
+	// Messages a call site still held back when the log closes
+	void FlushSuppressed()
+	{
+		std::lock_guard<std::mutex> lock(sites_mutex);
+		for (std::vector<ListedSite>::const_iterator it = listed_sites.cbegin(); it != listed_sites.cend(); ++it)
+		{
+			unsigned int suppressed = it->site->suppressed.exchange(0u, std::memory_order_relaxed);
+			if (suppressed > 0u)
+			{
+				LogRecord note;
+				note.level = it->level;
+				note.file = it->file;
+				note.line = it->line;
+				note.time = SDL_GetTicks();
+				snprintf(note.text, LOG_RECORD_SIZE, "%u similar messages suppressed", suppressed);
+				Output(note);
+				ToConsole(note);
+			}
+		}
+	}
+
+	void WriterLoop()
+	{
+		while (true)
+		{
+			Drain();
+
+			if (log_file != nullptr)
+				fflush(log_file);
 
-	// Construct the string from variable arguments
+			// Producers read sleeping after publishing: one of both sees the other
+			std::unique_lock<std::mutex> lock(wake_mutex);
+			sleeping.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			wake.wait(lock, []() { return !running.load(std::memory_order_acquire) || Ready(); });
+			sleeping.store(false, std::memory_order_relaxed);
+
+			if (!running.load(std::memory_order_acquire))
+				break;
+		}
+	}
+
+	void Wake()
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		wake.notify_one();
+	}
+}
+
+void Logger::Init(const char* file)
+{
+	if (running.load())
+		return;
+
+	for (unsigned int i = 0u; i < LOG_RING_SIZE; ++i)
+		ring[i].sequence.store(i, std::memory_order_relaxed);
+
+	enqueue_pos.store(0u);
+	dequeue_pos = 0u;
+
+	log_path = file;
+	if ((log_file = fopen(log_path.c_str(), "wb")) == nullptr)
+		LOG_WARNING("Unable to open log file %s", file);
+
+	file_size = 0l;
+
+	running.store(true, std::memory_order_release);
+	writer = std::thread(WriterLoop);
+}
+
+void Logger::CleanUp()
+{
+	if (running.exchange(false))
+	{
+		Wake();
+		writer.join();
+	}
+
+	// Callers that saw the logger running may still be filling a record
+	while (producers.load(std::memory_order_acquire) > 0u)
+		std::this_thread::yield();
+
+	// Whatever got in after the writer's last pass
+	std::lock_guard<std::mutex> lock(sync_mutex);
+	Drain();
+	FlushSuppressed();
+
+	if (log_file != nullptr)
+	{
+		fclose(log_file);
+		log_file = nullptr;
+	}
+}
+
+void Logger::Write(LogSite& site, int level, const char* file, int line, const char* format, ...)
+{
+	unsigned int now = SDL_GetTicks();
+
+	// Rate limit warnings and errors per call site, the ones that end up in loops
+	if (level >= LOG_LEVEL_WARNING)
+	{
+		unsigned int window = site.window.load(std::memory_order_relaxed);
+		if (now - window >= LOG_RATE_WINDOW && site.window.compare_exchange_strong(window, now, std::memory_order_relaxed))
+			site.count.store(0u, std::memory_order_relaxed);
+
+		if (site.count.fetch_add(1u, std::memory_order_relaxed) >= LOG_RATE_LIMIT)
+		{
+			if (site.suppressed.fetch_add(1u, std::memory_order_relaxed) == 0u && !site.listed.exchange(true))
+			{
+				ListedSite listed = { &site, level, file, line };
+				std::lock_guard<std::mutex> lock(sites_mutex);
+				listed_sites.push_back(listed);
+			}
+
+			return;
+		}
+	}
+
+	unsigned int suppressed = site.suppressed.exchange(0u, std::memory_order_relaxed);
+
+	va_list ap;
 	va_start(ap, format);
-	vsprintf_s(tmp_string, 4096, format, ap);
+
+	// Counted before reading running: CleanUp either sees this call or it sees the logger stopped
+	producers.fetch_add(1u);
+
+	if (running.load())
+	{
+		// Claim a record
+		LogRecord* record = nullptr;
+		unsigned int pos = enqueue_pos.load(std::memory_order_relaxed);
+		while (record == nullptr)
+		{
+			LogRecord& slot = ring[pos % LOG_RING_SIZE];
+			int diff = int(slot.sequence.load(std::memory_order_acquire) - pos);
+
+			if (diff == 0)
+			{
+				if (enqueue_pos.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed))
+					record = &slot;
+			}
+			else if (diff < 0)
+			{
+				// Full: the writer is behind, never block the caller
+				dropped.fetch_add(1u, std::memory_order_relaxed);
+				producers.fetch_sub(1u, std::memory_order_release);
+				va_end(ap);
+				return;
+			}
+			else
+				pos = enqueue_pos.load(std::memory_order_relaxed);
+		}
+
+		Fill(*record, level, file, line, now, suppressed, format, ap);
+		record->sequence.store(pos + 1u, std::memory_order_release);
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleeping.load(std::memory_order_relaxed))
+			Wake();
+	}
+	else
+	{
+		LogRecord record;
+		Fill(record, level, file, line, now, suppressed, format, ap);
+
+		std::lock_guard<std::mutex> lock(sync_mutex);
+		Output(record);
+	}
+
+	producers.fetch_sub(1u, std::memory_order_release);
 	va_end(ap);
-	sprintf_s(tmp_string2, 4096, "\n%s(%d) : %s", file, line, tmp_string);
-	OutputDebugString(tmp_string2);
-}
\ No newline at end of file
+}
+
+unsigned int Logger::GetConsoleLines(std::vector<std::string>& lines)
+{
+	std::lock_guard<std::mutex> lock(console_mutex);
+	lines.assign(console.begin(), console.end());
+	return console_total;
+}
@@ -1,11 +1,84 @@
 #ifndef __Log_H__
 #define __Log_H__
 
-#include <windows.h>
 #include <stdio.h>
+#include <atomic>
+#include <string>
+#include <vector>
 
-#define LOG(format, ...) log(__FILE__, __LINE__, format, __VA_ARGS__)
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR 3
 
-void log(const char file[], int line, const char* format, ...);
+// Levels below this one compile to nothing
+#ifndef LOG_MIN_LEVEL
+#ifdef DEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
 
-#endif // __Log_H__
\ No newline at end of file
+#define LOG_RECORD_SIZE 512u	// bytes of text per record, longer messages are cut
+#define LOG_RING_SIZE 1024u		// records, power of two
+#define LOG_RATE_LIMIT 10u		// warnings and errors per call site and window
+#define LOG_RATE_WINDOW 1000u	// ms
+#define LOG_FILE_NAME "log.txt"
+#define LOG_FILE_MAX_SIZE 1048576l // bytes before rotating
+#define LOG_FILE_COUNT 3		// log.txt, log.txt.1 and log.txt.2
+#define LOG_CONSOLE_LINES 64u
+
+// One per LOG call site, counts its messages in the current window
+struct LogSite
+{
+	std::atomic<unsigned int> window;
+	std::atomic<unsigned int> count;
+	std::atomic<unsigned int> suppressed;
+	std::atomic<bool> listed; // CleanUp reports what it still holds back
+};
+
+#define LOG_AT(level, format, ...) do { static LogSite log_site; Logger::Write(log_site, level, __FILE__, __LINE__, format, ##__VA_ARGS__); } while (0)
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...) LOG_AT(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) do {} while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG(format, ...) LOG_AT(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#define LOG(format, ...) do {} while (0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(format, ...) LOG_AT(LOG_LEVEL_WARNING, format, ##__VA_ARGS__)
+#else
+#define LOG_WARNING(format, ...) do {} while (0)
+#endif
+
+#define LOG_ERROR(format, ...) LOG_AT(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+
+// Asynchronous logging backend. LOG formats on the calling thread into a
+// fixed record of a bounded multi-producer ring, claimed with a single
+// compare and swap, and returns. A writer thread drains the ring into the
+// debugger output, a rotating log file and the editor console history.
+// Warnings and errors are rate limited: each call site lets LOG_RATE_LIMIT
+// through per window and reports how many it swallowed with the next one,
+// or at CleanUp. Before Init and after CleanUp records are written
+// synchronously instead.
+class Logger
+{
+public:
+
+	static void Init(const char* file = LOG_FILE_NAME);
+	static void CleanUp(); // waits for writing callers, drains the ring and closes the file
+
+	static void Write(LogSite& site, int level, const char* file, int line, const char* format, ...);
+
+	// Editor console, oldest first. Returns how many lines were ever logged
+	static unsigned int GetConsoleLines(std::vector<std::string>& lines);
+};
+
+#endif // __Log_H__
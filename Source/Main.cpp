@@ -1,9 +1,6 @@
 #include "Application.h"
 #include "Log.h"
-
-#ifdef DEBUG
-#include "mmgr\mmgr.h"
-#endif
+#include "MemoryTracker.h"
 
 #include "SDL/include/SDL.h"
 
@@ -33,6 +30,9 @@ int main(int argc, char* args[])
 
 	LOG("Engine starting.");
 
+	MemoryTracker::HookSDL();
+	Logger::Init();
+
 	App = new Application(argc, args);
 
 	LOG("Initializing Application Systems");
@@ -52,9 +52,17 @@ int main(int argc, char* args[])
 
 			if (App->CleanUp())
 			{
+				// A benchmark whose scenario check failed still exits with an error
+				bool passed = App->commands.Passed();
 				delete App;
-				main_return = EXIT_SUCCESS;
-				LOG("EXIT SUCCESS");
+
+				if (passed)
+				{
+					main_return = EXIT_SUCCESS;
+					LOG("EXIT SUCCESS");
+				}
+				else
+					LOG("Benchmark check failed");
 			}
 			else
 				LOG("Application CleanUp exits with ERROR");
@@ -65,5 +73,9 @@ int main(int argc, char* args[])
 	else
 		LOG("Application Init exits with ERROR");
 
+	// Whatever is still live here leaked or belongs to a static
+	MemoryTracker::Report("Memory still allocated at exit");
+	Logger::CleanUp();
+
 	return main_return;
 }
\ No newline at end of file
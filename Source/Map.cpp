@@ -6,6 +6,7 @@
 #include "PathfindingManager.h"
 #include "Minimap.h"
 #include "JuicyMath.h"
+#include "ByteStream.h"
 #include "Defs.h"
 #include "Log.h"
 
@@ -49,6 +50,16 @@ bool Map::Load(const char* file)
 		CleanUp();
 
 	path = file;
+	std::string cooked_path = path + COOKED_MAP_EXTENSION;
+	long long source_time = App->files.GetLastModTime(file);
+
+	if (LoadCooked(cooked_path.c_str(), source_time))
+	{
+		App->pathfinding.SetWalkabilityLayer(GetMapWalkabilityLayer(), &walkable_bits);
+		SetMapScale(scale);
+		loaded = true;
+		return loaded;
+	}
 
 	pugi::xml_document doc;
 	if (App->files.LoadXML(file, doc))
@@ -65,10 +76,13 @@ bool Map::Load(const char* file)
 			{
 				if (ParseLayers(map_node))
 				{
-					App->pathfinding.SetWalkabilityLayer(GetMapWalkabilityLayer());
+					BuildWalkabilityBits();
+					App->pathfinding.SetWalkabilityLayer(GetMapWalkabilityLayer(), &walkable_bits);
 					ParseObjectGroups(map_node);
 					SetMapScale(scale);
 					loaded = true;
+
+					SaveCooked(cooked_path.c_str(), source_time);
 				}
 				else
 					LOG("Error parsing map xml file: Could not load layers.");
@@ -91,6 +105,7 @@ void Map::CleanUp()
 	tilesets.clear();
 	layers.clear();
 	obj_groups.clear();
+	walkable_bits.clear();
 	loaded = false;
 }
 
@@ -440,28 +455,15 @@ bool Map::ParseTilesets(pugi::xml_node& node)
 		pugi::xml_node image_node = tileset_node.child("image");
 		if (image_node)
 		{
-			std::string tex_path = "maps/";
-			tex_path += image_node.attribute("source").as_string();
-			tileset.texture_id = App->tex.Load(tex_path.c_str());
+			tileset.image = image_node.attribute("source").as_string();
 
-			TextureData tex_data;
-			if (App->tex.GetTextureData(tileset.texture_id, tex_data))
+			if (LoadTilesetTexture(tileset))
 			{
-				// not needed as we query texture size on loading
-				//tileset.tex_width = image_node.attribute("width").as_int();
-				//tileset.tex_height = image_node.attribute("height").as_int();
-
-				tileset.num_tiles_width = tex_data.width / tileset.tile_width;
-				tileset.num_tiles_height = tex_data.height / tileset.tile_height;
-
 				LOG("Loading tileset - %s - correctly!!", tileset.name.c_str());
 				tilesets.push_back(tileset);
 			}
 			else
-			{
-				LOG("Error loading tileset texture: %s", tex_path.c_str());
 				ret = false;
-			}
 		}
 		else
 		{
@@ -530,4 +532,190 @@ void Map::ParseObjectGroups(pugi::xml_node& node)
 
 		obj_groups.push_back(obj_group);
 	}
-}
\ No newline at end of file
+}
+
+bool Map::LoadTilesetTexture(TileSet& tileset) const
+{
+	bool ret = false;
+
+	std::string tex_path = "maps/";
+	tex_path += tileset.image;
+	tileset.texture_id = App->tex.Load(tex_path.c_str());
+
+	TextureData tex_data;
+	if (App->tex.GetTextureData(tileset.texture_id, tex_data))
+	{
+		// not needed as we query texture size on loading
+		//tileset.tex_width = image_node.attribute("width").as_int();
+		//tileset.tex_height = image_node.attribute("height").as_int();
+
+		tileset.num_tiles_width = tex_data.width / tileset.tile_width;
+		tileset.num_tiles_height = tex_data.height / tileset.tile_height;
+		ret = true;
+	}
+	else
+		LOG("Error loading tileset texture: %s", tex_path.c_str());
+
+	return ret;
+}
+
+bool Map::LoadCooked(const char* file, long long source_time)
+{
+	OPTICK_EVENT();
+
+	char* buffer = nullptr;
+	unsigned int size = App->files.Load(file, &buffer);
+	if (size == 0u)
+		return false;
+
+	bool ret = false;
+	ByteReader in(buffer, size);
+
+	unsigned int magic = 0u, version = 0u, tileset_count = 0u, layer_count = 0u, group_count = 0u;
+	long long cooked_time = -1;
+	int orientation = MAPTYPE_UNKNOWN;
+
+	in.Read(magic);
+	in.Read(version);
+	in.Read(cooked_time);
+
+	if (!in.Good() || magic != COOKED_MAP_MAGIC || version != COOKED_MAP_VERSION)
+		LOG("Ignoring cooked map %s: unknown format", file);
+	else if (source_time >= 0 && cooked_time != source_time)
+		LOG("Ignoring cooked map %s: source map changed", file);
+	else
+	{
+		in.Read(orientation);
+		in.Read(width);
+		in.Read(height);
+		in.Read(tile_width);
+		in.Read(tile_height);
+		type = MapOrientation(orientation);
+
+		// Tilesets
+		in.Read(tileset_count);
+		for (unsigned int i = 0u; i < tileset_count && in.Good(); ++i)
+		{
+			TileSet tileset;
+			if (tileset.Deserialize(in) && LoadTilesetTexture(tileset))
+				tilesets.push_back(tileset);
+		}
+
+		// Layers
+		in.Read(layer_count);
+		for (unsigned int i = 0u; i < layer_count && in.Good(); ++i)
+		{
+			static MapLayer layer;
+			if (layer.Deserialize(in))
+				layers.push_back(layer);
+		}
+
+		// Walkability
+		in.ReadArray(walkable_bits);
+
+		// Object groups
+		in.Read(group_count);
+		for (unsigned int i = 0u; i < group_count && in.Good(); ++i)
+		{
+			MapObjectGroup group;
+			unsigned int object_count = 0u;
+			in.ReadString(group.name);
+			in.Read(object_count);
+
+			for (unsigned int j = 0u; j < object_count && in.Has(sizeof(unsigned int) + 4 * sizeof(float)); ++j)
+			{
+				MapObject obj;
+				in.Read(obj.id);
+				in.Read(obj.x);
+				in.Read(obj.y);
+				in.Read(obj.width);
+				in.Read(obj.height);
+				group.objects.push_back(obj);
+			}
+
+			obj_groups.push_back(group);
+		}
+
+		ret = in.Good() && tilesets.size() == tileset_count && !layers.empty() && layers.size() == layer_count;
+
+		if (ret)
+			LOG("Loaded cooked map: %s (width: %d, height: %d, layers: %d)", file, width, height, layer_count);
+		else
+		{
+			LOG("Error loading cooked map %s: truncated or invalid data", file);
+			CleanUp();
+		}
+	}
+
+	DEL_ARRAY(buffer);
+	return ret;
+}
+
+bool Map::SaveCooked(const char* file, long long source_time) const
+{
+	OPTICK_EVENT();
+
+	std::string buffer;
+	ByteWriter out(buffer);
+
+	out.Write(static_cast<unsigned int>(COOKED_MAP_MAGIC));
+	out.Write(static_cast<unsigned int>(COOKED_MAP_VERSION));
+	out.Write(source_time);
+	out.Write(int(type));
+	out.Write(width);
+	out.Write(height);
+	out.Write(tile_width);
+	out.Write(tile_height);
+
+	out.Write(static_cast<unsigned int>(tilesets.size()));
+	for (std::vector<TileSet>::const_iterator it = tilesets.cbegin(); it != tilesets.cend(); ++it)
+		it->Serialize(out);
+
+	out.Write(static_cast<unsigned int>(layers.size()));
+	for (std::vector<MapLayer>::const_iterator it = layers.cbegin(); it != layers.cend(); ++it)
+		it->Serialize(out);
+
+	out.WriteArray(walkable_bits);
+
+	out.Write(static_cast<unsigned int>(obj_groups.size()));
+	for (std::vector<MapObjectGroup>::const_iterator it = obj_groups.cbegin(); it != obj_groups.cend(); ++it)
+	{
+		out.WriteString(it->name);
+		out.Write(static_cast<unsigned int>(it->objects.size()));
+
+		for (std::vector<MapObject>::const_iterator obj = it->objects.cbegin(); obj != it->objects.cend(); ++obj)
+		{
+			out.Write(obj->id);
+			out.Write(obj->x);
+			out.Write(obj->y);
+			out.Write(obj->width);
+			out.Write(obj->height);
+		}
+	}
+
+	bool ret = App->files.Save(file, buffer.c_str(), buffer.size());
+
+	if (ret)
+		LOG("Cooked map saved: %s (%d bytes)", file, buffer.size());
+
+	return ret;
+}
+
+void Map::BuildWalkabilityBits()
+{
+	// Same rule as the pathfinding grid: gid 0 on the navigation layer is walkable
+	const MapLayer& layer = GetMapWalkabilityLayer();
+	walkable_bits.assign((layer.width * layer.height + 7) / 8, 0u);
+
+	for (int y = 0; y < layer.height; ++y)
+	{
+		for (int x = 0; x < layer.width; ++x)
+		{
+			if (layer.GetID(x, y) == 0)
+			{
+				int bit = x + y * layer.width;
+				walkable_bits[bit >> 3] |= (unsigned char)(1 << (bit & 7));
+			}
+		}
+	}
+}
@@ -6,6 +6,10 @@
 #include <list>
 #include <string>
 
+#define COOKED_MAP_EXTENSION ".cooked"	// written next to the source map on first load
+#define COOKED_MAP_MAGIC 0x50414D4A		// "JMAP"
+#define COOKED_MAP_VERSION 1
+
 enum MapOrientation
 {
 	MAPTYPE_UNKNOWN = 0,
@@ -67,6 +71,12 @@ private:
 	bool ParseTilesets(pugi::xml_node& node);
 	bool ParseLayers(pugi::xml_node& node);
 	void ParseObjectGroups(pugi::xml_node& node);
+	bool LoadTilesetTexture(TileSet& tileset) const;
+
+	// Binary cache: header, tilesets, raw gid layers, walkability bits and objects
+	bool LoadCooked(const char* file, long long source_time);
+	bool SaveCooked(const char* file, long long source_time) const;
+	void BuildWalkabilityBits();
 
 private:
 
@@ -97,6 +107,7 @@ private:
 	std::vector<TileSet>		tilesets;
 	std::vector<MapLayer>		layers;
 	std::vector<MapObjectGroup>	obj_groups;
+	std::vector<unsigned char>	walkable_bits;
 };
 
 #endif // __MAP_H__
\ No newline at end of file
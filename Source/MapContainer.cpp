@@ -5,6 +5,8 @@
 #include "Scene.h"
 #include "TextureManager.h"
 #include "Map.h"
+#include "FileManager.h"
+#include "ByteStream.h"
 #include "JuicyMath.h"
 #include "Defs.h"
 #include "Log.h"
@@ -12,6 +14,86 @@
 #include "optick-1.3.0.0/include/optick.h"
 
 #include <math.h>
+#include <string.h>
+
+static bool DecodeBase64(const char* text, std::vector<char>& out)
+{
+	static signed char table[256];
+	static bool table_ready = false;
+
+	if (!table_ready)
+	{
+		const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		memset(table, -1, sizeof(table));
+		for (int i = 0; i < 64; ++i)
+			table[(unsigned char)alphabet[i]] = (signed char)i;
+		table_ready = true;
+	}
+
+	out.clear();
+	out.reserve(strlen(text) * 3 / 4);
+
+	unsigned int bits = 0u;
+	int count = 0;
+
+	for (const char* c = text; *c != '\0' && *c != '='; ++c)
+	{
+		signed char value = table[(unsigned char)*c];
+
+		// Tiled indents the payload: skip whitespace, reject anything else
+		if (value < 0)
+		{
+			if (*c == ' ' || *c == '\n' || *c == '\r' || *c == '\t')
+				continue;
+
+			return false;
+		}
+
+		bits = (bits << 6) | (unsigned int)value;
+		if (++count == 4)
+		{
+			out.push_back(char(bits >> 16));
+			out.push_back(char(bits >> 8));
+			out.push_back(char(bits));
+			bits = 0u;
+			count = 0;
+		}
+	}
+
+	if (count == 3)
+	{
+		out.push_back(char(bits >> 10));
+		out.push_back(char(bits >> 2));
+	}
+	else if (count == 2)
+		out.push_back(char(bits >> 4));
+	else if (count == 1)
+		return false;
+
+	return true;
+}
+
+static unsigned int GzipHeaderSize(const std::vector<char>& bytes)
+{
+	// RFC 1952: fixed 10 bytes then optional fields flagged in byte 3
+	if (bytes.size() < 18u || (unsigned char)bytes[0] != 0x1f || (unsigned char)bytes[1] != 0x8b || bytes[2] != 8)
+		return 0u;
+
+	unsigned char flags = (unsigned char)bytes[3];
+	unsigned int offset = 10u;
+
+	if (flags & 0x04) // FEXTRA
+		offset += 2u + ((unsigned char)bytes[10] | ((unsigned char)bytes[11] << 8));
+
+	for (unsigned char field = 0x08; field <= 0x10; field <<= 1) // FNAME, FCOMMENT
+		if (flags & field)
+			while (offset < bytes.size() && bytes[offset++] != '\0');
+
+	if (flags & 0x02) // FHCRC
+		offset += 2u;
+
+	return offset < bytes.size() ? offset : 0u;
+}
 
 TileSet::TileSet() : 
 	name("none")
@@ -30,6 +112,7 @@ TileSet::TileSet(const TileSet & copy) :
 	offset_y(copy.offset_y),
 	num_tiles_width(copy.num_tiles_width),
 	num_tiles_height(copy.num_tiles_height),
+	image(copy.image),
 	texture_id(copy.texture_id)
 	//terrain_types(copy.terrain_types),
 	//data(copy.data)
@@ -49,6 +132,35 @@ SDL_Rect TileSet::GetTileRect(int id) const
 	return rect;
 }
 
+void TileSet::Serialize(ByteWriter& out) const
+{
+	out.WriteString(name);
+	out.WriteString(image);
+	out.Write(firstgid);
+	out.Write(tile_width);
+	out.Write(tile_height);
+	out.Write(spacing);
+	out.Write(margin);
+	out.Write(tilecount);
+	out.Write(offset_x);
+	out.Write(offset_y);
+}
+
+bool TileSet::Deserialize(ByteReader& in)
+{
+	in.ReadString(name);
+	in.ReadString(image);
+	in.Read(firstgid);
+	in.Read(tile_width);
+	in.Read(tile_height);
+	in.Read(spacing);
+	in.Read(margin);
+	in.Read(tilecount);
+	in.Read(offset_x);
+	in.Read(offset_y);
+	return in.Good();
+}
+
 MapLayer::MapLayer()
 {}
 
@@ -71,6 +183,7 @@ bool MapLayer::ParseProperties(pugi::xml_node layer_properties)
 {
 	bool ret = false;
 	drawable = true;
+	properties.clear();
 
 	if (layer_properties)
 	{
@@ -92,23 +205,153 @@ bool MapLayer::ParseProperties(pugi::xml_node layer_properties)
 
 bool MapLayer::ParseData(pugi::xml_node layer_data)
 {
+	OPTICK_EVENT();
+
 	bool ret = false;
 
 	if (layer_data)
 	{
 		data.clear();
 
-		for (pugi::xml_node tile = layer_data.child("tile"); tile; tile = tile.next_sibling("tile"))
-			data.push_back(tile.attribute("gid").as_uint());
+		std::string encoding = layer_data.attribute("encoding").as_string();
+
+		if (encoding == "csv")
+			ret = ParseCSV(layer_data.child_value());
+		else if (encoding == "base64")
+			ret = ParseBase64(layer_data.child_value(), layer_data.attribute("compression").as_string());
+		else
+		{
+			data.reserve(width * height);
+
+			for (pugi::xml_node tile = layer_data.child("tile"); tile; tile = tile.next_sibling("tile"))
+				data.push_back(tile.attribute("gid").as_uint());
+
+			ret = true;
+		}
+
+		if (ret && int(data.size()) != width * height)
+		{
+			LOG("Layer %s has %d tiles, expected %d", name.c_str(), data.size(), width * height);
+			ret = false;
+		}
 
 		data.shrink_to_fit();
-		
-		ret = (data.size() == data.capacity());
 	}
 
 	return ret;
 }
 
+bool MapLayer::ParseCSV(const char* text)
+{
+	data.reserve(width * height);
+
+	unsigned int gid = 0u;
+	bool in_number = false;
+
+	for (const char* c = text; *c != '\0'; ++c)
+	{
+		if (*c >= '0' && *c <= '9')
+		{
+			gid = gid * 10u + (unsigned int)(*c - '0');
+			in_number = true;
+		}
+		else if (in_number)
+		{
+			data.push_back(gid);
+			gid = 0u;
+			in_number = false;
+		}
+	}
+
+	if (in_number)
+		data.push_back(gid);
+
+	return true;
+}
+
+bool MapLayer::ParseBase64(const char* text, const std::string& compression)
+{
+	std::vector<char> bytes;
+	if (!DecodeBase64(text, bytes))
+	{
+		LOG("Layer %s: invalid base64 data", name.c_str());
+		return false;
+	}
+
+	// Gids are little endian uint32 once inflated
+	unsigned int expected = (unsigned int)(width * height) * 4u;
+	data.resize(width * height);
+
+	if (compression.empty())
+	{
+		if (bytes.size() != expected)
+			return false;
+
+		memcpy(data.data(), bytes.data(), expected);
+		return true;
+	}
+
+	unsigned int offset = 0u;
+	bool zlib_header = true;
+
+	if (compression == "gzip")
+	{
+		offset = GzipHeaderSize(bytes);
+		zlib_header = false;
+
+		if (offset == 0u)
+		{
+			LOG("Layer %s: invalid gzip header", name.c_str());
+			return false;
+		}
+	}
+	else if (compression != "zlib")
+	{
+		LOG("Layer %s: unsupported compression %s", name.c_str(), compression.c_str());
+		return false;
+	}
+
+	return FileManager::Inflate(bytes.data() + offset, bytes.size() - offset, reinterpret_cast<char*>(data.data()), expected, zlib_header) == expected;
+}
+
+void MapLayer::Serialize(ByteWriter& out) const
+{
+	out.WriteString(name);
+	out.Write(width);
+	out.Write(height);
+	out.Write(drawable);
+
+	out.Write(static_cast<unsigned int>(properties.size()));
+	for (std::vector<std::pair<std::string, float>>::const_iterator it = properties.cbegin(); it != properties.cend(); ++it)
+	{
+		out.WriteString(it->first);
+		out.Write(it->second);
+	}
+
+	out.WriteArray(data);
+}
+
+bool MapLayer::Deserialize(ByteReader& in)
+{
+	in.ReadString(name);
+	in.Read(width);
+	in.Read(height);
+	in.Read(drawable);
+
+	unsigned int count = 0u;
+	in.Read(count);
+	properties.clear();
+	for (unsigned int i = 0u; i < count && in.Good(); ++i)
+	{
+		std::pair<std::string, float> pair;
+		in.ReadString(pair.first);
+		in.Read(pair.second);
+		properties.push_back(pair);
+	}
+
+	return in.ReadArray(data) && int(data.size()) == width * height;
+}
+
 int MapLayer::GetID(int x, int y) const
 {
 	int ret = -1;
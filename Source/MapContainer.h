@@ -7,6 +7,9 @@
 #include <string>
 #include <vector>
 
+class ByteWriter;
+class ByteReader;
+
 class TileSet
 {
 public:
@@ -20,6 +23,10 @@ public:
 
 	SDL_Rect GetTileRect(int id) const;
 
+	// Cooked map records, the texture is loaded back from image
+	void Serialize(ByteWriter& out) const;
+	bool Deserialize(ByteReader& in);
+
 public:
 
 	std::string	name;
@@ -37,6 +44,7 @@ public:
 	int	offset_y = 0;
 
 	// Texture
+	std::string image;
 	int texture_id = -1;
 	int	num_tiles_width = 0;
 	int	num_tiles_height = 0;
@@ -56,6 +64,9 @@ public:
 	bool ParseProperties(pugi::xml_node layer_properties);
 	bool ParseData(pugi::xml_node layer_data);
 
+	void Serialize(ByteWriter& out) const;
+	bool Deserialize(ByteReader& in);
+
 	int GetID(int x, int y) const;
 	float GetProperty(const char* name, float default_value = 0) const;
 
@@ -65,6 +76,12 @@ public:
 	int	width, height;
 	bool drawable = true;
 
+private:
+
+	// Tiled layer encodings, tile nodes are parsed in place
+	bool ParseCSV(const char* text);
+	bool ParseBase64(const char* text, const std::string& compression);
+
 private:
 
 	std::vector<std::pair<std::string, float>> properties;
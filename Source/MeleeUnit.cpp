@@ -10,15 +10,7 @@
 
 MeleeUnit::MeleeUnit(Gameobject* go) : B_Unit(go, UNIT_MELEE, IDLE, B_MELEE_UNIT)
 {
-	//Stats	
-	max_life = 100;
-	current_life = max_life;
-	atkTime = 1.0f;
-	speed = 3;
-	damage = 5;
-	attack_range = 2.0f;
-	vision_range = 20.0f;
-	providesVisibility = true;
+	ResetStats();
 
 	CreatePanel();
 	selectionPanel->SetInactive();
@@ -33,6 +25,19 @@ MeleeUnit::MeleeUnit(Gameobject* go) : B_Unit(go, UNIT_MELEE, IDLE, B_MELEE_UNIT
 
 MeleeUnit::~MeleeUnit() {}
 
+void MeleeUnit::ResetStats()
+{
+	//Stats
+	max_life = 100;
+	current_life = max_life;
+	atkTime = 1.0f;
+	speed = 3;
+	damage = 5;
+	attack_range = 2.0f;
+	vision_range = 20.0f;
+	providesVisibility = true;
+}
+
 void MeleeUnit::CreatePanel()
 {
 	panel_tex_ID = App->tex.Load("textures/Hud_Sprites.png");
@@ -13,6 +13,7 @@ public:
 	MeleeUnit(Gameobject* go);
 	~MeleeUnit();
 
+	void ResetStats() override;
 	void CreatePanel() override;
 
 public:
@@ -0,0 +1,247 @@
+#include "MemoryTracker.h"
+#include "Counters.h"
+#include "Log.h"
+
+#include "SDL/include/SDL_stdinc.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+struct alignas(16) BlockHeader
+{
+	size_t size;
+	int tag;
+	int weight; // allocations it stands for, 0 if it wasn't counted
+};
+
+struct TagCounters
+{
+	std::atomic<long long> live_bytes;
+	std::atomic<long long> live_blocks;
+	std::atomic<long long> peak_bytes;
+	std::atomic<long long> allocations;
+	std::atomic<long long> frame_allocations;
+	std::atomic<long long> frame_bytes;
+};
+
+// Zero initialized before any constructor runs: operator new is safe from the first allocation
+static TagCounters counters[MAX_MEM_TAGS];
+static MemoryTracker::Stats last_frame[MAX_MEM_TAGS];
+static unsigned int frames = 0u;
+static std::atomic<int> mode(MEMORY_FULL);
+
+static thread_local int current_tag = MEM_GENERAL;
+static thread_local unsigned int sample_tick = 0u;
+
+// Every tag, the allocations/frame figure the budgets are set against
+static Counter* heap_count = Counters::Find("memory/heap allocations", COUNTER_GAUGE);
+
+static const char* tag_names[MAX_MEM_TAGS] = { "general", "pathfinding", "collision", "render", "scene", "textures", "audio", "assets" };
+
+static void* Track(void* block, size_t size, int tag)
+{
+	if (block == nullptr)
+		return nullptr;
+
+	BlockHeader* header = static_cast<BlockHeader*>(block);
+	header->size = size;
+	header->tag = tag;
+	header->weight = 0;
+
+	int current_mode = mode.load(std::memory_order_relaxed);
+	if (current_mode == MEMORY_FULL)
+		header->weight = 1;
+	else if (current_mode == MEMORY_SAMPLED && ++sample_tick % MEMORY_SAMPLE_RATE == 0u)
+		header->weight = MEMORY_SAMPLE_RATE;
+
+	if (header->weight > 0)
+	{
+		TagCounters& c = counters[tag];
+		long long bytes = (long long)size * header->weight;
+		long long live = c.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		c.live_blocks.fetch_add(header->weight, std::memory_order_relaxed);
+		c.allocations.fetch_add(header->weight, std::memory_order_relaxed);
+		c.frame_allocations.fetch_add(header->weight, std::memory_order_relaxed);
+		c.frame_bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+		long long peak = c.peak_bytes.load(std::memory_order_relaxed);
+		while (live > peak && !c.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+	}
+
+	return header + 1;
+}
+
+static void Untrack(const BlockHeader& header)
+{
+	if (header.weight > 0)
+	{
+		TagCounters& c = counters[header.tag];
+		c.live_bytes.fetch_sub((long long)header.size * header.weight, std::memory_order_relaxed);
+		c.live_blocks.fetch_sub(header.weight, std::memory_order_relaxed);
+	}
+}
+
+static void* SDLCALL TrackedCalloc(size_t count, size_t size)
+{
+	void* ret = MemoryTracker::Allocate(count * size);
+	if (ret != nullptr)
+		memset(ret, 0, count * size);
+
+	return ret;
+}
+
+static void* SDLCALL TrackedMalloc(size_t size) { return MemoryTracker::Allocate(size); }
+static void* SDLCALL TrackedRealloc(void* ptr, size_t size) { return MemoryTracker::Reallocate(ptr, size); }
+static void SDLCALL TrackedFree(void* ptr) { MemoryTracker::Free(ptr); }
+
+void MemoryTracker::HookSDL()
+{
+	if (SDL_GetNumAllocations() == 0)
+		SDL_SetMemoryFunctions(TrackedMalloc, TrackedCalloc, TrackedRealloc, TrackedFree);
+	else
+		LOG("SDL allocated before the memory tracker hooked it: SDL memory stays untracked");
+}
+
+bool MemoryTracker::SetMode(const char* new_mode)
+{
+	bool ret = true;
+
+	if (strcmp(new_mode, "full") == 0)
+		mode = MEMORY_FULL;
+	else if (strcmp(new_mode, "sampled") == 0)
+		mode = MEMORY_SAMPLED;
+	else if (strcmp(new_mode, "off") == 0)
+		mode = MEMORY_OFF;
+	else
+	{
+		LOG("Unknown memory tracking mode %s: use full, sampled or off", new_mode);
+		ret = false;
+	}
+
+	return ret;
+}
+
+MemoryMode MemoryTracker::GetMode()
+{
+	return MemoryMode(mode.load());
+}
+
+MemoryTag MemoryTracker::SetTag(MemoryTag tag)
+{
+	MemoryTag ret = MemoryTag(current_tag);
+	current_tag = tag;
+	return ret;
+}
+
+void MemoryTracker::EndFrame()
+{
+	long long allocations = 0;
+	for (int i = 0; i < MAX_MEM_TAGS; ++i)
+	{
+		last_frame[i].frame_allocations = counters[i].frame_allocations.exchange(0);
+		last_frame[i].frame_bytes = counters[i].frame_bytes.exchange(0);
+		allocations += last_frame[i].frame_allocations;
+	}
+
+	heap_count->Set(allocations);
+
+	frames++;
+}
+
+unsigned int MemoryTracker::GetFrames()
+{
+	return frames;
+}
+
+MemoryTracker::Stats MemoryTracker::GetStats(MemoryTag tag)
+{
+	Stats ret = last_frame[tag];
+	ret.live_bytes = counters[tag].live_bytes.load();
+	ret.live_blocks = counters[tag].live_blocks.load();
+	ret.peak_bytes = counters[tag].peak_bytes.load();
+	ret.allocations = counters[tag].allocations.load();
+	return ret;
+}
+
+const char* MemoryTracker::GetTagName(MemoryTag tag)
+{
+	return tag_names[tag];
+}
+
+void MemoryTracker::Report(const char* title)
+{
+	if (mode == MEMORY_OFF)
+		return;
+
+	LOG("%s%s", title, mode == MEMORY_SAMPLED ? " (sampled estimate)" : "");
+	LOG("%-12s %10s %10s %10s %12s %10s", "tag", "live KB", "blocks", "peak KB", "allocations", "per frame");
+
+	for (int i = 0; i < MAX_MEM_TAGS; ++i)
+	{
+		Stats stats = GetStats(MemoryTag(i));
+		LOG("%-12s %10lld %10lld %10lld %12lld %10.1f", tag_names[i], stats.live_bytes / 1024, stats.live_blocks,
+			stats.peak_bytes / 1024, stats.allocations, frames > 0u ? double(stats.allocations) / double(frames) : 0.0);
+	}
+}
+
+void* MemoryTracker::Allocate(size_t size)
+{
+	return Track(malloc(sizeof(BlockHeader) + size), size, current_tag);
+}
+
+void* MemoryTracker::Reallocate(void* ptr, size_t size)
+{
+	if (ptr == nullptr)
+		return Allocate(size);
+
+	// On failure the old block is left as it was, still counted
+	BlockHeader old = *(static_cast<BlockHeader*>(ptr) - 1);
+	void* block = realloc(static_cast<BlockHeader*>(ptr) - 1, sizeof(BlockHeader) + size);
+	if (block == nullptr)
+		return nullptr;
+
+	Untrack(old);
+	return Track(block, size, old.tag);
+}
+
+void MemoryTracker::Free(void* ptr)
+{
+	if (ptr != nullptr)
+	{
+		BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+		Untrack(*header);
+		free(header);
+	}
+}
+
+// Global allocation functions ------------------------------------------
+
+void* operator new(size_t size)
+{
+	void* ret = MemoryTracker::Allocate(size);
+	if (ret == nullptr)
+		throw std::bad_alloc();
+
+	return ret;
+}
+
+void* operator new[](size_t size)
+{
+	void* ret = MemoryTracker::Allocate(size);
+	if (ret == nullptr)
+		throw std::bad_alloc();
+
+	return ret;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return MemoryTracker::Allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return MemoryTracker::Allocate(size); }
+
+void operator delete(void* ptr) noexcept { MemoryTracker::Free(ptr); }
+void operator delete[](void* ptr) noexcept { MemoryTracker::Free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { MemoryTracker::Free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { MemoryTracker::Free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { MemoryTracker::Free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { MemoryTracker::Free(ptr); }
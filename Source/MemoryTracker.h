@@ -0,0 +1,81 @@
+#ifndef __MEMORY_TRACKER_H__
+#define __MEMORY_TRACKER_H__
+
+#include <stddef.h>
+
+#define MEMORY_SAMPLE_RATE 64u // sampled mode counts one allocation in this many
+
+enum MemoryTag : int
+{
+	MEM_GENERAL,
+	MEM_PATHFINDING,
+	MEM_COLLISION,
+	MEM_RENDER,
+	MEM_SCENE,
+	MEM_TEXTURES,
+	MEM_AUDIO,
+	MEM_ASSETS,
+
+	MAX_MEM_TAGS
+};
+
+enum MemoryMode : int
+{
+	MEMORY_OFF,
+	MEMORY_SAMPLED,
+	MEMORY_FULL
+};
+
+// Replaces the global operator new/delete (and SDL's allocator once hooked)
+// on every platform and build. Each block carries a small header with its
+// size and the tag of the MemoryScope it was allocated in, so frees land
+// on the right counters from any thread. Sampled mode only counts one
+// allocation in MEMORY_SAMPLE_RATE, weighted, and skips the atomics for
+// the rest.
+class MemoryTracker
+{
+public:
+
+	struct Stats
+	{
+		long long live_bytes;
+		long long live_blocks;
+		long long peak_bytes;
+		long long allocations;	// since start
+		long long frame_allocations;
+		long long frame_bytes;
+	};
+
+	static void HookSDL(); // before any SDL call
+	static bool SetMode(const char* mode); // "full", "sampled" or "off"
+	static MemoryMode GetMode();
+
+	static MemoryTag SetTag(MemoryTag tag); // current thread, returns the previous one
+
+	// Closes the frame's allocation rate
+	static void EndFrame();
+	static unsigned int GetFrames();
+
+	static Stats GetStats(MemoryTag tag); // frame_* are the last finished frame
+	static const char* GetTagName(MemoryTag tag);
+	static void Report(const char* title);
+
+	static void* Allocate(size_t size);
+	static void* Reallocate(void* ptr, size_t size);
+	static void Free(void* ptr);
+};
+
+// Allocations in its lifetime count for tag
+class MemoryScope
+{
+public:
+
+	MemoryScope(MemoryTag tag) : previous(MemoryTracker::SetTag(tag)) {}
+	~MemoryScope() { MemoryTracker::SetTag(previous); }
+
+private:
+
+	MemoryTag previous;
+};
+
+#endif // __MEMORY_TRACKER_H__
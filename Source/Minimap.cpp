@@ -114,14 +114,18 @@ void Minimap::PostUpdate()
 	}
 
 	// Draw Units
-	for (std::map<double, Behaviour*>::const_iterator unit = Behaviour::b_map.cbegin(); unit != Behaviour::b_map.cend(); unit++)
+	icons_buffer.clear();
+	App->spatial.QueryRect({ 0.f, 0.f, float(map_size.first), float(map_size.second) }, icons_buffer,
+		SpatialFilter(ALL_UNIT_TYPES & ~(UNIT_TYPE_MASK(UNKNOWN) | UNIT_TYPE_MASK(EARTHQUAKE))));
+
+	for (std::vector<Behaviour*>::const_iterator unit = icons_buffer.cbegin(); unit != icons_buffer.cend(); unit++)
 	{
 		MinimapTexture index;
-		if (GetSectionIndex(unit->second->GetType(), index))
+		if (GetSectionIndex((*unit)->GetType(), index))
 		{
-			if (Behaviour::IsHidden(unit->second->GetID()) || draw_units_always)
+			if (Behaviour::IsHidden((*unit)->GetID()) || draw_units_always)
 			{
-				std::pair<float, float> world_pos = Map::F_MapToWorld(unit->second->GetGameobject()->GetTransform()->GetGlobalPosition());
+				std::pair<float, float> world_pos = Map::F_MapToWorld((*unit)->GetGameobject()->GetTransform()->GetGlobalPosition());
 
 				App->render->Blit(
 					border_texture,
@@ -4,8 +4,10 @@
 #include "Canvas.h"
 #include "SDL/include/SDL_rect.h"
 #include <map>
+#include <vector>
 
 class Transform;
+class Behaviour;
 
 enum MinimapTexture : int
 {
@@ -61,6 +63,8 @@ private:
 	int border_texture;
 
 	SDL_Rect sections[MAX_MINIMAP_TEXTURES];
+
+	std::vector<Behaviour*> icons_buffer; // reused spatial query results
 };
 
 #endif // !__MINIMAP_H__
\ No newline at end of file
@@ -18,6 +18,7 @@ public:
 
 	virtual bool PreUpdate() { return true; }
 	virtual bool Update() { return true; }
+	virtual bool FixedUpdate() { return true; } // once per simulation tick
 	virtual bool PostUpdate() { return true; }
 
 	virtual bool CleanUp() { return true; }
@@ -1,65 +1,211 @@
 #include "ParticleSystem.h"
 #include "Application.h"
-#include "Scene.h"
-#include "Gameobject.h"
-#include "Transform.h"
-#include "Particle.h"
+#include "TextureManager.h"
+#include "TimeManager.h"
+#include "Render.h"
+#include "Map.h"
+#include "Behaviour.h"
 #include "Vector3.h"
 #include "Log.h"
 
+#include "optick-1.3.0.0/include/optick.h"
+
 #include <vector>
+#include <algorithm>
+#include <math.h>
 
-ParticleSystem::ParticleSystem()
-{}
+const ParticleSystem::TypeData ParticleSystem::types[MAX_PARTICLES_TYPES] =
+{
+	{ "textures/particle_shot.png", { 0, 0, 30, 30 }, 9 },	// ORANGE_PARTICLE
+	{ "textures/particle_shot.png", { 0, 31, 30, 30 }, 9 },	// PURPLE_PARTICLE
+	{ "textures/Energy_Ball.png", { 0, 0, 60, 60 }, 17 }	// ENERGY_BALL_PARTICLE
+};
+
+ParticleSystem::ParticleSystem() :
+	start_x(MAX_PARTICLES), start_y(MAX_PARTICLES),
+	vel_x(MAX_PARTICLES), vel_y(MAX_PARTICLES),
+	launch(MAX_PARTICLES), type(MAX_PARTICLES), id(MAX_PARTICLES),
+	slot_of(MAX_PARTICLES)
+{
+	for (int i = 0; i < MAX_PARTICLES_TYPES; ++i)
+		textures[i] = -1;
+
+	CleanUp();
+}
 
 ParticleSystem::~ParticleSystem()
 {}
 
 void ParticleSystem::Start()
 {
-	particlesID = 0;
+	CleanUp();
 }
 
 void ParticleSystem::Update()
 {
-	if (!particles.empty())
+	OPTICK_EVENT();
+
+	previous_clock = clock;
+	clock += App->time.GetGameDeltaTime();
+
+	// Every projectile landing this tick, earliest first
+	while (!impacts.empty() && impacts.front().time <= clock)
 	{
-		for (std::vector<Particle*>::iterator it = particles.begin(); it != particles.end(); ++it)
-		{
-			if ((*it)->IsAlive())
-			{
-				(*it)->Update();
-				aliveCache.push_back(*it);
-			}
-			else
-				deathCache.push_back(*it);			
-		}
+		std::pop_heap(impacts.begin(), impacts.end(), Later);
+		Impact impact = impacts.back();
+		impacts.pop_back();
+
+		// Targets killed or recycled mid flight don't resolve anymore
+		Component* target = Component::Get(impact.target);
+		if (target != nullptr)
+			Event::Push(DAMAGE, target, impact.damage, impact.from);
+
+		Remove(impact.particle);
 	}
+}
 
-	if (!deathCache.empty())
+void ParticleSystem::Draw()
+{
+	OPTICK_EVENT();
+
+	if (count == 0u)
+		return;
+
+	const double now = previous_clock + (clock - previous_clock) * double(App->time.GetInterpolationAlpha());
+	const float base_offset = Map::GetBaseOffset();
+	RectF cam = App->render->GetCameraRectF();
+	float zoom = App->render->GetZoom();
+	if (zoom < 1.f) zoom = 1.f;
+
+	// Types sharing a texture share its batch
+	int batch[MAX_PARTICLES_TYPES];
+	for (int t = 0; t < MAX_PARTICLES_TYPES; ++t)
+	{
+		batch[t] = t;
+		for (int prev = 0; prev < t; ++prev)
+			if (textures[prev] == textures[t])
+				batch[t] = prev;
+
+		sections[t].clear();
+		rects[t].clear();
+	}
+
+	for (unsigned int i = 0u; i < count; ++i)
 	{
-		for (std::vector<Particle*>::iterator it = deathCache.begin(); it != deathCache.end(); ++it)
-			(*it)->GetGameobject()->Destroy();
+		float age = float(now - launch[i]);
+		if (age < 0.f) age = 0.f;
+
+		std::pair<float, float> world = Map::F_MapToWorld(start_x[i] + vel_x[i] * age, start_y[i] + vel_y[i] * age);
+		world.second += base_offset;
+
+		const TypeData& data = types[type[i]];
+		float screen_x = world.first - cam.x;
+		float screen_y = world.second - cam.y;
+		if (screen_x + data.first_frame.w * zoom < 0.f || screen_y + data.first_frame.h * zoom < 0.f || screen_x > cam.w || screen_y > cam.h)
+			continue;
 
-		deathCache.clear();
+		SDL_Rect section = data.first_frame;
+		section.x += (int(age / PARTICLE_FRAME_TIME) % data.frames) * section.w;
+
+		int b = batch[type[i]];
+		sections[b].push_back(section);
+		rects[b].push_back({ int(world.first), int(world.second), section.w, section.h });
 	}
-	particles = aliveCache;
-	aliveCache.clear();
+
+	for (int t = 0; t < MAX_PARTICLES_TYPES; ++t)
+		if (!rects[t].empty())
+			App->render->BlitBatch(textures[t], sections[t].data(), rects[t].data(), rects[t].size(), FRONT_SCENE);
 }
 
 void ParticleSystem::CleanUp()
 {
-	particles.clear();
-	aliveCache.clear();
-	deathCache.clear();
+	count = 0u;
+	clock = previous_clock = 0.0;
+	impacts.clear();
+
+	free_ids.clear();
+	for (unsigned int i = MAX_PARTICLES; i > 0u; --i)
+		free_ids.push_back(i - 1u);
+
+	for (int i = 0; i < MAX_PARTICLES_TYPES; ++i)
+	{
+		textures[i] = -1;
+		sections[i].clear();
+		rects[i].clear();
+	}
 }
 
-void ParticleSystem::AddParticle(vec p, vec dest, float speed, ParticleType t)
+void ParticleSystem::Launch(vec p, Behaviour* target, float speed, ParticleType t, int damage, UnitType from)
 {
-	if (particles.size() < MAX_PARTICLES)
+	double arrival;
+	int particle = Spawn(p, target->GetPos(), speed, t, arrival);
+	if (particle >= 0)
 	{
-		Gameobject* part = App->scene->AddGameobject("Particle");
-		part->GetTransform()->SetLocalPos(p);
-		particles.push_back(new Particle(part, p, dest, speed, t));
+		Impact impact = { arrival, static_cast<unsigned int>(particle), target->GetHandle(), damage, int(from) };
+		impacts.push_back(impact);
+		std::push_heap(impacts.begin(), impacts.end(), Later);
 	}
+	else
+		Event::Push(DAMAGE, target, damage, int(from));
+}
+
+unsigned int ParticleSystem::GetCount() const
+{
+	return count;
+}
+
+unsigned int ParticleSystem::GetPendingImpacts() const
+{
+	return impacts.size();
+}
+
+bool ParticleSystem::Later(const Impact& a, const Impact& b)
+{
+	return a.time > b.time;
+}
+
+int ParticleSystem::Spawn(vec p, vec dest, float speed, ParticleType t, double& arrival)
+{
+	float dx = dest.x - p.x;
+	float dy = dest.y - p.y;
+	float distance = sqrtf(dx * dx + dy * dy);
+
+	if (free_ids.empty() || distance <= 1.f || speed <= 0.f)
+		return -1;
+
+	if (textures[t] < 0)
+		textures[t] = App->tex.Load(types[t].texture);
+
+	unsigned int particle = free_ids.back();
+	free_ids.pop_back();
+
+	unsigned int i = count++;
+	slot_of[particle] = i;
+	id[i] = particle;
+	start_x[i] = p.x;
+	start_y[i] = p.y;
+	vel_x[i] = dx / distance * speed;
+	vel_y[i] = dy / distance * speed;
+	launch[i] = clock;
+	type[i] = t;
+
+	arrival = clock + double(distance / speed);
+	return int(particle);
+}
+
+void ParticleSystem::Remove(unsigned int particle)
+{
+	unsigned int i = slot_of[particle];
+	unsigned int last = --count;
+
+	start_x[i] = start_x[last];
+	start_y[i] = start_y[last];
+	vel_x[i] = vel_x[last];
+	vel_y[i] = vel_y[last];
+	launch[i] = launch[last];
+	type[i] = type[last];
+	id[i] = id[last];
+	slot_of[id[i]] = i;
+
+	free_ids.push_back(particle);
 }
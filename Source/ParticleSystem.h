@@ -1,15 +1,33 @@
 #ifndef __PARTICLESYSTEM_H__
 #define __PARTICLESYSTEM_H__
 
-#include "Particle.h"
 #include "Vector3.h"
-#include "Gameobject.h"
+#include "Component.h"
+#include "SDL/include/SDL_rect.h"
 
 #include <vector>
-#include <list>
 
-#define MAX_PARTICLES 1000
+#define MAX_PARTICLES 10000
+#define PARTICLE_FRAME_TIME 0.02f // seconds per animation frame
 
+class Behaviour;
+enum UnitType : int;
+
+enum ParticleType
+{
+	ORANGE_PARTICLE,
+	PURPLE_PARTICLE,
+	ENERGY_BALL_PARTICLE,
+
+	MAX_PARTICLES_TYPES,
+};
+
+// Fixed capacity pool of projectiles stored as parallel arrays. Flights
+// are straight lines, so a particle is only its launch: Draw places it from
+// the simulation clock and the arrival time is known when it's fired. Every
+// arrival sits in a min-heap; each tick pops the due ones, applies their
+// damage in one batch and swap-removes their particles. In-flight
+// particles cost nothing per tick. Draw queues one batch per texture.
 class ParticleSystem
 {
 public:
@@ -17,16 +35,63 @@ public:
 	~ParticleSystem();
 
 	void Start();
-	void Update();
+	void Update(); // one simulation tick: advances the clock, lands due projectiles
+	void Draw();
 	void CleanUp();
-	void AddParticle(vec pos,vec dest,float speed, ParticleType t);
+
+	// Target takes the damage when the projectile lands, right away if none can be fired
+	void Launch(vec pos, Behaviour* target, float speed, ParticleType t, int damage, UnitType from);
+
+	unsigned int GetCount() const;
+	unsigned int GetPendingImpacts() const;
 
 private:
 
-	std::vector<Particle*> particles;
-	std::vector<Particle*> aliveCache;
-	std::vector<Particle*> deathCache;
-	int particlesID;
+	struct TypeData
+	{
+		const char* texture;
+		SDL_Rect first_frame;
+		int frames;
+	};
+
+	struct Impact
+	{
+		double time;				// clock at arrival
+		unsigned int particle;		// id
+		ComponentHandle target;
+		int damage;
+		int from;					// UnitType
+	};
+
+	static bool Later(const Impact& a, const Impact& b);
+
+	// Particle id or -1 if the pool is full or it's already there
+	int Spawn(vec pos, vec dest, float speed, ParticleType t, double& arrival);
+	void Remove(unsigned int id);
+
+	static const TypeData types[MAX_PARTICLES_TYPES];
+
+	double clock = 0.0;			// simulated seconds since the match started
+	double previous_clock = 0.0;	// last tick, for interpolated drawing
+
+	// Alive particles: [0, count)
+	unsigned int count = 0u;
+	std::vector<float> start_x, start_y;
+	std::vector<float> vel_x, vel_y; // map tiles per second
+	std::vector<double> launch;
+	std::vector<ParticleType> type;
+	std::vector<unsigned int> id;
+
+	// Stable ids for the heap, slots move on swap-remove
+	std::vector<unsigned int> slot_of;
+	std::vector<unsigned int> free_ids;
+
+	std::vector<Impact> impacts; // min-heap on time
+
+	// Draw batches
+	int textures[MAX_PARTICLES_TYPES];
+	std::vector<SDL_Rect> sections[MAX_PARTICLES_TYPES];
+	std::vector<SDL_Rect> rects[MAX_PARTICLES_TYPES];
 };
 
-#endif
\ No newline at end of file
+#endif
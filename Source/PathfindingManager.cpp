@@ -1,8 +1,12 @@
 #include "Defs.h"
 #include "Log.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "Counters.h"
 #include "Point.h"
 #include "Application.h"
 #include "PathfindingManager.h"
+#include "Behaviour.h"
 #include "optick-1.3.0.0/include/optick.h"
 #include "Map.h"
 #include "Render.h"
@@ -12,8 +16,10 @@
 #include <vector>
 #include <algorithm>
 #include <map>
+#include <limits.h>
 
-std::vector<std::vector<float> >PathfindingManager::unitWalkability;
+static Counter* queue_count = Counters::Find("pathfinding/queued paths", COUNTER_GAUGE);
+static Counter* expanded_count = Counters::Find("pathfinding/nodes expanded");
 
 PathfindingManager::PathfindingManager()
 {}
@@ -30,17 +36,48 @@ bool PathfindingManager::Init()
 
 bool PathfindingManager::CleanUp()
 {
+	unsigned int reserved = GetReservedTileCount();
+	if (reserved > 0u)
+		LOG("Pathfinding: %d tiles still reserved by live units on clean up", reserved);
+
+	if (!storedPaths.empty() || !toDoPaths.empty())
+		LOG("Pathfinding: %d stored and %d pending paths left on clean up", storedPaths.size(), toDoPaths.size());
+
 	return true;
 }
 
+void PathfindingManager::CompletePaths()
+{
+	OPTICK_EVENT();
+	MemoryScope mem(MEM_PATHFINDING);
+	PROFILE_SCOPE("Pathfinding");
+
+	while (!toDoPaths.empty())
+	{
+		UncompletedPath path = toDoPaths.begin()->second;
+		ContinuePath(path, INT_MAX);
+
+		// Open list exhausted without reaching the end: unreachable
+		if (GetToDoPath(path.ID) != nullptr)
+			DeletePendingPath(path.ID);
+	}
+
+	queue_count->Set(toDoPaths.size());
+}
+
 int PathfindingManager::IteratePaths(int extra_ms)
 {
+	MemoryScope mem(MEM_PATHFINDING);
+	PROFILE_SCOPE("Pathfinding");
+
 	while (!toDoPaths.empty() && extra_ms > 0)
 	{
 		UncompletedPath path = toDoPaths.begin()->second;
 		extra_ms = ContinuePath(path, extra_ms);
 	}
 
+	queue_count->Set(toDoPaths.size());
+
 	if (debugAll)
 	{
 		std::vector<iPoint> currentPath;
@@ -187,7 +224,7 @@ void PathfindingManager::UpdatePendingPaths(double ID, UncompletedPath info)
 		toDoPaths.insert(std::pair<double, UncompletedPath>(ID, info));
 }
 
-//Utility: Delete one stored path
+//Utility: Delete one stored path and its pending search, which would store it again
 void PathfindingManager::DeletePath(double ID)
 {
 	std::map<double, std::vector<iPoint>>::iterator it;
@@ -195,6 +232,8 @@ void PathfindingManager::DeletePath(double ID)
 
 	if (it != storedPaths.end())
 		storedPaths.erase(it);
+
+	DeletePendingPath(ID);
 }
 
 //Utility: Delete one stored path
@@ -335,27 +374,221 @@ iPoint PathfindingManager::CheckEqualNeighbours(iPoint posA, iPoint posB)
 
 #pragma region Path creation utils
 // Sets up the walkability map
-void PathfindingManager::SetWalkabilityLayer(const MapLayer& layer)
+void PathfindingManager::SetWalkabilityLayer(const MapLayer& layer, const std::vector<unsigned char>* walkable_bits)
 {
 	map = layer;
 	std::vector<bool> vec(map.height);
 	walkabilityMap.resize(map.width);
 
-	std::vector<float> vec2(map.height);
-	unitWalkability.resize(map.width);
+	// Atomics can't be copied: swap in a zeroed grid
+	std::vector<std::atomic<unsigned int> >(map.width * map.height).swap(occupancy);
+	for (std::vector<std::atomic<unsigned int> >::iterator it = occupancy.begin(); it != occupancy.end(); ++it)
+		it->store(INVALID_COMPONENT_HANDLE, std::memory_order_relaxed);
+
+	bool cooked = (walkable_bits != nullptr && int(walkable_bits->size()) * 8 >= map.width * map.height);
 
 	for (int x = 0; x < map.width; x++)
 	{
 		walkabilityMap[x] = vec;
-		unitWalkability[x] = vec2;
 
 		for (int y = 0; y< map.height; y++)
 		{
-			iPoint point(x,y);
-			walkabilityMap[x][y] = IsWalkable(point);
-			unitWalkability[x][y] = 0.0f;
+			if (cooked)
+			{
+				int bit = x + y * map.width;
+				walkabilityMap[x][y] = ((*walkable_bits)[bit >> 3] & (1 << (bit & 7))) != 0;
+			}
+			else
+			{
+				iPoint point(x,y);
+				walkabilityMap[x][y] = IsWalkable(point);
+			}
+		}
+	}
+}
+
+void PathfindingManager::SmoothPath(std::vector<iPoint>& path, iPoint start) const
+{
+	if (path.size() < 2u)
+		return;
+
+	// Keep a tile only where sight from the last kept one breaks
+	iPoint anchor = start;
+	unsigned int kept = 0u;
+
+	for (unsigned int i = 1u; i < path.size(); ++i)
+	{
+		if (!LineOfSight(anchor, path[i]))
+		{
+			anchor = path[i - 1];
+			path[kept++] = anchor;
 		}
 	}
+
+	path[kept++] = path.back();
+	path.resize(kept);
+}
+
+bool PathfindingManager::LineOfSight(iPoint from, iPoint to) const
+{
+	return TraceLine(from, to, nullptr);
+}
+
+void PathfindingManager::ExpandSegment(iPoint from, iPoint to, std::vector<iPoint>& out) const
+{
+	TraceLine(from, to, &out);
+}
+
+void PathfindingManager::ExpandPath(iPoint start, const std::vector<iPoint>& waypoints, std::vector<iPoint>& out) const
+{
+	for (std::vector<iPoint>::const_iterator it = waypoints.cbegin(); it != waypoints.cend(); ++it)
+	{
+		ExpandSegment(start, *it, out);
+		start = *it;
+	}
+}
+
+bool PathfindingManager::TraceLine(iPoint from, iPoint to, std::vector<iPoint>* tiles) const
+{
+	int dx = abs(to.x - from.x);
+	int dy = -abs(to.y - from.y);
+	int sx = from.x < to.x ? 1 : -1;
+	int sy = from.y < to.y ? 1 : -1;
+	int err = dx + dy;
+
+	bool ret = true;
+	iPoint tile = from;
+	while (tile != to)
+	{
+		iPoint prev = tile;
+		int e2 = 2 * err;
+		if (e2 >= dy) { err += dy; tile.x += sx; }
+		if (e2 <= dx) { err += dx; tile.y += sy; }
+
+		// Same corner rule as diagonal pathnode adjacents
+		if (!ValidTile(tile.x, tile.y)
+			|| (tile.x != prev.x && tile.y != prev.y && (!ValidTile(tile.x, prev.y) || !ValidTile(prev.x, tile.y))))
+		{
+			ret = false;
+			if (tiles == nullptr)
+				break;
+		}
+
+		if (tiles != nullptr)
+			tiles->push_back(tile);
+	}
+
+	return ret;
+}
+
+bool PathfindingManager::ReserveTile(int x, int y, ComponentHandle unit)
+{
+	if (x < 0 || y < 0 || x >= map.width || y >= map.height)
+		return false;
+
+	std::atomic<unsigned int>& tile = occupancy[x + y * map.width];
+	unsigned int owner = tile.load(std::memory_order_acquire);
+
+	do
+	{
+		if (owner == unit)
+			return true;
+
+		// Owner still alive: tile taken
+		if (owner != INVALID_COMPONENT_HANDLE && Component::Get(owner) != nullptr)
+			return false;
+
+		if (!atomicReservations)
+		{
+			tile.store(unit, std::memory_order_relaxed);
+			return true;
+		}
+
+	} while (!tile.compare_exchange_weak(owner, unit, std::memory_order_acq_rel, std::memory_order_acquire));
+
+	return true;
+}
+
+void PathfindingManager::ReleaseTile(int x, int y, ComponentHandle unit)
+{
+	if (x < 0 || y < 0 || x >= map.width || y >= map.height)
+		return;
+
+	std::atomic<unsigned int>& tile = occupancy[x + y * map.width];
+
+	// Only the owner releases: other units may have taken the tile since
+	if (atomicReservations)
+		tile.compare_exchange_strong(unit, INVALID_COMPONENT_HANDLE, std::memory_order_acq_rel);
+	else if (tile.load(std::memory_order_relaxed) == unit)
+		tile.store(INVALID_COMPONENT_HANDLE, std::memory_order_relaxed);
+}
+
+void PathfindingManager::ReleaseTiles(std::vector<iPoint>& tiles, ComponentHandle unit)
+{
+	for (std::vector<iPoint>::const_iterator it = tiles.cbegin(); it != tiles.cend(); ++it)
+		ReleaseTile(it->x, it->y, unit);
+
+	tiles.clear();
+}
+
+bool PathfindingManager::IsTileReservedBy(int x, int y, ComponentHandle unit) const
+{
+	return GetTileOwner(x, y) == unit;
+}
+
+ComponentHandle PathfindingManager::GetTileOwner(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= map.width || y >= map.height)
+		return INVALID_COMPONENT_HANDLE;
+
+	return occupancy[x + y * map.width].load(atomicReservations ? std::memory_order_acquire : std::memory_order_relaxed);
+}
+
+unsigned int PathfindingManager::GetStoredPathCount() const
+{
+	return storedPaths.size();
+}
+
+unsigned int PathfindingManager::GetPendingPathCount() const
+{
+	return toDoPaths.size();
+}
+
+unsigned int PathfindingManager::GetReservedTileCount() const
+{
+	unsigned int ret = 0u;
+
+	for (std::vector<std::atomic<unsigned int> >::const_iterator it = occupancy.cbegin(); it != occupancy.cend(); ++it)
+	{
+		unsigned int owner = it->load(std::memory_order_relaxed);
+		if (owner != INVALID_COMPONENT_HANDLE && Component::Get(owner) != nullptr)
+			++ret;
+	}
+
+	return ret;
+}
+
+unsigned int PathfindingManager::GetStaleTileCount() const
+{
+	unsigned int ret = 0u;
+
+	for (std::vector<std::atomic<unsigned int> >::const_iterator it = occupancy.cbegin(); it != occupancy.cend(); ++it)
+	{
+		unsigned int owner = it->load(std::memory_order_relaxed);
+		if (owner != INVALID_COMPONENT_HANDLE)
+		{
+			Component* comp = Component::Get(owner);
+			if (comp == nullptr || comp->AsBehaviour()->IsDestroyed())
+				++ret;
+		}
+	}
+
+	return ret;
+}
+
+void PathfindingManager::SetAtomicReservations(bool enable)
+{
+	atomicReservations = enable;
 }
 
 // Utility: return true if pos is inside the map boundaries
@@ -384,7 +617,7 @@ bool PathfindingManager::GetTileAt(iPoint& pos)
 }
 
 //Utility: Return true if tile is valid
-bool PathfindingManager::ValidTile(int x, int y)
+bool PathfindingManager::ValidTile(int x, int y) const
 {
 	if (x >= 0 && y >= 0 && x < map.width && y < map.height) return walkabilityMap[x][y]; 
 	return false;
@@ -397,7 +630,7 @@ void PathfindingManager::SetWalkabilityTile(int x, int y, bool state)
 	if (x >= 0 && y >= 0 && x < map.width && y < map.height)
 		walkabilityMap[x][y] = state;
 	else
-		LOG("Not valid coordinates!");
+		LOG_WARNING("Not valid coordinates!");
 }
 
 //Utility: Check tile area
@@ -431,7 +664,7 @@ bool PathfindingManager::CheckWalkabilityArea(std::pair<int, int> pos, vec scale
 }
 
 //Utility: Returns boolean if found item
-bool PathfindingManager::FindItemInVector(std::vector<PathNode> vec, PathNode node)
+bool PathfindingManager::FindItemInVector(const std::vector<PathNode>& vec, const PathNode& node) const
 {
 	for (std::vector<PathNode>::const_iterator it = vec.cbegin(); it != vec.cend(); ++it)
 	{
@@ -455,10 +688,10 @@ void PathfindingManager::RemoveItemInVector(std::vector<PathNode>& vec, PathNode
 }
 
 //Utility: Returns item of a vector
-PathNode PathfindingManager::GetItemInVector(std::vector<PathNode> vec, iPoint nodePos)
+PathNode PathfindingManager::GetItemInVector(const std::vector<PathNode>& vec, iPoint nodePos) const
 {
 	PathNode item;
-	for (std::vector<PathNode>::iterator it = vec.begin(); it != vec.end(); it++)
+	for (std::vector<PathNode>::const_iterator it = vec.cbegin(); it != vec.cend(); it++)
 	{
 		if (it->pos == nodePos)
 			return item = *it;
@@ -467,10 +700,9 @@ PathNode PathfindingManager::GetItemInVector(std::vector<PathNode> vec, iPoint n
 	return item;
 }
 
-// Fills a vector of all valid adjacent pathnodes
-std::vector<PathNode> PathNode::FindWalkableAdjacents()
+// Fills list with all valid adjacent pathnodes
+void PathNode::FindWalkableAdjacents(FrameVector<PathNode>& list)
 {
-	std::vector<PathNode> list;
 	iPoint cell;
 
 	// north
@@ -512,8 +744,6 @@ std::vector<PathNode> PathNode::FindWalkableAdjacents()
 	cell.create(pos.x - 1, pos.y-1);
 	if (App->pathfinding.ValidTile(cell.x,cell.y) && App->pathfinding.ValidTile(cell.x, cell.y + 1) && App->pathfinding.ValidTile(cell.x + 1, cell.y))
 		list.push_back(PathNode(cell, this->pos));
-
-	return list;
 }
 
 // Calculate the F for a specific destination tile
@@ -575,8 +805,8 @@ void PathfindingManager::VectorMergesort(std::vector<PathNode>& vec, int length)
 	{
 		for (left_start = 0; left_start < length - 1; left_start += 2 * curr_size)
 		{
-			int mid = min(left_start + curr_size - 1, length - 1);
-			int right_end = min(left_start + 2 * curr_size - 1, length - 1);
+			int mid = std::min(left_start + curr_size - 1, length - 1);
+			int right_end = std::min(left_start + 2 * curr_size - 1, length - 1);
 			Merge(vec, left_start, mid, right_end);
 		}
 	}
@@ -638,6 +868,8 @@ void PathfindingManager::Merge(std::vector<PathNode>& vec, int l, int m, int r)
 // Main function to request a path from A to B
 std::vector<iPoint> * PathfindingManager::CreatePath(iPoint origin, iPoint destination, double ID)
 {
+	MemoryScope mem(MEM_PATHFINDING);
+
 	std::vector<iPoint>* pathPointer = nullptr;
 	std::vector<iPoint> finalPath;
 	iPoint goPoint = destination;
@@ -690,10 +922,13 @@ int PathfindingManager::ContinuePath(UncompletedPath pathToDo, int working_ms)
 	OPTICK_EVENT();
 	Timer timer;
 
-	UncompletedPath path = pathToDo;	
+	UncompletedPath& path = pathToDo;
 	bool pathEnd = false;
 	std::vector<iPoint>* pathPointer = GetPath(path.ID);	
 	PathNode checkNode;
+	FrameVector<PathNode> adjacentCells;
+	adjacentCells.reserve(8);
+	unsigned int expanded = 0u;
 	while (!path.openList.empty() && timer.ReadI() < working_ms)
 	{	
 		VectorQuicksort(path.openList, 0, path.openList.size() - 1);
@@ -701,6 +936,7 @@ int PathfindingManager::ContinuePath(UncompletedPath pathToDo, int working_ms)
 		path.openList.erase(path.openList.begin());
 		path.closedList.push_back(checkNode); //Save node to evaluated list				
 		path.length++;
+		expanded++;
 
 		if (checkNode.pos == path.end)
 		{
@@ -708,8 +944,8 @@ int PathfindingManager::ContinuePath(UncompletedPath pathToDo, int working_ms)
 			break;
 		}
 
-		std::vector<PathNode> adjacentCells;
-		adjacentCells = checkNode.FindWalkableAdjacents();
+		adjacentCells.clear();
+		checkNode.FindWalkableAdjacents(adjacentCells);
 
 		for (int a = 0; a < adjacentCells.size(); a++) //Check neighbour cells
 		{
@@ -734,8 +970,6 @@ int PathfindingManager::ContinuePath(UncompletedPath pathToDo, int working_ms)
 				}
 			}
 		}
-
-		adjacentCells.clear();
 	}
 
 	if (pathEnd)//Delete pending path from map list
@@ -750,6 +984,7 @@ int PathfindingManager::ContinuePath(UncompletedPath pathToDo, int working_ms)
 		}
 
 		std::reverse(finalPath.begin(), finalPath.end());
+		SmoothPath(finalPath, path.localStart);
 
 		for (std::vector<iPoint>::iterator it = finalPath.begin(); it != finalPath.end(); it++) //Save new path positions
 			pathPointer->push_back(*it);
@@ -761,5 +996,7 @@ int PathfindingManager::ContinuePath(UncompletedPath pathToDo, int working_ms)
 		UpdatePendingPaths(path.ID, path);
 	}
 
+	expanded_count->Add(expanded);
+
 	return working_ms - timer.ReadI();
 }
\ No newline at end of file
@@ -5,9 +5,12 @@
 #include "Point.h"
 #include "MapContainer.h"
 #include "Vector3.h"
+#include "Component.h"
+#include "FrameArena.h"
 
 #include <vector>
 #include <map>
+#include <atomic>
 
 #define MAX_PATH_CALCULATIONS 40
 
@@ -21,8 +24,8 @@ struct PathNode
 	PathNode(iPoint pos, iPoint parent);
 	PathNode(const PathNode& node);
 
-	// Fills a vector of all valid adjacent pathnodes
-	std::vector<PathNode> FindWalkableAdjacents();	
+	// Fills list with all valid adjacent pathnodes
+	void FindWalkableAdjacents(FrameVector<PathNode>& list);
 	// Calculate the F for a specific destination tile
 	void CalculateF(iPoint destination);
 
@@ -59,9 +62,10 @@ public:
 	bool CleanUp();
 
 	int IteratePaths(int extra_ms);
+	void CompletePaths(); // lockstep: finishes every pending search this frame
 
-	// Sets up the walkability map
-	void SetWalkabilityLayer(const MapLayer& layer);
+	// Sets up the walkability map, from a packed x + y * width bitset when cooked
+	void SetWalkabilityLayer(const MapLayer& layer, const std::vector<unsigned char>* walkable_bits = nullptr);
 
 	// Main function to request a path from A to B
 	std::vector<iPoint>* CreatePath(iPoint origin, iPoint destination, double ID);
@@ -78,19 +82,19 @@ public:
 	bool GetTileAt( iPoint& pos);
 
 	//Utility: Return true if tile is valid
-	bool ValidTile(int x, int y);
+	bool ValidTile(int x, int y) const;
 
 	//Utility: Sets tile walkability
 	void SetWalkabilityTile(int x,int y,bool estate);
 
 	//Utility: Find node in vector and returns boolean
-	bool FindItemInVector(std::vector<PathNode> vec,PathNode node);
+	bool FindItemInVector(const std::vector<PathNode>& vec, const PathNode& node) const;
 
 	//Utility: Remove node in vector
 	void RemoveItemInVector(std::vector<PathNode>& vec, PathNode node);
 
 	// Utility: Get node in vector 
-	PathNode GetItemInVector(std::vector<PathNode> vec, iPoint nodePos);
+	PathNode GetItemInVector(const std::vector<PathNode>& vec, iPoint nodePos) const;
 
 	//Utility: Quicksort for vector
 	void VectorQuicksort(std::vector<PathNode>& vec,int L,int R);
@@ -137,10 +141,41 @@ public:
 	//Utility: Check equal neighbours tiles and return valid
 	iPoint CheckEqualNeighbours(iPoint posA, iPoint posB);
 
+	// String pulling: compresses a tile chain starting next to start into waypoints
+	void SmoothPath(std::vector<iPoint>& path, iPoint start) const;
+
+	// Utility: true if the 8-connected line between both tiles is walkable
+	bool LineOfSight(iPoint from, iPoint to) const;
+
+	// Utility: appends the raw tiles of a leg (from excluded, to included)
+	void ExpandSegment(iPoint from, iPoint to, std::vector<iPoint>& out) const;
+
+	// Utility: appends the raw tiles of every leg of a waypoint path
+	void ExpandPath(iPoint start, const std::vector<iPoint>& waypoints, std::vector<iPoint>& out) const;
+
+	// Tile reservations: owner is a generational unit handle, a dead owner counts as free
+	bool ReserveTile(int x, int y, ComponentHandle unit);
+	void ReleaseTile(int x, int y, ComponentHandle unit);
+	void ReleaseTiles(std::vector<iPoint>& tiles, ComponentHandle unit);
+	bool IsTileReservedBy(int x, int y, ComponentHandle unit) const;
+	ComponentHandle GetTileOwner(int x, int y) const;
+	unsigned int GetReservedTileCount() const;
+	unsigned int GetStaleTileCount() const; // still held by a dead or dying unit
+
+	unsigned int GetStoredPathCount() const;
+	unsigned int GetPendingPathCount() const;
+
+	// Compare-exchange reservations, needed once movement runs on job workers
+	void SetAtomicReservations(bool enable);
+
 public:
 
 	int debugTextureID;
-	static std::vector<std::vector<float> > unitWalkability;
+
+private:
+
+	// Bresenham walk, false if a step is blocked. Without tiles to fill it stops there
+	bool TraceLine(iPoint from, iPoint to, std::vector<iPoint>* tiles) const;
 
 private:
 
@@ -151,6 +186,8 @@ private:
 	MapLayer map;
 	iPoint nullPoint = iPoint({ -1,-1 });
 	std::vector<std::vector<bool> > walkabilityMap;
+	std::vector<std::atomic<unsigned int> > occupancy; // flat, x + y * width
+	bool atomicReservations = false;
 	//std::vector<std::pair<int, int> > walkabilityBuildingCheck;
 	std::map<double, std::vector<iPoint>> storedPaths; //Stores all generated paths by units
 	std::map<double, UncompletedPath> toDoPaths; //Stores pending path for each id
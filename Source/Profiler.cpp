@@ -0,0 +1,298 @@
+#include "Profiler.h"
+#include "Application.h"
+#include "Render.h"
+#include "FontManager.h"
+#include "Defs.h"
+#include "Log.h"
+
+#include "SDL/include/SDL_timer.h"
+#include "SDL/include/SDL_rwops.h"
+#include "SDL/include/SDL_error.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+// Rings live as long as the process: worker threads may still close zones at exit
+std::vector<Profiler::Ring*> Profiler::rings;
+std::mutex Profiler::rings_mutex;
+thread_local Profiler::Ring* Profiler::thread_ring = nullptr;
+
+Profiler::Profiler()
+{}
+
+Profiler::~Profiler()
+{}
+
+void Profiler::CleanUp()
+{
+	if (!export_on_exit.empty())
+		Export(export_on_exit.c_str());
+
+	DEL(overlay_text);
+}
+
+Profiler::Ring* Profiler::GetRing()
+{
+	if (thread_ring == nullptr)
+	{
+		Ring* ring = new Ring();
+		ring->head = ring->tail = ring->dropped = 0u;
+
+		std::lock_guard<std::mutex> lock(rings_mutex);
+		ring->thread = rings.size();
+		rings.push_back(ring);
+		thread_ring = ring;
+	}
+
+	return thread_ring;
+}
+
+void Profiler::Record(const char* name, unsigned long long start, unsigned long long end)
+{
+	Ring* ring = GetRing();
+	unsigned int head = ring->head.load(std::memory_order_relaxed);
+
+	// Full until the next EndFrame drains it
+	if (head - ring->tail.load(std::memory_order_acquire) >= PROFILER_RING_SIZE)
+	{
+		ring->dropped.fetch_add(1u, std::memory_order_relaxed);
+		return;
+	}
+
+	ProfileSample& sample = ring->samples[head % PROFILER_RING_SIZE];
+	sample.name = name;
+	sample.start = start;
+	sample.end = end;
+	ring->head.store(head + 1u, std::memory_order_release);
+}
+
+void Profiler::EndFrame()
+{
+	unsigned long long now = SDL_GetPerformanceCounter();
+	double to_ms = 1000.0 / double(SDL_GetPerformanceFrequency());
+
+	if (last_frame != 0u)
+		Record("Frame", last_frame, now);
+
+	last_frame = now;
+
+	unsigned int events = 0u;
+	unsigned int dropped = 0u;
+	{
+		std::lock_guard<std::mutex> lock(rings_mutex);
+		for (std::vector<Ring*>::const_iterator it = rings.cbegin(); it != rings.cend(); ++it)
+		{
+			Ring* ring = *it;
+			unsigned int head = ring->head.load(std::memory_order_acquire);
+			for (unsigned int i = ring->tail.load(std::memory_order_relaxed); i != head; ++i)
+			{
+				const ProfileSample& sample = ring->samples[i % PROFILER_RING_SIZE];
+				Zone& zone = GetZone(sample.name);
+				zone.calls++;
+				zone.frame_ms += double(sample.end - sample.start) * to_ms;
+
+				TraceEvent event = { sample, ring->thread };
+				trace.push_back(event);
+				events++;
+			}
+
+			ring->tail.store(head, std::memory_order_release);
+			dropped += ring->dropped.exchange(0u, std::memory_order_relaxed);
+		}
+	}
+
+	frames++;
+	last_dropped = dropped;
+	total_dropped += dropped;
+
+	for (std::vector<Zone>::iterator it = zones.begin(); it != zones.end(); ++it)
+	{
+		if (it->calls > 0u)
+		{
+			if (it->history.size() < PROFILER_HISTORY)
+				it->history.push_back(float(it->frame_ms));
+			else
+				it->history[it->next] = float(it->frame_ms);
+
+			it->next = (it->next + 1u) % PROFILER_HISTORY;
+			it->total_calls += it->calls;
+			it->frames++;
+			it->calls = 0u;
+			it->frame_ms = 0.0;
+		}
+	}
+
+	// Trace keeps the last frames only
+	trace_frames.push_back(events);
+	while (trace_frames.size() > PROFILER_TRACE_FRAMES)
+	{
+		trace.erase(trace.begin(), trace.begin() + trace_frames.front());
+		trace_frames.pop_front();
+	}
+}
+
+void Profiler::DrawOverlay()
+{
+	if (!overlay)
+		return;
+
+	if ((overlay_timer -= App->time.GetDeltaTime()) <= 0.f)
+	{
+		overlay_timer = PROFILER_OVERLAY_REFRESH;
+		UpdateOverlay();
+	}
+
+	int width, height;
+	if (overlay_text != nullptr && overlay_text->GetSize(width, height))
+		App->render->DrawQuad({ 5, 5, width + 10, height + 10 }, { 0, 0, 0, 180 }, true, EDITOR, false);
+
+	App->render->Blit_Text(overlay_text, 10, 10, EDITOR, false);
+}
+
+void Profiler::ToggleOverlay()
+{
+	overlay = !overlay;
+	overlay_timer = 0.f;
+}
+
+bool Profiler::Export(const char* prefix)
+{
+	double to_us = 1000000.0 / double(SDL_GetPerformanceFrequency());
+	unsigned long long origin = trace.empty() ? 0u : trace.front().sample.start;
+	char line[256];
+
+	// Chrome trace event format, complete events
+	std::string json = "{\"traceEvents\":[\n";
+	for (std::deque<TraceEvent>::const_iterator it = trace.cbegin(); it != trace.cend(); ++it)
+	{
+		unsigned long long start = it->sample.start > origin ? it->sample.start - origin : 0u;
+		snprintf(line, 256, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+			it == trace.cbegin() ? "" : ",\n", it->sample.name, double(start) * to_us,
+			double(it->sample.end - it->sample.start) * to_us, it->thread);
+		json += line;
+	}
+	json += "\n]}\n";
+
+	std::string csv = "zone,calls_per_frame,min_ms,avg_ms,p95_ms,p99_ms,max_ms\n";
+	for (std::vector<Zone>::const_iterator it = zones.cbegin(); it != zones.cend(); ++it)
+	{
+		ZoneStats stats = GetStats(*it);
+		snprintf(line, 256, "%s,%.2f,%.4f,%.4f,%.4f,%.4f,%.4f\n", it->name, stats.calls, stats.min, stats.avg, stats.p95, stats.p99, stats.max);
+		csv += line;
+	}
+
+	if (total_dropped > 0u)
+	{
+		snprintf(line, 256, "(dropped),%.2f,,,,,\n", double(total_dropped) / double(frames > 0u ? frames : 1u));
+		csv += line;
+		LOG_WARNING("Profile export is missing %llu samples dropped by full rings, raise PROFILER_RING_SIZE (%u)", total_dropped, PROFILER_RING_SIZE);
+	}
+
+	bool ret = true;
+	const std::string* contents[2] = { &json, &csv };
+	const char* extensions[2] = { ".json", ".csv" };
+	for (int i = 0; i < 2; ++i)
+	{
+		std::string path = std::string(prefix) + extensions[i];
+		SDL_RWops* rw = SDL_RWFromFile(path.c_str(), "wb");
+		bool written = rw != nullptr && SDL_RWwrite(rw, contents[i]->c_str(), 1, contents[i]->size()) == contents[i]->size();
+		if (rw != nullptr)
+			SDL_RWclose(rw);
+
+		if (written)
+			LOG("Profile exported to %s", path.c_str());
+		else
+		{
+			LOG("Error exporting profile to %s: %s", path.c_str(), SDL_GetError());
+			ret = false;
+		}
+	}
+
+	return ret;
+}
+
+void Profiler::SetExportOnExit(const char* prefix)
+{
+	export_on_exit = prefix;
+}
+
+Profiler::Zone& Profiler::GetZone(const char* name)
+{
+	// Equal literals of different translation units may not share a pointer
+	for (std::vector<Zone>::iterator it = zones.begin(); it != zones.end(); ++it)
+		if (it->name == name || strcmp(it->name, name) == 0)
+			return *it;
+
+	Zone zone;
+	zone.name = name;
+	zone.calls = 0u;
+	zone.frame_ms = 0.0;
+	zones.push_back(zone);
+	return zones.back();
+}
+
+Profiler::ZoneStats Profiler::GetStats(const Zone& zone) const
+{
+	ZoneStats ret = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+
+	if (!zone.history.empty())
+	{
+		std::vector<float> sorted = zone.history;
+		std::sort(sorted.begin(), sorted.end());
+
+		float total = 0.f;
+		for (std::vector<float>::const_iterator it = sorted.cbegin(); it != sorted.cend(); ++it)
+			total += *it;
+
+		unsigned int last = sorted.size() - 1u;
+		ret.min = sorted.front();
+		ret.avg = total / float(sorted.size());
+		ret.p95 = sorted[last * 95u / 100u];
+		ret.p99 = sorted[last * 99u / 100u];
+		ret.max = sorted.back();
+		ret.calls = float(zone.total_calls) / float(zone.frames);
+	}
+
+	return ret;
+}
+
+void Profiler::UpdateOverlay()
+{
+	// Slowest zones on average first
+	std::vector<std::pair<float, unsigned int>> order;
+	for (unsigned int i = 0u; i < zones.size(); ++i)
+		order.push_back({ GetStats(zones[i]).avg, i });
+
+	std::sort(order.begin(), order.end(), [](const std::pair<float, unsigned int>& a, const std::pair<float, unsigned int>& b) { return a.first > b.first; });
+
+	std::string text = "zone: avg / p95 / p99 ms";
+	char line[128];
+
+	if (total_dropped > 0u)
+	{
+		snprintf(line, 128, "\nDROPPED %u samples last frame, %llu total", last_dropped, total_dropped);
+		text += line;
+	}
+
+	for (unsigned int i = 0u; i < order.size() && i < PROFILER_OVERLAY_LINES; ++i)
+	{
+		ZoneStats stats = GetStats(zones[order[i].second]);
+		snprintf(line, 128, "\n%s: %.2f / %.2f / %.2f", zones[order[i].second].name, stats.avg, stats.p95, stats.p99);
+		text += line;
+	}
+
+	if (overlay_text == nullptr)
+		overlay_text = new RenderedText(text.c_str(), -1, { 255, 255, 255, 255 }, 600u);
+	else
+		overlay_text->SetText(text.c_str());
+}
+
+ProfileScope::ProfileScope(const char* name) : name(name), start(SDL_GetPerformanceCounter())
+{}
+
+ProfileScope::~ProfileScope()
+{
+	Profiler::Record(name, start, SDL_GetPerformanceCounter());
+}
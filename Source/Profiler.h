@@ -0,0 +1,131 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define PROFILER_RING_SIZE 4096u	// zones a thread can close between two EndFrame
+#define PROFILER_HISTORY 300u		// frames kept per zone for the percentiles
+#define PROFILER_TRACE_FRAMES 120u	// frames kept for the trace export
+#define PROFILER_OVERLAY_LINES 16u
+#define PROFILER_OVERLAY_REFRESH 0.25f // seconds
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+
+class RenderedText;
+
+struct ProfileSample
+{
+	const char* name; // string literal or module name, must outlive the profiler
+	unsigned long long start, end;
+};
+
+// Portable scoped timer profiler. A zone closing writes one sample into
+// its thread's ring buffer, a single producer / single consumer queue with
+// no locks. At the end of every frame the main thread drains all rings,
+// adds each zone's time to its history and keeps the raw samples of the
+// last frames for the Chrome trace export. F8 toggles the overlay and F11
+// exports the trace and a CSV of every zone. Samples a full ring had to
+// drop are counted and shown by the overlay and the export.
+class Profiler
+{
+public:
+
+	Profiler();
+	~Profiler();
+
+	void CleanUp();
+
+	// Main thread, once per frame
+	void EndFrame();
+	void DrawOverlay();
+
+	void ToggleOverlay();
+	bool Export(const char* prefix); // prefix.json (chrome://tracing) & prefix.csv
+	void SetExportOnExit(const char* prefix);
+
+	static void Record(const char* name, unsigned long long start, unsigned long long end);
+
+private:
+
+	struct Ring
+	{
+		ProfileSample samples[PROFILER_RING_SIZE];
+		std::atomic<unsigned int> head;	// written by its thread
+		std::atomic<unsigned int> tail;	// written by EndFrame
+		std::atomic<unsigned int> dropped;
+		unsigned int thread;
+	};
+
+	struct Zone
+	{
+		const char* name;
+		unsigned int calls;
+		double frame_ms;
+
+		std::vector<float> history;	// ms per frame it ran, circular
+		unsigned int next = 0u;
+		unsigned long long total_calls = 0u;
+		unsigned int frames = 0u;
+	};
+
+	struct ZoneStats
+	{
+		float min, avg, p95, p99, max, calls;
+	};
+
+	struct TraceEvent
+	{
+		ProfileSample sample;
+		unsigned int thread;
+	};
+
+	static Ring* GetRing();
+
+	Zone& GetZone(const char* name);
+	ZoneStats GetStats(const Zone& zone) const;
+	void UpdateOverlay();
+
+private:
+
+	static std::vector<Ring*> rings;
+	static std::mutex rings_mutex;
+	static thread_local Ring* thread_ring;
+
+	std::vector<Zone> zones;
+	unsigned long long last_frame = 0u;
+	unsigned int frames = 0u;
+
+	// Samples lost to full rings: the zones under report by this much
+	unsigned int last_dropped = 0u;
+	unsigned long long total_dropped = 0u;
+
+	std::deque<TraceEvent> trace;
+	std::deque<unsigned int> trace_frames; // events per kept frame
+
+	bool overlay = false;
+	float overlay_timer = 0.f;
+	RenderedText* overlay_text = nullptr;
+
+	std::string export_on_exit;
+};
+
+class ProfileScope
+{
+public:
+
+	ProfileScope(const char* name);
+	~ProfileScope();
+
+private:
+
+	const char* name;
+	unsigned long long start;
+};
+
+#endif // __PROFILER_H__
@@ -141,14 +141,7 @@ void Quadtree::Remove(Collider* obj)
 	}
 }
 
-std::vector<Collider*> Quadtree::Search(Collider& obj)
-{
-	std::vector<Collider*> overlaps;
-	Search(obj, overlaps);
-	return overlaps;
-}
-
-void Quadtree::Search(Collider& obj, std::vector<Collider*>& list)
+void Quadtree::Search(Collider& obj, FrameVector<Collider*>& list)
 {
 	if (IntersectBounds(obj))//Inside quad
 	{
@@ -179,7 +172,7 @@ void Quadtree::Split()
 	children[CHILD_SE] = new Quadtree(maxObjects, maxLevels, level + 1, { boundary.x + childWidth, boundary.y + childHeight, childWidth, childHeight }, this);
 }
 
-bool Quadtree::IntersectBounds(Collider coll)
+bool Quadtree::IntersectBounds(Collider& coll)
 {
 	//LOG("Point X:%f/Y:%f", coll.top.first, coll.top.second);
 	//LOG("Bounds X:%d/Y:%d/W:%d/H:%d", boundary.x, boundary.y, boundary.x + boundary.w, boundary.y + boundary.h);
@@ -5,6 +5,7 @@
 #include "Point.h"
 #include "Gameobject.h"
 #include "Collider.h"
+#include "FrameArena.h"
 
 #include <vector>
 
@@ -25,18 +26,14 @@ public:
 	void Clear();
 	void Insert(Collider* obj);
 	void Remove(Collider* obj);
-	bool IntersectBounds(Collider coll);
-	std::vector<Collider*> Search(Collider& obj);
+	bool IntersectBounds(Collider& coll);
+	void Search(Collider& obj, FrameVector<Collider*>& overlaps); // appends
 	SDL_Rect GetBounds() { return boundary; }
 	std::vector<Quadtree*> GetChilds();
 	bool GotChilds();
 	void DebugDrawBounds();
 	void Split();
 
-private:
-	
-	void Search(Collider& obj, std::vector<Collider*>& overlap);
-
 private:
 	int maxObjects;
 	int maxLevels;
@@ -10,15 +10,7 @@
 
 RangedUnit::RangedUnit(Gameobject* go) : B_Unit(go, UNIT_RANGED, IDLE, B_RANGED)
 {
-	//Stats
-	max_life = 100;
-	current_life = max_life;
-	atkTime = 2.0;
-	speed = 3;
-	damage = 15;
-	attack_range = 13.0f;
-	vision_range = 20.0f;
-	providesVisibility = true;
+	ResetStats();
 
 	CreatePanel();
 	selectionPanel->SetInactive();
@@ -32,11 +24,25 @@ RangedUnit::RangedUnit(Gameobject* go) : B_Unit(go, UNIT_RANGED, IDLE, B_RANGED)
 
 RangedUnit::~RangedUnit() {}
 
-void RangedUnit::UnitAttackType()
+void RangedUnit::ResetStats()
+{
+	//Stats
+	max_life = 100;
+	current_life = max_life;
+	atkTime = 2.0;
+	speed = 3;
+	damage = 15;
+	attack_range = 13.0f;
+	vision_range = 20.0f;
+	providesVisibility = true;
+}
+
+bool RangedUnit::UnitAttackType()
 {
 	attackPos = atkObj->GetPos();
-	App->particleSys.AddParticle(pos,attackPos,8.0f, ORANGE_PARTICLE);
+	App->particleSys.Launch(pos, atkObj, 8.0f, ORANGE_PARTICLE, damage, GetType());
 	audio->Play(attackFX);
+	return true;
 }
 
 void RangedUnit::CreatePanel()
@@ -12,7 +12,8 @@ class RangedUnit : public B_Unit
 public:
 	RangedUnit(Gameobject* go);
 	~RangedUnit();
-	void UnitAttackType() override;
+	void ResetStats() override;
+	bool UnitAttackType() override;
 	void CreatePanel() override;
 
 public:
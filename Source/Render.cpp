@@ -10,14 +10,34 @@
 #include "JuicyMath.h"
 #include "Defs.h"
 #include "Log.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "Counters.h"
 #include "Scene.h"
 
 #include "optick-1.3.0.0/include/optick.h"
 #include "SDL2_image-2.0.5/include/SDL_image.h"
 
+#include <limits.h>
+
 std::pair<float, float> Render::target_res = { 1280.f, 720.f };
 std::pair<float, float> Render::res_ratio;
 
+static Counter* draw_count[MAX_LAYERS] = {
+	Counters::Find("render/draws/background", COUNTER_GAUGE),
+	Counters::Find("render/draws/map", COUNTER_GAUGE),
+	Counters::Find("render/draws/walkability", COUNTER_GAUGE),
+	Counters::Find("render/draws/debug map", COUNTER_GAUGE),
+	Counters::Find("render/draws/back scene", COUNTER_GAUGE),
+	Counters::Find("render/draws/scene", COUNTER_GAUGE),
+	Counters::Find("render/draws/front scene", COUNTER_GAUGE),
+	Counters::Find("render/draws/fog of war", COUNTER_GAUGE),
+	Counters::Find("render/draws/debug scene", COUNTER_GAUGE),
+	Counters::Find("render/draws/hud", COUNTER_GAUGE),
+	Counters::Find("render/draws/editor", COUNTER_GAUGE),
+	Counters::Find("render/draws/fade", COUNTER_GAUGE),
+	Counters::Find("render/draws/cursor", COUNTER_GAUGE) };
+
 Render::Render() : Module("renderer")
 {
 	SetBackgroundColor({ 0, 0, 0, 255 });
@@ -66,6 +86,9 @@ bool Render::Init()
 	if (vsync) flags |= SDL_RENDERER_PRESENTVSYNC;
 	if (target_texture) flags |= SDL_RENDERER_TARGETTEXTURE;
 
+	// Keep SDL's command batching when a render driver is forced (headless runs)
+	SDL_SetHint(SDL_HINT_RENDER_BATCHING, "1");
+
 	// Create SDL rendering context
 	renderer = SDL_CreateRenderer(App->win->GetWindow(), -1, flags);
 	if (renderer)
@@ -177,23 +200,29 @@ void Render::MoveCamera(float x,float y)
 
 bool Render::PostUpdate()
 {
+	MemoryScope mem(MEM_RENDER);
+	PROFILE_SCOPE("Render");
+
 	bool ret = true;
 
 	// Render by layers
 	for (int i = 0; i < MAX_LAYERS; ++i)
 	{
+		unsigned int draws = 0u;
 		for (std::map<int, std::vector<RenderData>>::const_iterator it = layers[i].cbegin(); it != layers[i].cend() && ret; ++it)
 		{
 			// TODO: Check if map layers need sorting
 			for (std::vector<RenderData>::const_iterator data = it->second.cbegin(); data != it->second.cend() && ret; ++data)
 			{						
+				draws += (data->type == RenderData::TEXTURE_BATCH ? data->extra.batch.count : 1u);
+
 				switch (data->type)
 				{
 				case RenderData::TEXTURE_FULL:
 				{
 					if (data->texture != nullptr)
 						if (!(ret = SDL_RenderCopy(renderer, data->texture, nullptr, &data->rect) == 0))
-							LOG("Cannot blit texture to screen. SDL_RenderCopy error: %s", SDL_GetError());
+							LOG_WARNING("Cannot blit texture to screen. SDL_RenderCopy error: %s", SDL_GetError());
 
 					break;
 				}
@@ -201,7 +230,16 @@ bool Render::PostUpdate()
 				{
 					if (data->texture != nullptr)
 						if (!(ret = SDL_RenderCopy(renderer, data->texture, &data->extra.section, &data->rect) == 0))
-							LOG("Cannot blit texture section to screen. SDL_RenderCopy error: %s", SDL_GetError());
+							LOG_WARNING("Cannot blit texture section to screen. SDL_RenderCopy error: %s", SDL_GetError());
+
+					break;
+				}
+				case RenderData::TEXTURE_BATCH:
+				{
+					const unsigned int end = data->extra.batch.first + data->extra.batch.count;
+					for (unsigned int i = data->extra.batch.first; i < end && ret; ++i)
+						if (!(ret = SDL_RenderCopy(renderer, data->texture, &batch_sections[i], &batch_rects[i]) == 0))
+							LOG_WARNING("Cannot blit texture batch to screen. SDL_RenderCopy error: %s", SDL_GetError());
 
 					break;
 				}
@@ -209,7 +247,7 @@ bool Render::PostUpdate()
 				{
 					SetDrawColor(data->extra.color);
 					if (!(ret = (SDL_RenderFillRect(renderer, &data->rect) == 0)))
-						LOG("Cannot draw filled rect. SDL_RenderFillRect error: %s", SDL_GetError());
+						LOG_WARNING("Cannot draw filled rect. SDL_RenderFillRect error: %s", SDL_GetError());
 
 					break;
 				}
@@ -217,14 +255,14 @@ bool Render::PostUpdate()
 				{
 					SetDrawColor(data->extra.color);
 					if (!(ret = (SDL_RenderDrawRect(renderer, &data->rect) == 0)))
-						LOG("Cannot draw empty rect. SDL_RenderFillRect error: %s", SDL_GetError());
+						LOG_WARNING("Cannot draw empty rect. SDL_RenderFillRect error: %s", SDL_GetError());
 					break;
 				}
 				case RenderData::LINE:
 				{
 					SetDrawColor(data->extra.color);
 					if (!(ret = (SDL_RenderDrawLine(renderer, data->rect.x, data->rect.y, data->rect.w, data->rect.h) == 0)))
-						LOG("Cannot draw line. SDL_RenderDrawLine error: %s", SDL_GetError());
+						LOG_WARNING("Cannot draw line. SDL_RenderDrawLine error: %s", SDL_GetError());
 
 					break;
 				}
@@ -241,7 +279,7 @@ bool Render::PostUpdate()
 						}
 
 						if (!(ret = (SDL_RenderDrawPoints(renderer, points, 360) == 0)))
-							LOG("Cannot draw circle. SDL_RenderDrawPoints error: %s", SDL_GetError());
+							LOG_WARNING("Cannot draw circle. SDL_RenderDrawPoints error: %s", SDL_GetError());
 					}
 
 					break;
@@ -252,12 +290,17 @@ bool Render::PostUpdate()
 				
 			}
 		}
+
+		draw_count[i]->Set(draws);
 	}
 
 	for (int i = 0; i < MAX_LAYERS; ++i)
 		for (std::map<int, std::vector<RenderData>>::iterator it = layers[i].begin(); it != layers[i].end(); ++it)
 			it->second.clear();
 
+	batch_sections.clear();
+	batch_rects.clear();
+
 	SDL_Rect r = { 0,0,32,32 };
 	int x, y;
 	App->input->GetMousePosition(x,y);
@@ -384,7 +427,7 @@ bool Render::SetDrawColor(SDL_Color color)
 		color.a != draw_color.a)
 	{
 		if (!(ret = (SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a) == 0)))
-			LOG("Cannot set Render Draw Color. SDL_SetRenderDrawColor error: %s", SDL_GetError());
+			LOG_WARNING("Cannot set Render Draw Color. SDL_SetRenderDrawColor error: %s", SDL_GetError());
 	}
 
 	return ret;
@@ -421,18 +464,32 @@ bool Render::RenderMinimapFoW(float progress)
 				needs_clear = true;
 			}
 
-			for (int x = 0; x < rows_to_render; ++x)
+			// Fogged tile rects are built per row on the job workers, filled here
+			if (int(minimap_rows.size()) < rows_to_render)
+				minimap_rows.resize(rows_to_render);
+
+			int first_row = last_row;
+			App->jobs.ParallelFor("Minimap FoW Rows", (unsigned int)rows_to_render, MINIMAP_ROWS_PER_JOB, [&](unsigned int first, unsigned int last)
 			{
-				for (int y = 0; y < map_size.second; ++y)
+				for (unsigned int x = first; x < last; ++x)
 				{
-					if (!FogOfWarManager::fogMap[x + last_row][y])
+					std::vector<SDL_Rect>& rects = minimap_rows[x];
+					rects.clear();
+
+					for (int y = 0; y < map_size.second; ++y)
 					{
-						std::pair<int, int> pos = Map::I_MapToWorld(x + last_row, y);
-						SDL_Rect rect = { pos.first + minimap_half_width, pos.second, tile_size.first, tile_size.second };
-						SDL_RenderFillRect(renderer, &rect);
+						if (!FogOfWarManager::fogMap[x + first_row][y])
+						{
+							std::pair<int, int> pos = Map::I_MapToWorld(x + first_row, y);
+							rects.push_back({ pos.first + minimap_half_width, pos.second, tile_size.first, tile_size.second });
+						}
 					}
 				}
-			}
+			});
+
+			for (int x = 0; x < rows_to_render; ++x)
+				if (!minimap_rows[x].empty())
+					SDL_RenderFillRects(renderer, &minimap_rows[x].front(), int(minimap_rows[x].size()));
 
 			if (needs_clear)
 			{
@@ -458,6 +515,8 @@ bool Render::RenderMinimapFoW(float progress)
 
 inline void Render::AddToLayer(Layer layer, const RenderData& data)
 {
+	MemoryScope mem(MEM_RENDER);
+
 	int pos = 0;
 
 	if (layer < Layer::HUD && layer > Layer::DEBUG_MAP)
@@ -572,7 +631,7 @@ bool Render::Blit(int texture_id, int x, int y, const SDL_Rect* section, Layer l
 		AddToLayer(layer, data);
 	}
 	else
-		LOG("Cannot blit to screen. Invalid id %d", texture_id);
+		LOG_WARNING("Cannot blit to screen. Invalid id %d", texture_id);
 
 	return ret;
 }
@@ -619,7 +678,51 @@ bool Render::Blit_Scale(int texture_id, int x, int y, float scale_x, float scale
 		AddToLayer(layer, data);
 	}
 	else
-		LOG("Cannot blit to screen. Invalid id %d", texture_id);
+		LOG_WARNING("Cannot blit to screen. Invalid id %d", texture_id);
+
+	return ret;
+}
+
+bool Render::BlitBatch(int texture_id, const SDL_Rect* sections, const SDL_Rect* rects, unsigned int count, Layer layer, bool use_cam)
+{
+	bool ret;
+	RenderData data(RenderData::TEXTURE_BATCH);
+	data.texture = App->tex.GetTexture(texture_id);
+	data.camera = use_cam;
+
+	if (ret = (data.texture != nullptr))
+	{
+		if (count == 0u)
+			return ret;
+
+		data.extra.batch.first = batch_rects.size();
+		data.extra.batch.count = count;
+
+		// Bounds sort the whole batch inside its layer
+		int top = INT_MAX, bottom = INT_MIN;
+		for (unsigned int i = 0u; i < count; ++i)
+		{
+			SDL_Rect rect = rects[i];
+			if (use_cam)
+			{
+				rect.x -= int(cam.x);
+				rect.y -= int(cam.y);
+				rect.w = int(float(rect.w) * zoom);
+				rect.h = int(float(rect.h) * zoom);
+			}
+
+			if (rect.y < top) top = rect.y;
+			if (rect.y + rect.h > bottom) bottom = rect.y + rect.h;
+
+			batch_sections.push_back(sections[i]);
+			batch_rects.push_back(rect);
+		}
+
+		data.rect = { 0, top, 0, bottom - top };
+		AddToLayer(layer, data);
+	}
+	else
+		LOG_WARNING("Cannot blit batch to screen. Invalid id %d", texture_id);
 
 	return ret;
 }
@@ -644,7 +747,7 @@ bool Render::BlitNorm(int texture_id, RectF rect, const SDL_Rect* section, Layer
 		AddToLayer(layer, data);
 	}
 	else
-		LOG("Cannot blit to screen. Invalid id %d", texture_id);
+		LOG_WARNING("Cannot blit to screen. Invalid id %d", texture_id);
 
 	return ret;
 }
@@ -669,10 +772,10 @@ bool Render::Blit_Text(RenderedText* rendered_text, int x, int y, Layer layer, b
 			AddToLayer(layer, data);
 		}
 		else
-			LOG("Cannot blit text. Invalid text size");
+			LOG_WARNING("Cannot blit text. Invalid text size");
 	}
 	else
-		LOG("Cannot blit text. Invalid RenderedText");
+		LOG_WARNING("Cannot blit text. Invalid RenderedText");
 
 	return ret;
 }
@@ -695,7 +798,7 @@ bool Render::Blit_TextSized(RenderedText* rendered_text, SDL_Rect size, Layer la
 		AddToLayer(layer, data);
 	}
 	else
-		LOG("Cannot blit text. Invalid RenderedText");
+		LOG_WARNING("Cannot blit text. Invalid RenderedText");
 
 	return ret;
 }
@@ -772,15 +875,3 @@ Render::RenderData::RenderData(Type t) :
 {
 	extra.section = rect;
 }
-
-Render::RenderData::RenderData(const RenderData& copy) :
-	type(copy.type),
-	texture(copy.texture),
-	rect(copy.rect),
-	camera(copy.camera)
-{
-	if (type <= TEXTURE_SECTION)
-		extra.section = copy.extra.section;
-	else if (type > TEXTURE_SECTION)
-		extra.color = copy.extra.color;
-}
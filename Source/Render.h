@@ -9,6 +9,8 @@
 #include <map>
 #include <vector>
 
+#define MINIMAP_ROWS_PER_JOB 8u
+
 class Sprite;
 class RenderedText;
 struct SDL_Renderer;
@@ -75,6 +77,10 @@ public:
 	bool Blit_Scale(int texture_id, int x, int y, float scale_x, float scale_y, const SDL_Rect* section = nullptr, Layer layer = SCENE, bool use_cam = true);
 	bool BlitNorm(int texture_id, const RectF rect, const SDL_Rect* section = nullptr, Layer layer = SCENE);
 
+	// One layer entry for count sections of the same texture, rects in world space.
+	// Copies are submitted back to back so SDL merges them into a single draw call
+	bool BlitBatch(int texture_id, const SDL_Rect* sections, const SDL_Rect* rects, unsigned int count, Layer layer = SCENE, bool use_cam = true);
+
 	bool BlitMapTile(int texture_id, int x, int y, const SDL_Rect* section = nullptr, Layer layer = SCENE, bool use_cam = true);
 
 	bool Blit_Text(RenderedText* rendered_text, int x, int y, Layer layer = SCENE, bool use_cam = true);
@@ -120,6 +126,7 @@ private:
 		{
 			TEXTURE_FULL,
 			TEXTURE_SECTION,
+			TEXTURE_BATCH,
 			QUAD_FILLED,
 			QUAD_EMPTY,
 			LINE,
@@ -127,8 +134,7 @@ private:
 			MAX_TYPES
 		} type;
 
-		RenderData(Type type);
-		RenderData(const RenderData& copy);
+		RenderData(Type type); // trivially copied into the layers
 
 		SDL_Texture* texture;
 		SDL_Rect rect;
@@ -138,16 +144,23 @@ private:
 		{
 			SDL_Rect section;
 			SDL_Color color;
+			struct BatchRange
+			{
+				unsigned int first, count;
+			} batch;
 		} extra;
 	};
 
 	std::map<int, std::vector<RenderData>> layers[MAX_LAYERS];
+	std::vector<SDL_Rect> batch_sections; // TEXTURE_BATCH ranges, cleared with the layers
+	std::vector<SDL_Rect> batch_rects;
 
 	// Minimap
 	float minimap_scale = 1.0f;
 	int minimap_texture[2] = { -1, -1 };
 	int last_row = 0;
 	bool current_texture = false;
+	std::vector<std::vector<SDL_Rect>> minimap_rows;
 	bool needs_clear = true;
 
 	// Config
@@ -24,9 +24,9 @@
 #ifndef SDL_IMAGE_H_
 #define SDL_IMAGE_H_
 
-#include "..\..\SDL\include\SDL.h"
-#include "..\..\SDL\include\SDL_version.h"
-#include "..\..\SDL\include\begin_code.h"
+#include "../../SDL/include/SDL.h"
+#include "../../SDL/include/SDL_version.h"
+#include "../../SDL/include/begin_code.h"
 
 /* Set up for C function definitions, even when using C++ */
 #ifdef __cplusplus
@@ -156,6 +156,6 @@ extern DECLSPEC int SDLCALL IMG_SaveJPG_RW(SDL_Surface *surface, SDL_RWops *dst,
 #ifdef __cplusplus
 }
 #endif
-#include "..\..\SDL\include\close_code.h"
+#include "../../SDL/include/close_code.h"
 
 #endif /* SDL_IMAGE_H_ */
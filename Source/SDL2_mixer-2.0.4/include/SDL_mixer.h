@@ -22,12 +22,12 @@
 #ifndef SDL_MIXER_H_
 #define SDL_MIXER_H_
 
-#include "..\..\SDL\include\SDL_stdinc.h"
-#include "..\..\SDL\include\SDL_rwops.h"
-#include "..\..\SDL\include\SDL_audio.h"
-#include "..\..\SDL\include\SDL_endian.h"
-#include "..\..\SDL\include\SDL_version.h"
-#include "..\..\SDL\include\begin_code.h"
+#include "../../SDL/include/SDL_stdinc.h"
+#include "../../SDL/include/SDL_rwops.h"
+#include "../../SDL/include/SDL_audio.h"
+#include "../../SDL/include/SDL_endian.h"
+#include "../../SDL/include/SDL_version.h"
+#include "../../SDL/include/begin_code.h"
 
 /* Set up for C function definitions, even when using C++ */
 #ifdef __cplusplus
@@ -644,7 +644,7 @@ extern DECLSPEC void SDLCALL Mix_CloseAudio(void);
 #ifdef __cplusplus
 }
 #endif
-#include "..\..\SDL\include\close_code.h"
+#include "../../SDL/include/close_code.h"
 
 #endif /* SDL_MIXER_H_ */
 
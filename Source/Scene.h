@@ -7,6 +7,8 @@
 #include "Point.h"
 #include "Canvas.h"
 #include "Minimap.h"
+#include "SystemScheduler.h"
+#include "JobSystem.h"
 
 
 #include <vector>
@@ -26,6 +28,12 @@
 #define RANGED_UPGRADE_COST 50
 #define SUPER_UPGRADE_COST 60
 
+#define SAVE_FILE "save_file.bin"
+#define SAVE_FILE_XML "save_file.xml"	// debug export, also written while in god mode
+#define SAVE_MAGIC 0x5641534A			// "JSAV"
+#define SAVE_VERSION 2					// 1 was deflated, still read
+#define SAVE_MAX_INFLATE_RATIO 64u		// a version 1 header claiming more raw bytes per compressed one is corrupt
+
 enum SceneType : int
 {
 	EMPTY,
@@ -127,6 +135,7 @@ struct Mission
 struct SDL_Texture;
 class Transform;
 class Sprite;
+class Behaviour;
 
 class Scene : public Module
 {
@@ -138,6 +147,7 @@ public:
 	bool Start() override;
 	bool PreUpdate() override;
 	bool Update() override;
+	bool FixedUpdate() override;
 	bool PostUpdate() override;
 	bool CleanUp() override;
 
@@ -161,6 +171,7 @@ public:
 	// Scene Serialization
 	void SaveGameNow();
 	void LoadGameNow();
+	unsigned int WaitForSave(); // bytes the pending save wrote, 0 if none or it failed
 
 private:
 
@@ -192,12 +203,21 @@ private:
 	bool OnMainScene() const;
 	inline bool SaveFileExists() const;
 
+	// Binary snapshot: captured on the main thread, written by a job
+	void FinishSave();
+	bool ReadSnapshot(std::string& raw) const;
+	void LoadSnapshot(ByteReader& in);
+	void ExportSaveXML() const;
+	void LoadSaveXML(pugi::xml_node& scene_node);
+
 public:
 
 	// Selection
 	iPoint groupStart,mouseExtend;
 	bool groupSelect;
 	std::vector<Gameobject*> group;
+	std::vector<Behaviour*> selection_buffer; // reused by spatial selection queries
+	std::vector<Behaviour*> order_buffer; // alive members of a group order
 	Gameobject* selection = nullptr;
 	GameplayState current_state;
 
@@ -213,6 +233,7 @@ public:
 private:
 
 	Gameobject root;
+	SystemScheduler systems;
 	Map map;
 
 	// God Mode
@@ -248,6 +269,12 @@ private:
 	C_Button* save = nullptr;
 	C_Button* load = nullptr;
 
+	// Save
+	std::string snapshot;
+	JobHandle save_job;
+	unsigned int saved_bytes = 0u;	// written by save_job
+	std::string save_error;			// written by save_job
+
 	// Player
 	C_Text* hud_texts[MAX_PLAYER_STATS];
 	static int player_stats[MAX_PLAYER_STATS];
@@ -308,7 +335,7 @@ private:
 	C_Button* next;
 	C_Button* skip;
 	C_Button* not_inactive;
-	C_Image * not;
+	C_Image * not_image;
 
 	bool first_time_pause_button;
 	bool paused_yet = false;
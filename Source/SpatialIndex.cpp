@@ -0,0 +1,390 @@
+#include "SpatialIndex.h"
+#include "Behaviour.h"
+#include "Gameobject.h"
+#include "Transform.h"
+#include "Map.h"
+
+#include "optick-1.3.0.0/include/optick.h"
+
+#include <algorithm>
+#include <math.h>
+
+SpatialIndex::SpatialIndex()
+{}
+
+SpatialIndex::~SpatialIndex()
+{}
+
+void SpatialIndex::Update()
+{
+	OPTICK_EVENT();
+
+	std::pair<int, int> size = Map::GetMapSize_I();
+	if (size.first != map_width || size.second != map_height)
+		Resize(size.first, size.second);
+
+	if (cells.empty())
+		return;
+
+	for (std::vector<Behaviour*>::iterator it = Behaviour::b_list.begin(); it != Behaviour::b_list.end(); ++it)
+	{
+		int cell = CellIndex((*it)->GetGameobject()->GetTransform()->GetGlobalPosition());
+		if (cell != (*it)->spatial_cell)
+		{
+			RemoveFromCell(*it);
+			Insert(*it, cell);
+		}
+	}
+}
+
+void SpatialIndex::Remove(Behaviour* b)
+{
+	RemoveFromCell(b);
+}
+
+void SpatialIndex::Clear()
+{
+	Resize(0, 0);
+}
+
+unsigned int SpatialIndex::QueryRadius(vec center, float radius, std::vector<Behaviour*>& out, const SpatialFilter& filter) const
+{
+	unsigned int ret = 0u;
+	int first_col, first_row, last_col, last_row;
+	CellRange(center.x - radius, center.y - radius, center.x + radius, center.y + radius, first_col, first_row, last_col, last_row);
+
+	float sqr_radius = radius * radius;
+	for (int row = first_row; row <= last_row; ++row)
+	{
+		for (int col = first_col; col <= last_col; ++col)
+		{
+			const Cell& cell = cells[row * columns + col];
+			if (CellAccepts(cell, filter))
+			{
+				for (std::vector<Behaviour*>::const_iterator it = cell.units.cbegin(); it != cell.units.cend(); ++it)
+				{
+					if (Accepts(*it, filter))
+					{
+						vec pos = (*it)->GetGameobject()->GetTransform()->GetGlobalPosition();
+						float dx = pos.x - center.x;
+						float dy = pos.y - center.y;
+						if (dx * dx + dy * dy < sqr_radius)
+						{
+							out.push_back(*it);
+							ret++;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return ret;
+}
+
+unsigned int SpatialIndex::QueryNearest(vec center, unsigned int k, float max_radius, std::vector<Behaviour*>& out, const SpatialFilter& filter) const
+{
+	nearest.clear();
+
+	if (cells.empty() || k == 0u)
+		return 0u;
+
+	int center_cell = CellIndex(center);
+	int cx = center_cell % columns;
+	int cy = center_cell / columns;
+	int max_ring = columns > rows ? columns : rows;
+	float cell_size = float(SPATIAL_CELL_TILES);
+
+	// Expand square rings of cells until nothing closer can remain outside
+	for (int ring = 0; ring <= max_ring; ++ring)
+	{
+		if (ring > 0 && float(ring - 1) * cell_size > max_radius)
+			break;
+
+		for (int row = cy - ring; row <= cy + ring; ++row)
+		{
+			if (row < 0 || row >= rows)
+				continue;
+
+			bool edge_row = (row == cy - ring || row == cy + ring);
+			int step = (edge_row || ring == 0) ? 1 : ring * 2;
+
+			for (int col = cx - ring; col <= cx + ring; col += step)
+			{
+				if (col < 0 || col >= columns)
+					continue;
+
+				const Cell& cell = cells[row * columns + col];
+				if (CellAccepts(cell, filter))
+				{
+					for (std::vector<Behaviour*>::const_iterator it = cell.units.cbegin(); it != cell.units.cend(); ++it)
+					{
+						if (Accepts(*it, filter))
+						{
+							vec pos = (*it)->GetGameobject()->GetTransform()->GetGlobalPosition();
+							float d = sqrtf((pos.x - center.x) * (pos.x - center.x) + (pos.y - center.y) * (pos.y - center.y));
+							if (d <= max_radius)
+								nearest.push_back({ d, *it });
+						}
+					}
+				}
+			}
+		}
+
+		if (nearest.size() >= k)
+		{
+			std::nth_element(nearest.begin(), nearest.begin() + (k - 1u), nearest.end());
+			if (nearest[k - 1u].first <= float(ring) * cell_size)
+				break;
+		}
+	}
+
+	unsigned int found = nearest.size() < k ? (unsigned int)nearest.size() : k;
+	std::partial_sort(nearest.begin(), nearest.begin() + found, nearest.end());
+
+	for (unsigned int i = 0u; i < found; ++i)
+		out.push_back(nearest[i].second);
+
+	return found;
+}
+
+unsigned int SpatialIndex::QueryRect(const RectF& map_rect, std::vector<Behaviour*>& out, const SpatialFilter& filter) const
+{
+	unsigned int ret = 0u;
+
+	float min_x = map_rect.w < 0.f ? map_rect.x + map_rect.w : map_rect.x;
+	float min_y = map_rect.h < 0.f ? map_rect.y + map_rect.h : map_rect.y;
+	float max_x = min_x + fabsf(map_rect.w);
+	float max_y = min_y + fabsf(map_rect.h);
+
+	int first_col, first_row, last_col, last_row;
+	CellRange(min_x, min_y, max_x, max_y, first_col, first_row, last_col, last_row);
+
+	for (int row = first_row; row <= last_row; ++row)
+	{
+		for (int col = first_col; col <= last_col; ++col)
+		{
+			const Cell& cell = cells[row * columns + col];
+			if (CellAccepts(cell, filter))
+			{
+				for (std::vector<Behaviour*>::const_iterator it = cell.units.cbegin(); it != cell.units.cend(); ++it)
+				{
+					if (Accepts(*it, filter))
+					{
+						vec pos = (*it)->GetGameobject()->GetTransform()->GetGlobalPosition();
+						if (pos.x >= min_x && pos.x <= max_x && pos.y >= min_y && pos.y <= max_y)
+						{
+							out.push_back(*it);
+							ret++;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return ret;
+}
+
+unsigned int SpatialIndex::QueryWorldRect(const RectF& world_rect, std::vector<Behaviour*>& out, const SpatialFilter& filter) const
+{
+	unsigned int ret = 0u;
+
+	float left = world_rect.w < 0.f ? world_rect.x + world_rect.w : world_rect.x;
+	float top = world_rect.h < 0.f ? world_rect.y + world_rect.h : world_rect.y;
+	float right = left + fabsf(world_rect.w);
+	float bottom = top + fabsf(world_rect.h);
+
+	// Screen rects are diamonds over the isometric map: bound their 4 corners
+	std::pair<float, float> corners[4] =
+	{
+		Map::F_WorldToMap(left, top),
+		Map::F_WorldToMap(right, top),
+		Map::F_WorldToMap(left, bottom),
+		Map::F_WorldToMap(right, bottom)
+	};
+
+	float min_x = corners[0].first, max_x = corners[0].first;
+	float min_y = corners[0].second, max_y = corners[0].second;
+	for (int i = 1; i < 4; ++i)
+	{
+		min_x = std::min(min_x, corners[i].first);
+		max_x = std::max(max_x, corners[i].first);
+		min_y = std::min(min_y, corners[i].second);
+		max_y = std::max(max_y, corners[i].second);
+	}
+
+	int first_col, first_row, last_col, last_row;
+	CellRange(min_x - 1.f, min_y - 1.f, max_x + 1.f, max_y + 1.f, first_col, first_row, last_col, last_row);
+
+	for (int row = first_row; row <= last_row; ++row)
+	{
+		for (int col = first_col; col <= last_col; ++col)
+		{
+			const Cell& cell = cells[row * columns + col];
+			if (CellAccepts(cell, filter))
+			{
+				for (std::vector<Behaviour*>::const_iterator it = cell.units.cbegin(); it != cell.units.cend(); ++it)
+				{
+					if (Accepts(*it, filter))
+					{
+						std::pair<float, float> world_pos = Map::F_MapToWorld((*it)->GetGameobject()->GetTransform()->GetGlobalPosition());
+						if (world_pos.first > left && world_pos.first < right && world_pos.second > top && world_pos.second < bottom)
+						{
+							out.push_back(*it);
+							ret++;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return ret;
+}
+
+Behaviour* SpatialIndex::Pick(float world_x, float world_y, const SpatialFilter& filter) const
+{
+	Behaviour* ret = nullptr;
+
+	std::pair<float, float> map_pos = Map::F_WorldToMap(world_x, world_y);
+	vec center(map_pos.first, map_pos.second, 0.f);
+
+	int first_col, first_row, last_col, last_row;
+	CellRange(center.x - SPATIAL_PICK_RADIUS, center.y - SPATIAL_PICK_RADIUS, center.x + SPATIAL_PICK_RADIUS, center.y + SPATIAL_PICK_RADIUS, first_col, first_row, last_col, last_row);
+
+	float closest = -1.f;
+	for (int row = first_row; row <= last_row; ++row)
+	{
+		for (int col = first_col; col <= last_col; ++col)
+		{
+			const Cell& cell = cells[row * columns + col];
+			if (CellAccepts(cell, filter))
+			{
+				for (std::vector<Behaviour*>::const_iterator it = cell.units.cbegin(); it != cell.units.cend(); ++it)
+				{
+					if (Accepts(*it, filter))
+					{
+						RectF rect = (*it)->GetSelectionRect();
+						if (world_x > rect.x && world_x < rect.x + rect.w && world_y > rect.y && world_y < rect.y + rect.h)
+						{
+							vec pos = (*it)->GetGameobject()->GetTransform()->GetGlobalPosition();
+							float d = (pos.x - center.x) * (pos.x - center.x) + (pos.y - center.y) * (pos.y - center.y);
+							if (ret == nullptr || d < closest)
+							{
+								ret = *it;
+								closest = d;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return ret;
+}
+
+Faction SpatialIndex::GetFaction(UnitType type)
+{
+	switch (type)
+	{
+	case GATHERER:
+	case UNIT_MELEE:
+	case UNIT_RANGED:
+	case UNIT_SUPER:
+	case BASE_CENTER:
+	case TOWER:
+	case BARRACKS:
+	case LAB:
+		return PLAYER_FACTION;
+	case ENEMY_MELEE:
+	case ENEMY_RANGED:
+	case ENEMY_SUPER:
+	case SPAWNER:
+		return ENEMY_FACTION;
+	default:
+		return NEUTRAL_FACTION;
+	}
+}
+
+void SpatialIndex::Resize(int width, int height)
+{
+	cells.clear();
+	map_width = width;
+	map_height = height;
+	columns = width > 0 ? (width + SPATIAL_CELL_TILES - 1) / SPATIAL_CELL_TILES : 0;
+	rows = height > 0 ? (height + SPATIAL_CELL_TILES - 1) / SPATIAL_CELL_TILES : 0;
+	cells.resize(columns * rows);
+
+	for (std::vector<Behaviour*>::iterator it = Behaviour::b_list.begin(); it != Behaviour::b_list.end(); ++it)
+		(*it)->spatial_cell = (*it)->spatial_slot = -1;
+}
+
+int SpatialIndex::CellIndex(const vec& pos) const
+{
+	int col = int(floorf(pos.x / float(SPATIAL_CELL_TILES)));
+	int row = int(floorf(pos.y / float(SPATIAL_CELL_TILES)));
+
+	col = col < 0 ? 0 : (col >= columns ? columns - 1 : col);
+	row = row < 0 ? 0 : (row >= rows ? rows - 1 : row);
+
+	return row * columns + col;
+}
+
+void SpatialIndex::Insert(Behaviour* b, int cell)
+{
+	Cell& c = cells[cell];
+	b->spatial_cell = cell;
+	b->spatial_slot = int(c.units.size());
+	c.units.push_back(b);
+	c.types |= UNIT_TYPE_MASK(b->GetType());
+}
+
+void SpatialIndex::RemoveFromCell(Behaviour* b)
+{
+	if (b->spatial_cell >= 0 && b->spatial_cell < int(cells.size()))
+	{
+		Cell& c = cells[b->spatial_cell];
+		Behaviour* last = c.units.back();
+		c.units[b->spatial_slot] = last;
+		last->spatial_slot = b->spatial_slot;
+		c.units.pop_back();
+
+		c.types = 0u;
+		for (std::vector<Behaviour*>::const_iterator it = c.units.cbegin(); it != c.units.cend(); ++it)
+			c.types |= UNIT_TYPE_MASK((*it)->GetType());
+	}
+
+	b->spatial_cell = b->spatial_slot = -1;
+}
+
+bool SpatialIndex::CellAccepts(const Cell& cell, const SpatialFilter& filter) const
+{
+	return (cell.types & filter.types) != 0u;
+}
+
+bool SpatialIndex::Accepts(const Behaviour* b, const SpatialFilter& filter) const
+{
+	UnitType type = b->GetType();
+	return b != filter.exclude
+		&& (UNIT_TYPE_MASK(type) & filter.types) != 0u
+		&& (FACTION_MASK(GetFaction(type)) & filter.factions) != 0;
+}
+
+void SpatialIndex::CellRange(float min_x, float min_y, float max_x, float max_y, int& first_col, int& first_row, int& last_col, int& last_row) const
+{
+	// Empty range (first > last) when there is no grid
+	first_col = first_row = 0;
+	last_col = last_row = -1;
+
+	if (!cells.empty())
+	{
+		int first = CellIndex(vec(min_x, min_y, 0.f));
+		int last = CellIndex(vec(max_x, max_y, 0.f));
+		first_col = first % columns;
+		first_row = first / columns;
+		last_col = last % columns;
+		last_row = last / columns;
+	}
+}
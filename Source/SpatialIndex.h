@@ -0,0 +1,93 @@
+#ifndef __SPATIAL_INDEX_H__
+#define __SPATIAL_INDEX_H__
+
+#include "Vector3.h"
+#include "SDL/include/SDL_rect.h"
+
+#include <vector>
+#include <utility>
+
+#define SPATIAL_CELL_TILES 4		// cell side in map tiles
+#define SPATIAL_PICK_RADIUS 8.f		// tiles searched around a click for selection rects
+
+#define UNIT_TYPE_MASK(t) (1u << (t))
+#define ALL_UNIT_TYPES 0xffffffffu
+
+#define FACTION_MASK(f) (1 << (f))
+#define ALL_FACTIONS 0xff
+
+class Behaviour;
+enum UnitType : int;
+
+enum Faction : int
+{
+	NEUTRAL_FACTION,
+	PLAYER_FACTION,
+	ENEMY_FACTION,
+	MAX_FACTIONS
+};
+
+struct SpatialFilter
+{
+	SpatialFilter(unsigned int types = ALL_UNIT_TYPES, int factions = ALL_FACTIONS, const Behaviour* exclude = nullptr) :
+		types(types), factions(factions), exclude(exclude)
+	{}
+
+	unsigned int types;			// UNIT_TYPE_MASK bits
+	int factions;				// FACTION_MASK bits
+	const Behaviour* exclude;
+};
+
+// Uniform grid over map tiles bucketing every Behaviour by its position.
+// Update re-buckets only the ones that changed cell. Queries append to a
+// caller-owned buffer so it can be reused frame to frame.
+class SpatialIndex
+{
+public:
+
+	SpatialIndex();
+	~SpatialIndex();
+
+	void Update();
+	void Remove(Behaviour* b);
+	void Clear();
+
+	// Positions & radius in map tiles
+	unsigned int QueryRadius(vec center, float radius, std::vector<Behaviour*>& out, const SpatialFilter& filter = SpatialFilter()) const;
+	unsigned int QueryNearest(vec center, unsigned int k, float max_radius, std::vector<Behaviour*>& out, const SpatialFilter& filter = SpatialFilter()) const;
+	unsigned int QueryRect(const RectF& map_rect, std::vector<Behaviour*>& out, const SpatialFilter& filter = SpatialFilter()) const;
+
+	// World (screen + camera) space
+	unsigned int QueryWorldRect(const RectF& world_rect, std::vector<Behaviour*>& out, const SpatialFilter& filter = SpatialFilter()) const;
+	Behaviour* Pick(float world_x, float world_y, const SpatialFilter& filter = SpatialFilter()) const;
+
+	static Faction GetFaction(UnitType type);
+
+private:
+
+	struct Cell
+	{
+		std::vector<Behaviour*> units;
+		unsigned int types = 0u;	// union of the unit types inside
+	};
+
+	void Resize(int width, int height);
+	int CellIndex(const vec& pos) const;
+	void Insert(Behaviour* b, int cell);
+	void RemoveFromCell(Behaviour* b);
+	bool CellAccepts(const Cell& cell, const SpatialFilter& filter) const;
+	bool Accepts(const Behaviour* b, const SpatialFilter& filter) const;
+	void CellRange(float min_x, float min_y, float max_x, float max_y, int& first_col, int& first_row, int& last_col, int& last_row) const;
+
+private:
+
+	std::vector<Cell> cells;
+	int columns = 0;
+	int rows = 0;
+	int map_width = 0;
+	int map_height = 0;
+
+	mutable std::vector<std::pair<float, Behaviour*> > nearest; // QueryNearest scratch
+};
+
+#endif // __SPATIAL_INDEX_H__
@@ -79,7 +79,7 @@ void Spawner::Update()
 		}
 
 		ms_counter = 0;
-		std::srand(time(NULL));
+		std::srand(App->commands.Seed());
 	}
 
 	
@@ -34,7 +34,7 @@ void Sprite::PostUpdate()
 	Transform* t = game_object->GetTransform();
 	if (t)
 	{
-		vec pos = t->GetGlobalPosition();
+		vec pos = t->GetRenderPosition(App->time.GetInterpolationAlpha());
 		vec scale = t->GetGlobalScale();
 		std::pair<float, float> map_pos = Map::F_MapToWorld(pos.x, pos.y, pos.z);
 
@@ -83,6 +83,29 @@ void Sprite::PostUpdate()
 	}
 }
 
+bool Sprite::InsideCamera(const RectF& cam, float zoom) const
+{
+	const Transform* t = game_object->GetTransform();
+	if (t == nullptr)
+		return true;
+
+	vec pos = t->GetGlobalPosition();
+	vec scale = t->GetGlobalScale();
+	std::pair<float, float> map_pos = Map::F_MapToWorld(pos.x, pos.y, pos.z);
+
+	map_pos.first += offset.x * offset.w * scale.x;
+	map_pos.second += ((offset.y * offset.h) + Map::GetBaseOffset()) * scale.y;
+
+	// Same screen rect Blit_Scale builds, unzoomed quads are covered by zoom >= 1
+	if (zoom < 1.f) zoom = 1.f;
+	float x = map_pos.first - cam.x;
+	float y = map_pos.second - cam.y;
+	float w = float(section.w) * scale.x * offset.w * zoom;
+	float h = float(section.h) * scale.y * offset.h * zoom;
+
+	return !(x + w < 0.f || y + h < 0.f || x > cam.w || y > cam.h);
+}
+
 void Sprite::SetSection(const SDL_Rect s)
 {
 	section = s;
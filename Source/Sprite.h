@@ -18,6 +18,9 @@ public:
 
 	void PostUpdate() override;
 
+	// Read-only screen test, safe to run from job workers
+	bool InsideCamera(const RectF& cam, float zoom) const;
+
 	void SetSection(const SDL_Rect section);
 	void SetColor(const SDL_Color color);
 	float GetBuildEffectProgress() const;
@@ -12,7 +12,8 @@ class SuperUnit : public B_Unit
 public:
 	SuperUnit(Gameobject* go);
 	~SuperUnit();
-	void UnitAttackType() override;
+	void ResetStats() override;
+	bool UnitAttackType() override;
 	void CreatePanel() override;
 
 public:
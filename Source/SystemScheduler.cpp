@@ -0,0 +1,135 @@
+#include "SystemScheduler.h"
+#include "Application.h"
+#include "Render.h"
+#include "Sprite.h"
+#include "Transform.h"
+
+#include "optick-1.3.0.0/include/optick.h"
+
+SystemScheduler::SystemScheduler()
+{}
+
+SystemScheduler::~SystemScheduler()
+{}
+
+void SystemScheduler::PreUpdate(Gameobject& root)
+{
+	OPTICK_CATEGORY("Systems PreUpdate", Optick::Category::GameLogic);
+	RunPhase(PRE_UPDATE_PHASE, root);
+}
+
+void SystemScheduler::Update(Gameobject& root)
+{
+	OPTICK_CATEGORY("Systems Update", Optick::Category::GameLogic);
+	RunPhase(UPDATE_PHASE, root);
+}
+
+void SystemScheduler::PostUpdate(Gameobject& root)
+{
+	OPTICK_CATEGORY("Systems PostUpdate", Optick::Category::GameLogic);
+	RunPhase(POST_UPDATE_PHASE, root);
+}
+
+void SystemScheduler::FixedUpdate()
+{
+	OPTICK_CATEGORY("Systems FixedUpdate", Optick::Category::GameLogic);
+
+	// Keep last tick's positions for render interpolation
+	const std::vector<Component*>& transforms = Component::GetPool(TRANSFORM);
+	for (std::vector<Component*>::const_iterator it = transforms.cbegin(); it != transforms.cend(); ++it)
+		(*it)->AsTransform()->StoreRenderSnapshot();
+
+	RunSystems(PRE_UPDATE_PHASE);
+	RunSystems(UPDATE_PHASE);
+}
+
+void SystemScheduler::RunPhase(UpdatePhase phase, Gameobject& root)
+{
+	// Cache active state, process removals & run hierarchy-ordered UI
+	{
+		OPTICK_EVENT("Hierarchy");
+		Gameobject::BeginPass();
+		root.HierarchyPass(phase);
+	}
+
+	if (phase == POST_UPDATE_PHASE || !App->time.IsFixedTimestep())
+		RunSystems(phase);
+}
+
+void SystemScheduler::RunSystems(UpdatePhase phase)
+{
+	// Systems in phase order: transforms -> behaviours -> sprites
+	{
+		OPTICK_EVENT("Transforms");
+		RunSystem(phase, TRANSFORM, SPRITE);
+	}
+	{
+		OPTICK_EVENT("Behaviours");
+		RunSystem(phase, BEHAVIOUR, MAX_BEHAVIOUR);
+	}
+	{
+		OPTICK_EVENT("Sprites");
+		if (phase == POST_UPDATE_PHASE)
+		{
+			DrawSprites(SPRITE);
+			DrawSprites(ANIM_SPRITE);
+		}
+		else
+			RunSystem(phase, SPRITE, AUDIO_SOURCE);
+	}
+	{
+		OPTICK_EVENT("Particles");
+		RunSystem(phase, PARTICLE, UI_GENERAL);
+	}
+	{
+		OPTICK_EVENT("Audio Sources & Colliders");
+		RunSystem(phase, AUDIO_SOURCE, PARTICLE);
+	}
+}
+
+void SystemScheduler::RunSystem(UpdatePhase phase, ComponentType first, ComponentType last) const
+{
+	for (int type = first; type < last; ++type)
+	{
+		// Pool size is re-read: components may be added or swap-removed mid system
+		const std::vector<Component*>& pool = Component::GetPool(ComponentType(type));
+		for (unsigned int i = 0u; i < pool.size(); ++i)
+		{
+			Component* comp = pool[i];
+			if (comp->ActiveThisPass())
+			{
+				switch (phase)
+				{
+				case PRE_UPDATE_PHASE: comp->PreUpdate(); break;
+				case UPDATE_PHASE: comp->Update(); break;
+				case POST_UPDATE_PHASE: comp->PostUpdate(); break;
+				}
+			}
+		}
+	}
+}
+
+void SystemScheduler::DrawSprites(ComponentType type)
+{
+	const std::vector<Component*>& pool = Component::GetPool(type);
+	unsigned int count = (unsigned int)pool.size();
+
+	// Camera culling runs on the job workers, blits stay on the main thread
+	RectF cam = App->render->GetCameraRectF();
+	float zoom = App->render->GetZoom();
+	sprite_visible.assign(count, 1);
+
+	App->jobs.ParallelFor("Sprite Culling", count, SPRITE_CULL_BATCH_SIZE, [this, &pool, &cam, zoom](unsigned int first, unsigned int last)
+	{
+		for (unsigned int i = first; i < last; ++i)
+			if (pool[i]->ActiveThisPass())
+				sprite_visible[i] = static_cast<const Sprite*>(pool[i])->InsideCamera(cam, zoom);
+	});
+
+	for (unsigned int i = 0u; i < pool.size(); ++i)
+	{
+		Component* comp = pool[i];
+		if (comp->ActiveThisPass() && (i >= count || sprite_visible[i]))
+			comp->PostUpdate();
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef __SYSTEM_SCHEDULER_H__
+#define __SYSTEM_SCHEDULER_H__
+
+#include "Component.h"
+#include "Gameobject.h"
+
+#include <vector>
+
+#define SPRITE_CULL_BATCH_SIZE 256u
+
+// Runs each phase system by system over the dense component pools
+// instead of recursing through the gameobject tree per component.
+// With a fixed timestep the pre/update systems run from FixedUpdate
+// once per simulation tick, the hierarchy pass stays once per frame.
+class SystemScheduler
+{
+public:
+
+	SystemScheduler();
+	~SystemScheduler();
+
+	void PreUpdate(Gameobject& root);
+	void Update(Gameobject& root);
+	void PostUpdate(Gameobject& root);
+	void FixedUpdate();
+
+private:
+
+	void RunPhase(UpdatePhase phase, Gameobject& root);
+	void RunSystems(UpdatePhase phase);
+	void RunSystem(UpdatePhase phase, ComponentType first, ComponentType last) const;
+	void DrawSprites(ComponentType type);
+
+private:
+
+	std::vector<char> sprite_visible; // per pool index, filled by the culling jobs
+};
+
+#endif // __SYSTEM_SCHEDULER_H__
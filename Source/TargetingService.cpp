@@ -0,0 +1,101 @@
+#include "TargetingService.h"
+#include "Application.h"
+#include "Behaviour.h"
+#include "Gameobject.h"
+#include "Transform.h"
+
+#include "optick-1.3.0.0/include/optick.h"
+
+#include <math.h>
+
+TargetingService::TargetingService()
+{}
+
+TargetingService::~TargetingService()
+{}
+
+void TargetingService::Update()
+{
+	OPTICK_EVENT();
+
+	float dt = App->time.GetGameDeltaTime();
+	last_queries = 0u;
+
+	for (unsigned int i = 0u; i < Behaviour::b_list.size(); ++i)
+	{
+		Behaviour* b = Behaviour::b_list[i];
+		if (b->IsDestroyed())
+			continue;
+
+		// First sight: spread behaviours over the interval
+		if (b->retarget_timer < 0.f)
+			b->retarget_timer = TARGETING_INTERVAL * float(next_slice++ % TARGETING_SLICES) / float(TARGETING_SLICES);
+
+		b->retarget_timer -= dt;
+
+		if (b->retarget_timer <= 0.f || b->TargetLost())
+		{
+			b->AcquireTargets();
+			b->retarget_timer = TARGETING_INTERVAL;
+			last_queries++;
+		}
+	}
+}
+
+Behaviour* TargetingService::FindBest(const Behaviour* self, vec center, float range, const SpatialFilter& filter)
+{
+	Behaviour* ret = nullptr;
+	float best_score = 0.f;
+
+	candidates.clear();
+	SpatialFilter without_self = filter;
+	without_self.exclude = self;
+	App->spatial.QueryRadius(center, range * TARGETING_RANGE_TO_TILES, candidates, without_self);
+
+	for (std::vector<Behaviour*>::const_iterator it = candidates.cbegin(); it != candidates.cend(); ++it)
+	{
+		if (!(*it)->IsDestroyed())
+		{
+			vec pos = (*it)->GetGameobject()->GetTransform()->GetGlobalPosition();
+			float score = Score(*it, sqrtf((pos.x - center.x) * (pos.x - center.x) + (pos.y - center.y) * (pos.y - center.y)));
+
+			if (ret == nullptr || score < best_score)
+			{
+				ret = *it;
+				best_score = score;
+			}
+		}
+	}
+
+	return ret;
+}
+
+unsigned int TargetingService::GetLastQueries() const
+{
+	return last_queries;
+}
+
+float TargetingService::Score(const Behaviour* candidate, float distance) const
+{
+	float score = distance;
+
+	// Finish off wounded targets
+	if (candidate->max_life > 0)
+		score += TARGET_HP_WEIGHT * float(candidate->current_life) / float(candidate->max_life);
+
+	// Prefer units that fight back over structures
+	switch (candidate->GetType())
+	{
+	case BASE_CENTER:
+	case TOWER:
+	case BARRACKS:
+	case LAB:
+	case SPAWNER:
+		score += TARGET_BUILDING_PENALTY;
+		break;
+	default:
+		break;
+	}
+
+	return score;
+}
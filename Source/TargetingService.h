@@ -0,0 +1,44 @@
+#ifndef __TARGETING_SERVICE_H__
+#define __TARGETING_SERVICE_H__
+
+#include "SpatialIndex.h"
+
+#include <vector>
+
+#define TARGETING_INTERVAL 0.2f			// seconds between re-queries per behaviour
+#define TARGETING_SLICES 8				// initial offsets spreading queries across frames
+#define TARGETING_RANGE_TO_TILES 0.7f	// ranges used to size trigger rects spanning the range in tiles
+#define TARGET_HP_WEIGHT 2.f			// tiles added for a fully healthy target
+#define TARGET_BUILDING_PENALTY 3.f		// tiles added to buildings & spawners: units first
+
+class Behaviour;
+
+// Replaces the vision/attack trigger colliders: every behaviour re-queries
+// the spatial index on its own staggered timer (or right away when its
+// target is destroyed) and caches only the best candidate.
+class TargetingService
+{
+public:
+
+	TargetingService();
+	~TargetingService();
+
+	void Update();
+
+	// Lowest scored candidate within an attack/vision range, nullptr if none
+	Behaviour* FindBest(const Behaviour* self, vec center, float range, const SpatialFilter& filter);
+
+	unsigned int GetLastQueries() const;
+
+private:
+
+	float Score(const Behaviour* candidate, float distance) const;
+
+private:
+
+	std::vector<Behaviour*> candidates; // reused query buffer
+	unsigned int next_slice = 0u;
+	unsigned int last_queries = 0u;
+};
+
+#endif // __TARGETING_SERVICE_H__
@@ -4,6 +4,8 @@
 #include "Render.h"
 #include "Defs.h"
 #include "Log.h"
+#include "MemoryTracker.h"
+#include "Counters.h"
 
 #include "optick-1.3.0.0/include/optick.h"
 
@@ -15,6 +17,7 @@
 #endif
 
 int TextureData::texture_count = 0;
+static Counter* loaded_count = Counters::Find("textures/loaded", COUNTER_GAUGE);
 
 TextureData::TextureData() :
 	id(++texture_count),
@@ -132,6 +135,7 @@ void TextureManager::CleanUp()
 		it->second.ClearTexture();
 
 	textures.clear();
+	loaded_count->Set(0);
 
 	IMG_Quit();
 }
@@ -140,6 +144,7 @@ void TextureManager::CleanUp()
 int TextureManager::Load(const char* path, bool reload, short r, short g, short b, short a)
 {
 	OPTICK_EVENT();
+	MemoryScope mem(MEM_TEXTURES);
 
 	int ret = -1;
 	if (!reload)
@@ -169,6 +174,7 @@ int TextureManager::Load(const char* path, bool reload, short r, short g, short
 				data.texture = texture;
 				data.reloaded = reload;
 				textures.insert({ ret = data.id, data });
+				loaded_count->Set(textures.size());
 
 				LOG("Loaded surface with path: %s", path);
 			}
@@ -186,6 +192,8 @@ int TextureManager::Load(const char* path, bool reload, short r, short g, short
 
 int TextureManager::LoadSurface(SDL_Surface* surface)
 {
+	MemoryScope mem(MEM_TEXTURES);
+
 	int ret = -1;
 
 	SDL_Texture* tex = SDL_CreateTextureFromSurface(App->render->GetSDLRenderer(), surface);
@@ -197,6 +205,7 @@ int TextureManager::LoadSurface(SDL_Surface* surface)
 		data.source = "From SDL_Surface";
 		data.texture = tex;
 		textures.insert({ ret = data.id, data });
+		loaded_count->Set(textures.size());
 	}
 	else
 		LOG("Unable to create texture from surface! SDL Error: %s\n", SDL_GetError());
@@ -208,7 +217,9 @@ TextureData* TextureManager::CreateEmpty(const char* source)
 {
 	TextureData data;
 	data.source = source;
-	return &textures.insert({ data.id, data }).first->second;
+	TextureData* ret = &textures.insert({ data.id, data }).first->second;
+	loaded_count->Set(textures.size());
+	return ret;
 }
 
 int TextureManager::CreateEmptyTexture(SDL_Renderer* r, int width, int height, const char* source)
@@ -222,6 +233,7 @@ int TextureManager::CreateEmptyTexture(SDL_Renderer* r, int width, int height, c
 		{
 			data.source = source;
 			textures.insert({ ret = data.id, data });
+			loaded_count->Set(textures.size());
 		}
 		else
 			LOG("Unable to SDL_SetTextureBlendMode to SDL_BLENDMODE_BLEND! SDL Error: %s\n", SDL_GetError());
@@ -240,7 +252,10 @@ bool TextureManager::Remove(int id)
 	std::map<int, TextureData>::iterator it = textures.find(id);
 
 	if (ret = (it != textures.end()))
+	{
 		textures.erase(it);
+		loaded_count->Set(textures.size());
+	}
 
 	return ret;
 }
@@ -1,7 +1,8 @@
 #include "TimeManager.h"
 
+#include "FileManager.h"
 #include "Log.h"
-#include "SDL\include\SDL.h"
+#include "SDL/include/SDL.h"
 #include "optick-1.3.0.0/include/optick.h"
 
 TimeManager::TimeManager()
@@ -14,6 +15,35 @@ TimeManager::TimeManager()
 TimeManager::~TimeManager()
 {}
 
+void TimeManager::LoadConfig(bool empty_config)
+{
+	pugi::xml_node config = FileManager::ConfigNode();
+	pugi::xml_node time_config = config.child("time");
+
+	if (empty_config || !time_config)
+	{
+		time_config = config.append_child("time");
+		time_config.append_attribute("fixed_timestep").set_value(fixed_timestep);
+		time_config.append_attribute("tick_rate").set_value(tick_rate);
+		time_config.append_attribute("max_ticks_per_frame").set_value(max_ticks_per_frame);
+	}
+	else
+	{
+		max_ticks_per_frame = time_config.attribute("max_ticks_per_frame").as_uint(max_ticks_per_frame);
+		SetFixedTimestep(
+			time_config.attribute("fixed_timestep").as_bool(fixed_timestep),
+			time_config.attribute("tick_rate").as_float(tick_rate));
+	}
+}
+
+void TimeManager::SaveConfig() const
+{
+	pugi::xml_node time_config = FileManager::ConfigNode().child("time");
+	time_config.attribute("fixed_timestep").set_value(fixed_timestep);
+	time_config.attribute("tick_rate").set_value(tick_rate);
+	time_config.attribute("max_ticks_per_frame").set_value(max_ticks_per_frame);
+}
+
 bool TimeManager::Init()
 {
 	bool ret = (SDL_InitSubSystem(SDL_INIT_TIMER) == 0);
@@ -30,7 +60,7 @@ float TimeManager::UpdateDeltaTime()
 {
 	OPTICK_EVENT();
 
-	dt = ms_timer.ReadF() / 1000.f;
+	dt = lockstep ? fixed_dt : ms_timer.ReadF() / 1000.f;
 	ms_timer.Start();
 
 	game_dt = game_timer.IsPlaying() ? dt : 0.f;
@@ -73,7 +103,7 @@ void TimeManager::SetMaxFPS(float max_fps)
 	if (capped_fps == 0.f)
 		capped_ms = 0u;
 	else
-		capped_ms = unsigned int(1000.f / capped_fps);
+		capped_ms = (unsigned int)(1000.f / capped_fps);
 }
 
 float TimeManager::GetMaxFPS() const { return capped_fps; }
@@ -109,6 +139,67 @@ void TimeManager::StopGameTimer()
 	game_timer.Stop();
 }
 
+void TimeManager::SetFixedTimestep(bool enabled, float rate)
+{
+	fixed_timestep = enabled && rate > 0.f;
+	tick_rate = rate > 0.f ? rate : DEFAULT_TICK_RATE;
+	fixed_dt = 1.f / tick_rate;
+	accumulator = 0.f;
+	interpolation_alpha = 1.f;
+
+	if (max_ticks_per_frame == 0u)
+		max_ticks_per_frame = 1u;
+}
+
+bool TimeManager::IsFixedTimestep() const { return fixed_timestep || lockstep; }
+float TimeManager::GetFixedDeltaTime() const { return fixed_dt; }
+float TimeManager::GetInterpolationAlpha() const { return IsFixedTimestep() ? interpolation_alpha : 1.f; }
+unsigned int TimeManager::GetDroppedTicks() const { return dropped_ticks; }
+
+void TimeManager::SetLockstep(bool enabled)
+{
+	lockstep = enabled;
+	accumulator = 0.f;
+}
+
+bool TimeManager::IsLockstep() const { return lockstep; }
+
+unsigned int TimeManager::BeginSimulation()
+{
+	if (lockstep)
+	{
+		unsigned int ticks = game_dt > 0.f ? 1u : 0u;
+		frame_game_dt = game_dt;
+		game_dt = fixed_dt;
+		return ticks;
+	}
+
+	accumulator += game_dt;
+
+	unsigned int ticks = (unsigned int)(accumulator / fixed_dt);
+
+	if (ticks > max_ticks_per_frame)
+	{
+		// Too far behind: drop the backlog instead of spiraling into longer frames
+		dropped_ticks += ticks - max_ticks_per_frame;
+		ticks = max_ticks_per_frame;
+		accumulator = 0.f;
+	}
+	else
+		accumulator -= float(ticks) * fixed_dt;
+
+	frame_game_dt = game_dt;
+	game_dt = fixed_dt;
+
+	return ticks;
+}
+
+void TimeManager::EndSimulation()
+{
+	game_dt = frame_game_dt;
+	interpolation_alpha = lockstep ? 1.f : accumulator / fixed_dt;
+}
+
 // TIME =======================================================================================
 Timer::Timer(const bool start_active) : paused(!start_active)
 {
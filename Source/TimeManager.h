@@ -3,6 +3,9 @@
 
 #include <list>
 
+#define DEFAULT_TICK_RATE 60.f
+#define DEFAULT_MAX_TICKS_PER_FRAME 5u
+
 class Timer
 {
 public:
@@ -32,6 +35,9 @@ public:
 	TimeManager();
 	~TimeManager();
 
+	void LoadConfig(bool empty_config);
+	void SaveConfig() const;
+
 	bool Init();
 
 	float UpdateDeltaTime(); // returns updated dt
@@ -54,6 +60,19 @@ public:
 	void PauseGameTimer();
 	void StopGameTimer();
 
+	// Fixed timestep simulation
+	void	SetFixedTimestep(bool enabled, float tick_rate = DEFAULT_TICK_RATE);
+	bool	IsFixedTimestep() const;
+	float	GetFixedDeltaTime() const;
+	unsigned int BeginSimulation(); // returns ticks to simulate this frame, game dt is fixed until EndSimulation
+	void	EndSimulation();
+	float	GetInterpolationAlpha() const; // [0,1] between the last two ticks, 1 when not fixed
+	unsigned int GetDroppedTicks() const;
+
+	// Lockstep: every frame advances exactly one fixed tick, whatever the wall clock says
+	void	SetLockstep(bool enabled);
+	bool	IsLockstep() const;
+
 private:
 
 	unsigned long	frames_counter = 0u;
@@ -71,6 +90,17 @@ private:
 	Timer	engine_timer;
 	Timer	game_timer;
 	float	game_dt;
+
+	// Fixed timestep
+	bool	fixed_timestep = true;
+	float	tick_rate = DEFAULT_TICK_RATE;
+	float	fixed_dt = 1.f / DEFAULT_TICK_RATE;
+	unsigned int max_ticks_per_frame = DEFAULT_MAX_TICKS_PER_FRAME; // catch-up cap
+	float	accumulator = 0.f;
+	float	frame_game_dt = 0.f;
+	float	interpolation_alpha = 1.f;
+	unsigned int dropped_ticks = 0u;
+	bool	lockstep = false;
 };
 
 #endif // __TIMEMANAGER_H__
\ No newline at end of file
@@ -46,16 +46,16 @@ void Tower::FreeWalkabilityTiles()
 	App->pathfinding.SetWalkabilityTile(int(pos.x), int(pos.y), true);
 }
 
-void Tower::OnCollision(Collider selfCol, Collider col)
+void Tower::AcquireTargets()
 {
-	if (current_state != DESTROYED
-		&& selfCol.GetColliderTag() == PLAYER_ATTACK_TAG
-		&& col.GetColliderTag() == ENEMY_TAG
-		&& col.parentGo->GetBehaviour()->GetType() != EDGE
-		&& col.parentGo->GetBehaviour()->GetType() != CAPSULE)
-	{
-		objective = col.parentGo->GetBehaviour();
-	}
+	if (current_state != DESTROYED && active)
+		objective = App->targeting.FindBest(this, pos, attack_range, SpatialFilter(UNIT_TYPE_MASK(ENEMY_MELEE) | UNIT_TYPE_MASK(ENEMY_RANGED) | UNIT_TYPE_MASK(ENEMY_SUPER)
+			| UNIT_TYPE_MASK(SPAWNER)));
+}
+
+bool Tower::TargetLost() const
+{
+	return objective != nullptr && objective->IsDestroyed();
 }
 
 void Tower::Update()
@@ -99,7 +99,6 @@ void Tower::Update()
 			App->render->DrawCircle(drawPos, visionRange, { 10, 156, 18, 255 }, FRONT_SCENE, true);//Vision
 			App->render->DrawCircle(drawPos, atkRange, { 255, 0, 0, 255 }, FRONT_SCENE, true);//Attack
 		}
-		objective = nullptr;
 	}
 
 	// Upgrade Tooltip Check
@@ -140,10 +139,8 @@ void Tower::Upgrade()
 
 void Tower::DoAttack()
 {	
-	App->particleSys.AddParticle(pos,objective->GetPos(),15.0f,ENERGY_BALL_PARTICLE);
-	Event::Push(DAMAGE, objective, damage,GetType());
+	App->particleSys.Launch(pos, objective, 15.0f, ENERGY_BALL_PARTICLE, damage, GetType());
 	ms_count = 0;
-	objective = nullptr;
 	audio->Play(attackFX);
 }
 
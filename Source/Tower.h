@@ -18,7 +18,8 @@ public:
 	void create_bar() override;
 	void CreatePanel() override;
 	void FreeWalkabilityTiles() override;
-	void OnCollision(Collider selfCol, Collider col) override;
+	void AcquireTargets() override;
+	bool TargetLost() const override;
 
 public:
 
@@ -5,6 +5,7 @@
 #include "Render.h"
 #include "JuicyMath.h"
 #include "Gameobject.h"
+#include "ByteStream.h"
 #include "Log.h"
 
 #include "optick-1.3.0.0/include/optick.h"
@@ -53,6 +54,21 @@ void Transform::Save(pugi::xml_node& node) const
 	node.append_attribute("sz").set_value(scale.z);
 }
 
+void Transform::Load(ByteReader& in)
+{
+	in.Read(pos);
+	in.Read(scale);
+
+	modified = true;
+	Update();
+}
+
+void Transform::Save(ByteWriter& out) const
+{
+	out.Write(pos);
+	out.Write(scale);
+}
+
 void Transform::Update()
 {
 	OPTICK_EVENT();
@@ -127,9 +143,29 @@ void Transform::SetLocalPos(const vec& p)
 	{
 		pos = p;
 		modified = true;
+		has_snapshot = false; // teleports don't interpolate
 	}
 }
 
+void Transform::StoreRenderSnapshot()
+{
+	previous_pos = GetGlobalPosition();
+	has_snapshot = true;
+}
+
+vec Transform::GetRenderPosition(float alpha) const
+{
+	vec current = GetGlobalPosition();
+
+	if (!has_snapshot || alpha >= 1.f)
+		return current;
+
+	return vec(
+		previous_pos.x + (current.x - previous_pos.x) * alpha,
+		previous_pos.y + (current.y - previous_pos.y) * alpha,
+		previous_pos.z + (current.z - previous_pos.z) * alpha);
+}
+
 void Transform::SetScale(vec s)
 {
 	scale = s;
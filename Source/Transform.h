@@ -12,6 +12,8 @@ public:
 
 	void Load(pugi::xml_node& node) override;
 	void Save(pugi::xml_node& node) const override;
+	void Load(ByteReader& in) override;
+	void Save(ByteWriter& out) const override;
 
 	void Update() override;
 	void PostUpdate() override;
@@ -48,6 +50,10 @@ public:
 	vec GetGlobalPosition() const { return global_parent_pos + pos; }
 	vec GetGlobalScale() const { return global_parent_scale * scale; }
 
+	// Fixed timestep render interpolation
+	void StoreRenderSnapshot();
+	vec GetRenderPosition(float alpha) const;
+
 	bool GlobalPosIsDifferentFrom(vec global_pos) const;
 	void ResetAABB();
 
@@ -65,6 +71,9 @@ private:
 
 	std::pair<int, int> points[8];
 
+	vec previous_pos;
+	bool has_snapshot = false;
+
 	bool modified = false;
 };
 
@@ -3,8 +3,20 @@
 #include "Application.h"
 #include "BarMenu.h"
 #include "Editor.h"
+#include "Log.h"
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
+
+static void OpenURL(const char* url)
+{
+#ifdef _WIN32
+	ShellExecute(0, 0, url, 0, 0, SW_SHOW);
+#else
+	LOG("Open %s", url);
+#endif
+}
 
 UI_SubMenu::UI_SubMenu(const RectF rect) 
 	: UI_Element(window, SUB_MENU, rect)
@@ -61,16 +73,16 @@ void UI_SubMenu::RecieveEvent(const Event& e)
 				switch (Options(id))
 				{
 				case UI_SubMenu::Repo:
-					ShellExecute(0, 0, "https://github.com/PolGannau/Juicy-Code-Games_Project-2/", 0, 0, SW_SHOW);
+					OpenURL("https://github.com/PolGannau/Juicy-Code-Games_Project-2/");
 					break;
 				case UI_SubMenu::Wiki:
-					ShellExecute(0, 0, "https://github.com/PolGannau/Juicy-Code-Games_Project-2/wiki", 0, 0, SW_SHOW);
+					OpenURL("https://github.com/PolGannau/Juicy-Code-Games_Project-2/wiki");
 					break;
 				case UI_SubMenu::Web:
-					ShellExecute(0, 0, "https://polgannau.github.io/Juicy-Code-Games_Project-2/", 0, 0, SW_SHOW);
+					OpenURL("https://polgannau.github.io/Juicy-Code-Games_Project-2/");
 					break;
 				case UI_SubMenu::Release:
-					ShellExecute(0, 0, "https://github.com/PolGannau/Juicy-Code-Games_Project-2/releases", 0, 0, SW_SHOW);
+					OpenURL("https://github.com/PolGannau/Juicy-Code-Games_Project-2/releases");
 					break;
 				}
 				break;
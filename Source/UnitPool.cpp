@@ -0,0 +1,182 @@
+#include "UnitPool.h"
+#include "Application.h"
+#include "Scene.h"
+#include "Gameobject.h"
+#include "Transform.h"
+#include "Behaviour.h"
+#include "Gatherer.h"
+#include "MeleeUnit.h"
+#include "RangedUnit.h"
+#include "SuperUnit.h"
+#include "EnemyMeleeUnit.h"
+#include "EnemyRangedUnit.h"
+#include "EnemySuperUnit.h"
+#include "Log.h"
+
+#include "optick-1.3.0.0/include/optick.h"
+
+#include <algorithm>
+#include <string.h>
+
+UnitPool::UnitPool() : parked(MAX_UNIT_TYPES)
+{}
+
+UnitPool::~UnitPool()
+{}
+
+bool UnitPool::SetMode(const char* mode)
+{
+	bool ret = true;
+
+	if (strcmp(mode, "on") == 0)
+		enabled = true;
+	else if (strcmp(mode, "off") == 0)
+		enabled = false;
+	else
+	{
+		LOG("Unknown unit pool mode %s: use on or off", mode);
+		ret = false;
+	}
+
+	return ret;
+}
+
+void UnitPool::Prewarm()
+{
+	OPTICK_EVENT();
+
+	if (!enabled)
+		return;
+
+	const UnitType enemies[] = { ENEMY_MELEE, ENEMY_RANGED, ENEMY_SUPER };
+	for (int i = 0; i < 3; ++i)
+	{
+		std::vector<B_Unit*>& free = parked[enemies[i]];
+		while (free.size() < UNIT_POOL_PREWARM)
+		{
+			B_Unit* unit = Create(enemies[i], vec());
+			Park(unit);
+			free.push_back(unit);
+		}
+	}
+
+	LOG("Unit pool prewarmed with %d enemy bundles", created);
+}
+
+void UnitPool::Clear()
+{
+	for (std::vector<std::vector<B_Unit*>>::iterator it = parked.begin(); it != parked.end(); ++it)
+		it->clear();
+
+	created = 0u;
+}
+
+B_Unit* UnitPool::Acquire(UnitType type, vec pos)
+{
+	std::vector<B_Unit*>& free = parked[type];
+	if (!enabled || free.empty())
+		return Create(type, pos);
+
+	B_Unit* unit = free.back();
+	free.pop_back();
+
+	Gameobject* go = unit->GetGameobject();
+	go->SetActive();
+	go->GetTransform()->SetLocalPos(pos);
+	unit->Revive();
+
+	return unit;
+}
+
+bool UnitPool::Release(Behaviour* unit)
+{
+	bool ret = false;
+
+	if (enabled && Pooled(unit->GetType()) && unit->IsDestroyed())
+	{
+		std::vector<B_Unit*>& free = parked[unit->GetType()];
+		if (free.size() < UNIT_POOL_CAPACITY)
+		{
+			B_Unit* b_unit = static_cast<B_Unit*>(unit);
+			Park(b_unit);
+			free.push_back(b_unit);
+			ret = true;
+		}
+	}
+
+	return ret;
+}
+
+bool UnitPool::Pooled(UnitType type) const
+{
+	switch (type)
+	{
+	case GATHERER:
+	case UNIT_MELEE:
+	case UNIT_RANGED:
+	case UNIT_SUPER:
+	case ENEMY_MELEE:
+	case ENEMY_RANGED:
+	case ENEMY_SUPER:
+		return true;
+	default:
+		return false;
+	}
+}
+
+unsigned int UnitPool::GetParked(UnitType type) const
+{
+	return parked[type].size();
+}
+
+unsigned int UnitPool::GetCreated() const
+{
+	return created;
+}
+
+B_Unit* UnitPool::Create(UnitType type, vec pos)
+{
+	const char* name = nullptr;
+	switch (type)
+	{
+	case GATHERER: name = "Gatherer"; break;
+	case UNIT_MELEE: name = "Unit melee"; break;
+	case UNIT_RANGED: name = "Ranged unit"; break;
+	case UNIT_SUPER: name = "Super unit"; break;
+	case ENEMY_MELEE: name = "Enemy Melee"; break;
+	case ENEMY_RANGED: name = "Enemy Ranged"; break;
+	case ENEMY_SUPER: name = "Enemy Super"; break;
+	default: return nullptr;
+	}
+
+	// Colliders are placed on construction: position first
+	Gameobject* go = App->scene->AddGameobject(name);
+	go->GetTransform()->SetLocalPos(pos);
+	created++;
+
+	switch (type)
+	{
+	case GATHERER: return new Gatherer(go);
+	case UNIT_MELEE: return new MeleeUnit(go);
+	case UNIT_RANGED: return new RangedUnit(go);
+	case UNIT_SUPER: return new SuperUnit(go);
+	case ENEMY_MELEE: return new EnemyMeleeUnit(go);
+	case ENEMY_RANGED: return new EnemyRangedUnit(go);
+	default: return new EnemySuperUnit(go);
+	}
+}
+
+void UnitPool::Park(B_Unit* unit)
+{
+	Gameobject* go = unit->GetGameobject();
+
+	if (App->scene->selection == go)
+		App->scene->SetSelection(nullptr, false);
+
+	std::vector<Gameobject*>& group = App->scene->group;
+	group.erase(std::remove(group.begin(), group.end(), go), group.end());
+
+	unit->Park();
+	go->SetInactive();
+	go->RenewComponents();
+}
@@ -0,0 +1,60 @@
+#ifndef __UNIT_POOL_H__
+#define __UNIT_POOL_H__
+
+#include "Vector3.h"
+
+#include <vector>
+
+#define UNIT_POOL_PREWARM 24u	// enemy bundles of each type built when a match starts
+#define UNIT_POOL_CAPACITY 128u	// parked bundles kept per type, deaths past it are deleted
+
+class Gameobject;
+class Behaviour;
+class B_Unit;
+enum UnitType : int;
+
+// Mobile units are never deleted mid match: once a dead unit's delay runs
+// out its gameobject, behaviour, sprites, audio source, lifebar & collider
+// are parked inactive, and the next spawn of that type revives them at full
+// health instead of allocating a new bundle. Parked bundles get new
+// component ids and handles, so anything still pointing at the dead unit
+// stops resolving it. Turned off, every spawn builds a new bundle and every
+// death deletes it, as before pooling: benchmarks compare the two.
+class UnitPool
+{
+public:
+
+	UnitPool();
+	~UnitPool();
+
+	bool SetMode(const char* mode); // "on" or "off", false if unknown
+
+	// New match: builds parked enemy bundles ahead of the first wave
+	void Prewarm();
+
+	// Scene reset: parked bundles are deleted with the scene tree
+	void Clear();
+
+	// Parked bundle of that type or a new one, active at pos. Upgrades are up to the caller
+	B_Unit* Acquire(UnitType type, vec pos);
+
+	// Dead unit whose delay ran out: false if it's not pooled and must be deleted
+	bool Release(Behaviour* unit);
+
+	bool Pooled(UnitType type) const;
+	unsigned int GetParked(UnitType type) const;
+	unsigned int GetCreated() const;
+
+private:
+
+	B_Unit* Create(UnitType type, vec pos);
+	void Park(B_Unit* unit);
+
+private:
+
+	bool enabled = true;
+	std::vector<std::vector<B_Unit*>> parked; // per UnitType
+	unsigned int created = 0u; // bundles allocated this match
+};
+
+#endif // __UNIT_POOL_H__
@@ -1,6 +1,8 @@
 #ifndef __VECTOR3_H__
 #define __VECTOR3_H__
 
+#include <math.h>
+
 template<class TYPE>
 class Vector3
 {